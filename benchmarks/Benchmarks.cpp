@@ -1,6 +1,15 @@
 #include "PluginEditor.h"
+#include "delayProcessor.h"
+#include "fdnReverb.h"
+#include "grainKernels.h"
+#include "mixKernels.h"
+#include "parameterRamp.h"
+#include "spectralProcessor.h"
 #include "catch2/benchmark/catch_benchmark_all.hpp"
 #include "catch2/catch_test_macros.hpp"
+#include <juce_dsp/juce_dsp.h>
+#include <iomanip>
+#include <iostream>
 
 TEST_CASE ("Boot performance")
 {
@@ -34,3 +43,685 @@ TEST_CASE ("Boot performance")
         });
     };
 }
+
+//==============================================================================
+// DSP throughput matrix. Each configuration renders noise through processBlock
+// and reports ns per sample frame and the realtime factor. The full set, and the
+// timings of every benchmark after it, is also written as JSON (ECHOES_BENCHMARK_JSON,
+// or dsp_benchmarks.json in the working directory) so runs from two commits can be diffed.
+
+namespace
+{
+    struct DspConfig
+    {
+        bool granular = false;
+        int blockSize = 512;
+        double sampleRate = 48000.0;
+        int numChannels = 2;
+        float grainDensity = 10.0f;
+        float grainSize = 100.0f;
+        bool automateEveryBlock = false;
+
+        juce::String getName() const
+        {
+            juce::String name = granular ? "granular" : "standard";
+            name << " " << blockSize << " @ " << sampleRate / 1000.0 << "k " << (numChannels == 1 ? "mono" : "stereo");
+            if (granular)
+                name << " density " << grainDensity << " size " << grainSize;
+            if (automateEveryBlock)
+                name << " automated";
+            return name;
+        }
+    };
+
+    struct DspResult
+    {
+        DspConfig config;
+        double nsPerSample = 0.0;
+        double realtimeFactor = 0.0;
+    };
+
+    void setParameter (PluginProcessor& plugin, const juce::String& id, float value)
+    {
+        auto* param = plugin.apvts.getParameter (id);
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    // moves every parameter the audio path smooths or reschedules, the worst a host can do
+    void automate (PluginProcessor& plugin, juce::Random& random)
+    {
+        setParameter (plugin, "delaySize", 0.01f + random.nextFloat() * 2.0f);
+        setParameter (plugin, "feedback", random.nextFloat());
+        setParameter (plugin, "wetDry", random.nextFloat());
+        setParameter (plugin, "grainDensity", 1.0f + random.nextFloat() * 49.0f);
+        setParameter (plugin, "grainSize", 10.0f + random.nextFloat() * 490.0f);
+        setParameter (plugin, "grainPitch", 0.25f + random.nextFloat() * 3.75f);
+    }
+
+    // seconds of wall time to render numSamples frames
+    double render (PluginProcessor& plugin, juce::AudioBuffer<float>& input, const DspConfig& config, int numSamples, juce::Random& random)
+    {
+        juce::AudioBuffer<float> buffer (config.numChannels, config.blockSize);
+        juce::MidiBuffer midi;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int position = 0; position < numSamples; position += config.blockSize)
+        {
+            // fresh input every block, otherwise the feedback path settles into a fixed pattern
+            auto inputOffset = position % (input.getNumSamples() - config.blockSize);
+            for (int ch = 0; ch < config.numChannels; ++ch)
+                buffer.copyFrom (ch, 0, input, ch, inputOffset, config.blockSize);
+
+            if (config.automateEveryBlock)
+                automate (plugin, random);
+
+            plugin.processBlock (buffer, midi);
+        }
+
+        return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+    }
+
+    DspResult measure (const DspConfig& config)
+    {
+        PluginProcessor plugin;
+
+        auto channelSet = config.numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channelSet);
+        layout.outputBuses.add (channelSet);
+        plugin.setBusesLayout (layout);
+
+        setParameter (plugin, "granularMode", config.granular ? 1.0f : 0.0f);
+        setParameter (plugin, "grainDensity", config.grainDensity);
+        setParameter (plugin, "grainSize", config.grainSize);
+        setParameter (plugin, "delaySize", 0.5f);
+        plugin.setRateAndBufferSizeDetails (config.sampleRate, config.blockSize);
+        plugin.prepareToPlay (config.sampleRate, config.blockSize);
+
+        juce::Random random (1234);
+        juce::AudioBuffer<float> input (config.numChannels, 65536 + config.blockSize);
+        for (int ch = 0; ch < config.numChannels; ++ch)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                input.setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+        // a quarter second to fill the delay line and the grain pool, then the
+        // median of a few half second runs so one noisy run doesn't count
+        render (plugin, input, config, static_cast<int> (config.sampleRate * 0.25), random);
+
+        const auto numSamples = static_cast<int> (config.sampleRate * 0.5);
+        std::vector<double> times;
+        for (int run = 0; run < 5; ++run)
+            times.push_back (render (plugin, input, config, numSamples, random));
+        std::sort (times.begin(), times.end());
+        auto seconds = times[times.size() / 2];
+
+        // render() processes whole blocks, so count what it actually rendered
+        auto numRendered = ((numSamples + config.blockSize - 1) / config.blockSize) * config.blockSize;
+
+        DspResult result;
+        result.config = config;
+        result.nsPerSample = seconds * 1.0e9 / numRendered;
+        result.realtimeFactor = (numRendered / config.sampleRate) / seconds;
+        return result;
+    }
+
+    std::vector<DspConfig> getDspMatrix()
+    {
+        std::vector<DspConfig> configs;
+
+        // the core matrix, default grain settings
+        for (bool granular : { false, true })
+            for (int blockSize : { 16, 64, 256, 1024, 4096 })
+                for (double sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+                    for (int numChannels : { 1, 2 })
+                    {
+                        DspConfig config;
+                        config.granular = granular;
+                        config.blockSize = blockSize;
+                        config.sampleRate = sampleRate;
+                        config.numChannels = numChannels;
+                        configs.push_back (config);
+                    }
+
+        // grain load, from sparse and short to the densest, longest setting
+        for (float density : { 1.0f, 10.0f, 25.0f, 50.0f })
+            for (float size : { 10.0f, 100.0f, 250.0f, 500.0f })
+            {
+                DspConfig config;
+                config.granular = true;
+                config.grainDensity = density;
+                config.grainSize = size;
+                configs.push_back (config);
+            }
+
+        // worst case automation, every parameter moves every block
+        for (bool granular : { false, true })
+            for (int blockSize : { 16, 64, 256, 1024, 4096 })
+            {
+                DspConfig config;
+                config.granular = granular;
+                config.blockSize = blockSize;
+                config.grainDensity = 50.0f;
+                config.automateEveryBlock = true;
+                configs.push_back (config);
+            }
+
+        return configs;
+    }
+
+    struct TimedResult
+    {
+        juce::String section;
+        juce::String name;
+        double nsPerSample = 0.0;
+    };
+
+    // everything measured so far in this run, the JSON is rewritten with all of it after each test case
+    std::vector<DspResult> dspResults;
+    std::vector<TimedResult> timedResults;
+
+    void printTime (const juce::String& name, double nsPerSample, double realtimeFactor = 0.0)
+    {
+        std::cout << std::left << std::setw (56) << name
+                  << std::right << std::fixed << std::setprecision (2)
+                  << std::setw (10) << nsPerSample << " ns/sample";
+        if (realtimeFactor > 0.0)
+            std::cout << std::setw (10) << std::setprecision (1) << realtimeFactor << "x realtime";
+        std::cout << std::endl;
+    }
+
+    void writeJson()
+    {
+        juce::Array<juce::var> entries;
+        for (auto& result : dspResults)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty ("name", result.config.getName());
+            entry->setProperty ("mode", result.config.granular ? "granular" : "standard");
+            entry->setProperty ("blockSize", result.config.blockSize);
+            entry->setProperty ("sampleRate", result.config.sampleRate);
+            entry->setProperty ("channels", result.config.numChannels);
+            entry->setProperty ("grainDensity", result.config.grainDensity);
+            entry->setProperty ("grainSize", result.config.grainSize);
+            entry->setProperty ("automated", result.config.automateEveryBlock);
+            entry->setProperty ("nsPerSample", result.nsPerSample);
+            entry->setProperty ("realtimeFactor", result.realtimeFactor);
+            entries.add (juce::var (entry));
+        }
+
+        juce::Array<juce::var> timings;
+        for (auto& result : timedResults)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty ("section", result.section);
+            entry->setProperty ("name", result.name);
+            entry->setProperty ("nsPerSample", result.nsPerSample);
+            timings.add (juce::var (entry));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty ("cores", juce::SystemStats::getNumCpus());
+        root->setProperty ("results", entries);
+        root->setProperty ("timings", timings);
+
+        auto path = juce::SystemStats::getEnvironmentVariable ("ECHOES_BENCHMARK_JSON", "dsp_benchmarks.json");
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile (path);
+        file.replaceWithText (juce::JSON::toString (juce::var (root)));
+        std::cout << "wrote " << file.getFullPathName() << std::endl;
+    }
+
+    // one test case's timings: each is printed as it comes in and kept under the
+    // section's name, the JSON is written once the test case is done
+    class benchmarkSection
+    {
+    public:
+        explicit benchmarkSection (const char* sectionName) : sectionName (sectionName) {}
+        ~benchmarkSection() { writeJson(); }
+
+        void record (const juce::String& name, double nsPerSample)
+        {
+            printTime (name, nsPerSample);
+            timedResults.push_back ({ sectionName, name, nsPerSample });
+        }
+
+    private:
+        juce::String sectionName;
+    };
+}
+
+TEST_CASE ("DSP throughput")
+{
+    dspResults.clear();
+
+    for (auto& config : getDspMatrix())
+    {
+        dspResults.push_back (measure (config));
+        auto& result = dspResults.back();
+        printTime (config.getName(), result.nsPerSample, result.realtimeFactor);
+
+        CHECK (result.realtimeFactor > 0.0);
+    }
+
+    writeJson();
+}
+
+//==============================================================================
+// Delay line storage formats. Many instances with long delay lines, rendered one
+// block each in turn the way a host would, so the grains' random reads miss the
+// cache and the 16-bit formats' halved bandwidth shows. The noise floor each
+// format costs is measured in tests/DelayLine.cpp
+
+namespace
+{
+    const char* getStorageName (delayLine::Storage storage)
+    {
+        switch (storage)
+        {
+            case delayLine::Storage::int16:
+                return "int16";
+            case delayLine::Storage::float16:
+                return "float16";
+            case delayLine::Storage::float32:
+            default:
+                return "float32";
+        }
+    }
+
+    // ns per sample frame, per instance
+    double measureStorage (delayLine::Storage storage, bool granular, int numInstances)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 256;
+
+        std::vector<std::unique_ptr<delayProcessor>> instances;
+        for (int i = 0; i < numInstances; ++i)
+        {
+            instances.push_back (std::make_unique<delayProcessor>());
+            instances.back()->setDelayStorage (storage);
+            instances.back()->prepare (sampleRate, 2, blockSize, 10.0f);
+        }
+
+        juce::Random random (99);
+        juce::AudioBuffer<float> input (2, 65536);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                input.setSample (ch, i, random.nextFloat() - 0.5f);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        int inputOffset = 0;
+
+        auto renderBlocks = [&] (int numBlocks) {
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                for (auto& instance : instances)
+                {
+                    inputOffset = (inputOffset + blockSize) % input.getNumSamples();
+                    for (int ch = 0; ch < 2; ++ch)
+                        buffer.copyFrom (ch, 0, input, ch, inputOffset, blockSize);
+
+                    // long delays and grains spread over all of it
+                    instance->process (buffer, 9.0f, 0.5f, 0.5f, 1.0f, 1.0f, sampleRate, granular,
+                        200.0f, 50.0f, 1.5f, 200.0f);
+                }
+            }
+        };
+
+        // fill the delay lines once, then the median of a few runs
+        renderBlocks (static_cast<int> (10.0 * sampleRate / blockSize));
+
+        const int numBlocks = static_cast<int> (0.5 * sampleRate / blockSize);
+        std::vector<double> times;
+        for (int run = 0; run < 5; ++run)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            renderBlocks (numBlocks);
+            times.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+        }
+        std::sort (times.begin(), times.end());
+
+        return times[times.size() / 2] * 1.0e9 / (static_cast<double> (numBlocks) * blockSize * numInstances);
+    }
+}
+
+TEST_CASE ("Delay storage formats")
+{
+    benchmarkSection section ("Delay storage formats");
+    for (bool granular : { false, true })
+        for (int numInstances : { 1, 16 })
+            for (auto storage : { delayLine::Storage::float32, delayLine::Storage::int16, delayLine::Storage::float16 })
+            {
+                auto nsPerSample = measureStorage (storage, granular, numInstances);
+
+                juce::String name = granular ? "granular" : "standard";
+                name << " x" << numInstances << " " << getStorageName (storage);
+                section.record (name, nsPerSample);
+
+                CHECK (nsPerSample > 0.0);
+            }
+}
+
+//==============================================================================
+// Reverb stage against the budget it was written for: two biquads per channel,
+// one stereo block at a time with the same noise
+
+namespace
+{
+    template <typename SampleType = float, typename Process>
+    double measureStage (Process&& process)
+    {
+        constexpr int blockSize = 512;
+
+        juce::Random random (7);
+        juce::AudioBuffer<SampleType> buffer (2, blockSize);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (ch, i, static_cast<SampleType> (random.nextFloat() - 0.5f));
+
+        const int numBlocks = static_cast<int> (10.0 * 48000.0 / blockSize);
+        std::vector<double> times;
+        for (int run = 0; run < 5; ++run)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int block = 0; block < numBlocks; ++block)
+                process (buffer);
+            times.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+        }
+        std::sort (times.begin(), times.end());
+
+        return times[times.size() / 2] * 1.0e9 / (static_cast<double> (numBlocks) * blockSize);
+    }
+}
+
+TEST_CASE ("Reverb stage")
+{
+    benchmarkSection section ("Reverb stage");
+    fdnReverb reverb;
+    reverb.prepare (48000.0, 512);
+    reverb.setParameters (3.0f, 0.5f);
+    auto fdnNs = measureStage ([&] (juce::AudioBuffer<float>& buffer) {
+        reverb.process (buffer.getArrayOfWritePointers(), 2, buffer.getNumSamples(), 0.5f);
+    });
+
+    using Filter = juce::dsp::IIR::Filter<float>;
+    std::array<Filter, 4> filters;
+    for (size_t i = 0; i < filters.size(); ++i)
+        filters[i].coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass (48000.0, i % 2 == 0 ? 8000.0 : 2000.0);
+    auto biquadNs = measureStage ([&] (juce::AudioBuffer<float>& buffer) {
+        juce::dsp::AudioBlock<float> block (buffer);
+        for (size_t ch = 0; ch < 2; ++ch)
+        {
+            juce::dsp::ProcessContextReplacing<float> context (block.getSingleChannelBlock (ch));
+            filters[2 * ch].process (context);
+            filters[2 * ch + 1].process (context);
+        }
+    });
+
+    section.record ("fdn reverb stereo", fdnNs);
+    section.record ("two biquads per channel", biquadNs);
+
+    CHECK (fdnNs > 0.0);
+}
+
+TEST_CASE ("Spectral mode")
+{
+    // small blocks, so a hop spans several of them: with the frame work spread over the
+    // hop the slowest blocks should stay close to the typical one
+    benchmarkSection section ("Spectral mode");
+    constexpr int blockSize = 64;
+    spectralProcessor spectral;
+    spectral.prepare (48000.0, 2, blockSize, 10.0f);
+    spectral.setSmear (0.5f);
+
+    juce::Random random (7);
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    std::vector<double> times;
+    const int numBlocks = static_cast<int> (10.0 * 48000.0 / blockSize);
+    times.reserve (static_cast<size_t> (numBlocks));
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (ch, i, random.nextFloat() - 0.5f);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        spectral.process (buffer, 0.5f, 0.5f, 0.5f);
+        times.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+    }
+
+    std::sort (times.begin(), times.end());
+    auto toNsPerSample = [] (double seconds) { return seconds * 1.0e9 / blockSize; };
+    section.record ("spectral stereo, median block", toNsPerSample (times[times.size() / 2]));
+    section.record ("spectral stereo, 99th percentile block", toNsPerSample (times[times.size() * 99 / 100]));
+
+    CHECK (times.back() > 0.0);
+}
+
+TEST_CASE ("Sample precision")
+{
+    // the same engine on float and double blocks. double also keeps the line and the
+    // shaper in double, the grains and reverb mix into it from float
+    benchmarkSection section ("Sample precision");
+    for (bool granular : { false, true })
+    {
+        auto measure = [granular] (auto sample) {
+            using SampleType = decltype (sample);
+            constexpr bool wide = std::is_same_v<SampleType, double>;
+            delayProcessor delay;
+            delay.setDoublePrecision (wide);
+            delay.setDelayStorage (wide ? delayLine::Storage::float64 : delayLine::Storage::float32);
+            delay.setFeedbackShape (100.0f, 8000.0f, 0.5f);
+            delay.prepare (48000.0, 2, 512, 10.0f);
+            return measureStage<SampleType> ([&] (juce::AudioBuffer<SampleType>& buffer) {
+                delay.process (buffer, 0.3f, 0.6f, 0.5f, 1.0f, 1.0f, 48000.0, granular, 100.0f, 20.0f, 1.0f, 50.0f);
+            });
+        };
+
+        for (auto [precision, nsPerSample] : { std::pair { "float", measure (0.0f) }, std::pair { "double", measure (0.0) } })
+        {
+            juce::String name = granular ? "granular" : "standard";
+            name << " " << precision;
+            section.record (name, nsPerSample);
+
+            CHECK (nsPerSample > 0.0);
+        }
+    }
+}
+
+//==============================================================================
+// Block specializations: each kernel the engine picks once per block against the
+// generic one on the same stereo block, so every special case shows its own gain
+
+namespace
+{
+    template <typename Render>
+    double measureKernel (Render&& render, int blockSize)
+    {
+        constexpr int numBlocks = 20000;
+        std::vector<double> times;
+        for (int run = 0; run < 5; ++run)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int block = 0; block < numBlocks; ++block)
+                render();
+            times.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+        }
+        std::sort (times.begin(), times.end());
+
+        return times[times.size() / 2] * 1.0e9 / (static_cast<double> (numBlocks) * blockSize);
+    }
+
+    void recordKernelTimes (benchmarkSection& section, const char* name, double genericNs, double specializedNs)
+    {
+        section.record (juce::String (name) + ", generic", genericNs);
+        section.record (juce::String (name) + ", specialized", specializedNs);
+    }
+}
+
+TEST_CASE ("Block specializations")
+{
+    benchmarkSection section ("Block specializations");
+    constexpr int blockSize = 512;
+    juce::Random random (7);
+    juce::AudioBuffer<float> wet (2, blockSize);
+    juce::AudioBuffer<float> output (2, blockSize);
+    juce::AudioBuffer<float> written (2, blockSize);
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < blockSize; ++i)
+        {
+            wet.setSample (ch, i, random.nextFloat() - 0.5f);
+            output.setSample (ch, i, random.nextFloat() - 0.5f);
+        }
+
+    struct mixCase
+    {
+        const char* name;
+        float gainEnd;
+        float wetDry;
+        float feedback;
+        int numChannels;
+    };
+
+    // each case differs from a ramped, blended, fed back stereo block in one property
+    for (auto [name, gainEnd, wetDry, feedback, numChannels] : { mixCase { "mix, flat gain", 1.0f, 0.5f, 0.5f, 2 },
+             mixCase { "mix, fully wet", 0.5f, 1.0f, 0.5f, 2 },
+             mixCase { "mix, fully dry", 0.5f, 0.0f, 0.5f, 2 },
+             mixCase { "mix, no feedback", 0.5f, 0.5f, 0.0f, 2 },
+             mixCase { "mix, mono", 0.5f, 0.5f, 0.5f, 1 },
+             mixCase { "mix, stereo", 0.5f, 0.5f, 0.5f, 2 } })
+    {
+        mixRun<float, float> run { output.getArrayOfWritePointers(), 0, wet.getArrayOfReadPointers(),
+            wet.getArrayOfReadPointers(), written.getArrayOfWritePointers(), numChannels, blockSize,
+            1.0f, (gainEnd - 1.0f) / static_cast<float> (blockSize), 0, wetDry, feedback };
+
+        auto measureShape = [&run, numChannels = numChannels] (const mixKernels::shape& blockShape) {
+            auto kernel = mixKernels::getKernel<float, float> (blockShape);
+            return measureKernel ([&] { kernel (run); }, blockSize * numChannels);
+        };
+
+        auto genericNs = measureShape (mixKernels::shape::generic());
+        auto specializedNs = measureShape (mixKernels::shape::of (1.0f, gainEnd, wetDry, feedback, numChannels));
+        recordKernelTimes (section, name, genericNs, specializedNs);
+        CHECK (specializedNs > 0.0);
+    }
+
+    // a grain at pitch 1 against one a hair off a whole sample, which has to interpolate
+    std::vector<float> source (blockSize + 4);
+    std::vector<float> envelope (blockSize, 0.5f);
+    for (auto& sample : source)
+        sample = random.nextFloat() - 0.5f;
+
+    auto measureGrain = [&] (float readOffset) {
+        grainSpan span { source.data(), envelope.data(), output.getWritePointer (0), readOffset, 1.0f, 0.5f, blockSize };
+        auto kernel = grainKernels::getBestKernel();
+        return measureKernel ([&] { kernel (span); }, blockSize);
+    };
+
+    auto interpolatedNs = measureGrain (0.001f);
+    auto unityNs = measureGrain (0.0f);
+    recordKernelTimes (section, "grain, unity pitch", interpolatedNs, unityNs);
+    CHECK (unityNs > 0.0);
+}
+
+//==============================================================================
+// Large host blocks, the way offline bounces send them, worked through whole against
+// the sub-block sizes around the default
+
+TEST_CASE ("Sub-block size")
+{
+    benchmarkSection section ("Sub-block size");
+    constexpr int hostBlockSize = 8192;
+
+    for (bool granular : { false, true })
+        for (int subBlockSize : { 0, 32, 64, 128, 256 })
+        {
+            delayProcessor delay;
+            delay.setSubBlockSize (subBlockSize);
+            delay.setFeedbackShape (100.0f, 8000.0f, 0.5f);
+            delay.setReverb (fdnReverb::Position::feedbackLoop, 0.3f, 3.0f, 0.5f);
+            delay.prepare (48000.0, 2, hostBlockSize, 10.0f);
+
+            juce::Random random (7);
+            juce::AudioBuffer<float> buffer (2, hostBlockSize);
+            const int numBlocks = static_cast<int> (10.0 * 48000.0 / hostBlockSize);
+            std::vector<double> times;
+            for (int run = 0; run < 5; ++run)
+            {
+                auto start = juce::Time::getHighResolutionTicks();
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    for (int ch = 0; ch < 2; ++ch)
+                        for (int i = 0; i < hostBlockSize; ++i)
+                            buffer.setSample (ch, i, random.nextFloat() - 0.5f);
+                    delay.process (buffer, 0.3f, 0.6f, 0.5f, 1.0f, 0.8f, 48000.0, granular, 100.0f, 20.0f, 1.0f, 50.0f);
+                }
+                times.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+            }
+            std::sort (times.begin(), times.end());
+            auto nsPerSample = times[times.size() / 2] * 1.0e9 / (static_cast<double> (numBlocks) * hostBlockSize);
+
+            // the granular path runs longer sub-blocks than the one set
+            auto frames = granular ? subBlockSize * delayProcessor::granularSubBlockFactor : subBlockSize;
+            juce::String name = granular ? "granular" : "standard";
+            name << ", 8192 sample blocks, " << (frames > 0 ? juce::String (frames) + " sample sub-blocks" : juce::String ("whole"));
+            section.record (name, nsPerSample);
+
+            CHECK (nsPerSample > 0.0);
+        }
+}
+
+//==============================================================================
+// Parameter smoothing: a block of a gliding value from juce's per sample smoother
+// against the block-wise ramp, and the mix while feedback and wetDry glide against
+// the kernel picked once they've settled
+
+TEST_CASE ("Parameter smoothing")
+{
+    benchmarkSection section ("Parameter smoothing");
+    constexpr int blockSize = 512;
+    std::vector<float> values (blockSize);
+
+    // the target flips every block, so both are always mid glide
+    juce::SmoothedValue<float> smoothed;
+    smoothed.reset (48000.0, delayProcessor::mixGlideSeconds);
+    int juceFlips = 0;
+    auto juceNs = measureKernel ([&] {
+        smoothed.setTargetValue ((++juceFlips & 1) != 0 ? 1.0f : 0.0f);
+        for (auto& value : values)
+            value = smoothed.getNextValue();
+    }, blockSize);
+
+    parameterRamp ramp;
+    ramp.reset (48000.0, delayProcessor::mixGlideSeconds);
+    int rampFlips = 0;
+    auto rampNs = measureKernel ([&] {
+        ramp.setTargetValue ((++rampFlips & 1) != 0 ? 1.0f : 0.0f);
+        ramp.fill (values.data(), blockSize);
+    }, blockSize);
+
+    section.record ("glide, juce::SmoothedValue", juceNs);
+    section.record ("glide, parameterRamp", rampNs);
+    CHECK (rampNs > 0.0);
+
+    juce::Random random (7);
+    juce::AudioBuffer<float> wet (2, blockSize), output (2, blockSize), written (2, blockSize);
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < blockSize; ++i)
+        {
+            wet.setSample (ch, i, random.nextFloat() - 0.5f);
+            output.setSample (ch, i, random.nextFloat() - 0.5f);
+        }
+    std::vector<float> wetDryRamp (blockSize, 0.5f), feedbackRamp (blockSize, 0.5f);
+    mixRun<float, float> run { output.getArrayOfWritePointers(), 0, wet.getArrayOfReadPointers(),
+        wet.getArrayOfReadPointers(), written.getArrayOfWritePointers(), 2, blockSize,
+        1.0f, 0.0f, 0, 0.5f, 0.5f, wetDryRamp.data(), feedbackRamp.data() };
+
+    auto measureShape = [&run] (const mixKernels::shape& blockShape) {
+        auto kernel = mixKernels::getKernel<float, float> (blockShape);
+        return measureKernel ([&] { kernel (run); }, blockSize * 2);
+    };
+    section.record ("mix, gliding", measureShape (mixKernels::shape::smoothedRamps()));
+    section.record ("mix, settled", measureShape (mixKernels::shape::of (1.0f, 1.0f, 0.5f, 0.5f, 2)));
+}
@@ -0,0 +1,123 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+// echoes-render: runs wav/aiff/flac files through the plugin offline
+//
+//   echoes-render [--settings render.json] [--out dir] [--jobs n] input...
+//
+// each worker thread owns its own processor, files are handed out as workers free up
+
+#include "renderSettings.h"
+#include "renderWorker.h"
+#include <iostream>
+
+// ConsoleApplication::fail throws, main() turns it into a message and exit code
+[[noreturn]] static void fail(const juce::String& message)
+{
+    juce::ConsoleApplication::fail("echoes-render: " + message);
+}
+
+static int render(juce::ArgumentList arguments)
+{
+    if (arguments.size() == 0 || arguments.containsOption("--help|-h"))
+    {
+        std::cout << "usage: echoes-render [--settings render.json] [--out dir] [--jobs n] input..." << std::endl;
+        return 0;
+    }
+
+    renderSettings settings;
+    {
+        PluginProcessor reference;
+        if (arguments.containsOption("--settings|-s"))
+        {
+            auto settingsFile = arguments.getExistingFileForOptionAndRemove("--settings|-s");
+            auto result = settings.loadFromFile(settingsFile, reference);
+            if (result.failed())
+            {
+                fail(result.getErrorMessage());
+            }
+        }
+    }
+
+    juce::File outputDirectory;
+    if (arguments.containsOption("--out|-o"))
+    {
+        outputDirectory = arguments.getFileForOptionAndRemove("--out|-o");
+        if (!outputDirectory.createDirectory())
+        {
+            fail("can't create " + outputDirectory.getFullPathName());
+        }
+    }
+
+    int numWorkers = juce::SystemStats::getNumCpus();
+    if (arguments.containsOption("--jobs|-j"))
+    {
+        numWorkers = juce::jmax(1, arguments.removeValueForOption("--jobs|-j").getIntValue());
+    }
+
+    std::vector<renderJob> jobs;
+    for (auto& argument : arguments.arguments)
+    {
+        if (argument.isOption())
+        {
+            fail("unknown option " + argument.text);
+        }
+
+        renderJob job;
+        job.input = argument.resolveAsExistingFile();
+        auto outputName = job.input.getFileNameWithoutExtension() + "_echoes.wav";
+        job.output = outputDirectory == juce::File() ? job.input.getSiblingFile(outputName)
+                                                     : outputDirectory.getChildFile(outputName);
+        jobs.push_back(job);
+    }
+
+    if (jobs.empty())
+    {
+        fail("no input files");
+    }
+
+    // processors are built here on the message thread, the workers only render
+    std::atomic<int> nextJob { 0 };
+    std::vector<std::unique_ptr<renderWorker>> workers;
+    numWorkers = juce::jmin(numWorkers, static_cast<int>(jobs.size()));
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back(std::make_unique<renderWorker>(std::make_unique<PluginProcessor>(), settings, jobs, nextJob));
+        workers.back()->startThread();
+    }
+
+    for (auto& worker : workers)
+    {
+        worker->waitForThreadToExit(-1);
+    }
+
+    auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    double audioSeconds = 0.0;
+    int numFailed = 0;
+    for (auto& job : jobs)
+    {
+        audioSeconds += job.audioSeconds;
+        numFailed += job.result.failed() ? 1 : 0;
+    }
+
+    std::cout << jobs.size() - static_cast<size_t>(numFailed) << " of " << jobs.size() << " files, "
+              << juce::String(audioSeconds, 1) << " s of audio in " << juce::String(wallSeconds, 2) << " s with "
+              << numWorkers << " workers, " << juce::String(wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0, 1)
+              << "x realtime overall" << std::endl;
+
+    return numFailed == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    // the processor's parameter tree expects a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList arguments(argc, argv);
+    return juce::ConsoleApplication::invokeCatchingFailures([&] { return render(arguments); });
+}
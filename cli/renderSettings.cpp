@@ -0,0 +1,150 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "renderSettings.h"
+
+// numbers and bools are in the parameter's units, strings go through its text conversion
+static juce::Result toNormalised(const juce::RangedAudioParameter& parameter, const juce::var& value, float& result)
+{
+    if (value.isString())
+    {
+        result = parameter.getValueForText(value.toString());
+        return juce::Result::ok();
+    }
+    if (value.isBool() || value.isInt() || value.isInt64() || value.isDouble())
+    {
+        result = parameter.convertTo0to1(static_cast<float>(value));
+        return juce::Result::ok();
+    }
+    return juce::Result::fail("bad value for " + parameter.getParameterID());
+}
+
+juce::Result renderSettings::loadFromFile(const juce::File& file, const PluginProcessor& reference)
+{
+    juce::var json;
+    auto parseResult = juce::JSON::parse(file.loadFileAsString(), json);
+    if (parseResult.failed())
+    {
+        return juce::Result::fail(file.getFileName() + ": " + parseResult.getErrorMessage());
+    }
+    if (!json.isObject())
+    {
+        return juce::Result::fail(file.getFileName() + ": expected a json object");
+    }
+
+    blockSize = juce::jlimit(16, 1 << 16, static_cast<int>(json.getProperty("blockSize", blockSize)));
+    automationInterval = juce::jlimit(1, blockSize, static_cast<int>(json.getProperty("automationInterval", automationInterval)));
+    tailSeconds = static_cast<double>(json.getProperty("tailSeconds", tailSeconds));
+    bitsPerSample = static_cast<int>(json.getProperty("bitsPerSample", bitsPerSample));
+    if (bitsPerSample != 16 && bitsPerSample != 24 && bitsPerSample != 32)
+    {
+        return juce::Result::fail("bitsPerSample must be 16, 24 or 32");
+    }
+
+    if (auto* parameters = json.getProperty("parameters", {}).getDynamicObject())
+    {
+        for (auto& property : parameters->getProperties())
+        {
+            auto id = property.name.toString();
+            auto* parameter = reference.apvts.getParameter(id);
+            if (parameter == nullptr)
+            {
+                return juce::Result::fail("unknown parameter " + id);
+            }
+
+            float value = 0.0f;
+            auto result = toNormalised(*parameter, property.value, value);
+            if (result.failed())
+            {
+                return result;
+            }
+            fixedValues.emplace_back(id, value);
+        }
+    }
+
+    if (auto* automation = json.getProperty("automation", {}).getDynamicObject())
+    {
+        for (auto& property : automation->getProperties())
+        {
+            auto id = property.name.toString();
+            auto* parameter = reference.apvts.getParameter(id);
+            auto* points = property.value.getArray();
+            if (parameter == nullptr || points == nullptr || points->isEmpty())
+            {
+                return juce::Result::fail("automation for " + id + " needs a known parameter and [[seconds, value], ...]");
+            }
+
+            automationLane lane;
+            lane.parameterID = id;
+
+            for (auto& point : *points)
+            {
+                if (!point.isArray() || point.size() != 2)
+                {
+                    return juce::Result::fail("automation points for " + id + " must be [seconds, value]");
+                }
+
+                float value = 0.0f;
+                auto result = toNormalised(*parameter, point[1], value);
+                if (result.failed())
+                {
+                    return result;
+                }
+                lane.points.push_back({ static_cast<double>(point[0]), value });
+            }
+
+            std::stable_sort(lane.points.begin(), lane.points.end(),
+                [](const automationPoint& a, const automationPoint& b) { return a.timeSeconds < b.timeSeconds; });
+            lanes.push_back(std::move(lane));
+        }
+    }
+
+    return juce::Result::ok();
+}
+
+void renderSettings::applyParameters(PluginProcessor& plugin, double timeSeconds) const
+{
+    for (auto& [id, value] : fixedValues)
+    {
+        setNormalised(plugin, id, value);
+    }
+    applyAutomation(plugin, timeSeconds);
+}
+
+void renderSettings::applyAutomation(PluginProcessor& plugin, double timeSeconds) const
+{
+    for (auto& lane : lanes)
+    {
+        setNormalised(plugin, lane.parameterID, lane.getValueAt(timeSeconds));
+    }
+}
+
+void renderSettings::setNormalised(PluginProcessor& plugin, const juce::String& parameterID, float value)
+{
+    if (auto* parameter = plugin.apvts.getParameter(parameterID))
+    {
+        parameter->setValueNotifyingHost(value);
+    }
+}
+
+float renderSettings::automationLane::getValueAt(double timeSeconds) const
+{
+    if (timeSeconds <= points.front().timeSeconds)
+    {
+        return points.front().value;
+    }
+
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+        auto& next = points[i];
+        if (timeSeconds < next.timeSeconds)
+        {
+            auto& previous = points[i - 1];
+            auto amount = (timeSeconds - previous.timeSeconds) / (next.timeSeconds - previous.timeSeconds);
+            return previous.value + static_cast<float>(amount) * (next.value - previous.value);
+        }
+    }
+
+    return points.back().value;
+}
@@ -0,0 +1,72 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <PluginProcessor.h>
+#include <vector>
+
+#ifndef RENDERSETTINGS_H
+#define RENDERSETTINGS_H
+
+// parameter values and automation for a batch render, loaded from json:
+//
+// {
+//     "blockSize": 8192,
+//     "automationInterval": 256,
+//     "tailSeconds": 4.0,
+//     "bitsPerSample": 24,
+//     "parameters": { "granularMode": true, "grainDensity": 30, "grainShape": "Gaussian" },
+//     "automation": { "delaySize": [[0.0, 0.25], [12.5, 1.0]] }
+// }
+//
+// values are in the parameter's own units (or its text, for choices).
+// automation points are [seconds, value] pairs, linearly interpolated and
+// held flat before the first and after the last point
+class renderSettings {
+public:
+    juce::Result loadFromFile(const juce::File& file, const PluginProcessor& reference);
+
+    // sets the fixed values and the automation at timeSeconds
+    void applyParameters(PluginProcessor& plugin, double timeSeconds) const;
+    void applyAutomation(PluginProcessor& plugin, double timeSeconds) const;
+    bool hasAutomation() const { return !lanes.empty(); }
+
+    // samples per read/processBlock call, what the processor is prepared with
+    int blockSize { 8192 };
+
+    // automated renders call processBlock every this many samples so the curves stay smooth
+    int automationInterval { 256 };
+
+    // negative means use the processor's getTailLengthSeconds()
+    double tailSeconds { -1.0 };
+
+    // the processor's tail is cut here when it never ends (feedback at the top,
+    // a frozen spectrum). a tailSeconds of any length is rendered as asked
+    static constexpr double maxTailSeconds = 30.0;
+
+    int bitsPerSample { 24 };
+
+private:
+    struct automationPoint
+    {
+        double timeSeconds;
+        float value;
+    };
+
+    struct automationLane
+    {
+        juce::String parameterID;
+        std::vector<automationPoint> points;
+
+        float getValueAt(double timeSeconds) const;
+    };
+
+    // normalised 0..1, converted once at load
+    std::vector<std::pair<juce::String, float>> fixedValues;
+    std::vector<automationLane> lanes;
+
+    static void setNormalised(PluginProcessor& plugin, const juce::String& parameterID, float value);
+};
+
+#endif //RENDERSETTINGS_H
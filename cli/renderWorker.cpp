@@ -0,0 +1,165 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "renderWorker.h"
+#include <cmath>
+#include <iostream>
+
+renderWorker::renderWorker(std::unique_ptr<PluginProcessor> plugin, const renderSettings& settings,
+    std::vector<renderJob>& jobs, std::atomic<int>& nextJob)
+    : juce::Thread("render worker"), plugin(std::move(plugin)), settings(settings), jobs(jobs), nextJob(nextJob)
+{
+    formatManager.registerBasicFormats();
+}
+
+void renderWorker::run()
+{
+    while (!threadShouldExit())
+    {
+        auto index = nextJob.fetch_add(1);
+        if (index >= static_cast<int>(jobs.size()))
+        {
+            return;
+        }
+
+        auto& job = jobs[static_cast<size_t>(index)];
+        job.result = render(job);
+        report(job);
+    }
+}
+
+juce::Result renderWorker::render(renderJob& job)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(job.input));
+    if (reader == nullptr)
+    {
+        return juce::Result::fail("can't read " + job.input.getFullPathName());
+    }
+
+    auto numChannels = static_cast<int>(reader->numChannels);
+    if (numChannels < 1 || numChannels > 2)
+    {
+        return juce::Result::fail("only mono and stereo files are supported");
+    }
+
+    // same layout in and out, the processor supports mono and stereo
+    auto channelSet = numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+    if (!plugin->setBusesLayout(layout))
+    {
+        return juce::Result::fail("processor rejected the channel layout");
+    }
+
+    auto sampleRate = reader->sampleRate;
+    int blockSize = settings.blockSize;
+
+    // parameters first so the tail length reflects them
+    settings.applyParameters(*plugin, 0.0);
+    // offline, so the cpu governor never trades quality for speed
+    plugin->setNonRealtime(true);
+    plugin->setRateAndBufferSizeDetails(sampleRate, blockSize);
+    plugin->prepareToPlay(sampleRate, blockSize);
+
+    auto tailSeconds = settings.tailSeconds;
+    if (tailSeconds < 0.0)
+    {
+        // infinite while the feedback holds forever or the spectrum is frozen
+        tailSeconds = plugin->getTailLengthSeconds();
+        if (!(tailSeconds <= renderSettings::maxTailSeconds))
+        {
+            job.note = "the tail doesn't die out, cut at " + juce::String(renderSettings::maxTailSeconds, 0)
+                       + " s (set tailSeconds for another length)";
+            tailSeconds = renderSettings::maxTailSeconds;
+        }
+    }
+    auto tailSamples = static_cast<juce::int64>(std::ceil(tailSeconds * sampleRate));
+    auto outputSamples = reader->lengthInSamples + tailSamples;
+
+    // spectral mode delays everything by its frame, run on that much further and
+    // leave the start off so the file lines up with its input
+    auto latencySamples = static_cast<juce::int64>(plugin->getLatencySamples());
+    auto totalSamples = outputSamples + latencySamples;
+
+    job.output.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(job.output.createOutputStream());
+    if (stream == nullptr)
+    {
+        return juce::Result::fail("can't write " + job.output.getFullPathName());
+    }
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+        static_cast<unsigned int>(numChannels), settings.bitsPerSample, {}, 0));
+    if (writer == nullptr)
+    {
+        return juce::Result::fail("can't create a wav writer for " + job.output.getFullPathName());
+    }
+    stream.release(); // the writer owns it now
+
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (juce::int64 position = 0; position < totalSamples; position += blockSize)
+    {
+        auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockSize), totalSamples - position));
+        buffer.setSize(numChannels, numSamples, false, false, true);
+
+        // past the end of the file the reader fills with silence, which renders the tail
+        reader->read(&buffer, 0, numSamples, position, true, true);
+
+        if (settings.hasAutomation())
+        {
+            for (int offset = 0; offset < numSamples; offset += settings.automationInterval)
+            {
+                settings.applyAutomation(*plugin, static_cast<double>(position + offset) / sampleRate);
+
+                juce::AudioBuffer<float> chunk(buffer.getArrayOfWritePointers(), numChannels, offset,
+                    juce::jmin(settings.automationInterval, numSamples - offset));
+                plugin->processBlock(chunk, midi);
+            }
+        }
+        else
+        {
+            plugin->processBlock(buffer, midi);
+        }
+
+        auto skip = static_cast<int>(juce::jlimit(juce::int64 { 0 }, static_cast<juce::int64>(numSamples),
+            latencySamples - position));
+        if (skip < numSamples)
+        {
+            writer->writeFromAudioSampleBuffer(buffer, skip, numSamples - skip);
+        }
+    }
+
+    writer.reset();
+    plugin->releaseResources();
+
+    job.audioSeconds = static_cast<double>(outputSamples) / sampleRate;
+    job.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    return juce::Result::ok();
+}
+
+void renderWorker::report(const renderJob& job)
+{
+    // workers finish in any order, keep their lines whole
+    static std::mutex outputLock;
+    std::lock_guard<std::mutex> lock(outputLock);
+
+    if (job.result.failed())
+    {
+        std::cerr << job.input.getFileName() << ": " << job.result.getErrorMessage() << std::endl;
+        return;
+    }
+
+    std::cout << job.input.getFileName() << " -> " << job.output.getFullPathName()
+              << "  " << juce::String(job.audioSeconds, 2) << " s in " << juce::String(job.renderSeconds, 2)
+              << " s, " << juce::String(job.getRealtimeFactor(), 1) << "x realtime" << std::endl;
+    if (job.note.isNotEmpty())
+    {
+        std::cout << "  " << job.note << std::endl;
+    }
+}
@@ -0,0 +1,48 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "renderSettings.h"
+#include <PluginProcessor.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#ifndef RENDERWORKER_H
+#define RENDERWORKER_H
+
+// one input file and what happened to it
+struct renderJob
+{
+    juce::File input;
+    juce::File output;
+
+    juce::Result result { juce::Result::ok() };
+    juce::String note;
+    double audioSeconds { 0.0 };
+    double renderSeconds { 0.0 };
+
+    double getRealtimeFactor() const { return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0; }
+};
+
+// owns one processor and keeps taking jobs off the shared list until it's empty.
+// the processor is created by the caller on the message thread and handed over
+class renderWorker : public juce::Thread {
+public:
+    renderWorker(std::unique_ptr<PluginProcessor> plugin, const renderSettings& settings,
+        std::vector<renderJob>& jobs, std::atomic<int>& nextJob);
+
+    void run() override;
+
+private:
+    std::unique_ptr<PluginProcessor> plugin;
+    const renderSettings& settings;
+    std::vector<renderJob>& jobs;
+    std::atomic<int>& nextJob;
+
+    juce::AudioFormatManager formatManager;
+
+    juce::Result render(renderJob& job);
+    static void report(const renderJob& job);
+};
+
+#endif //RENDERWORKER_H
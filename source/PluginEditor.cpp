@@ -1,7 +1,7 @@
 #include "PluginEditor.h"
 
 PluginEditor::PluginEditor (PluginProcessor& p)
-    : AudioProcessorEditor (&p), processorRef (p)
+    : AudioProcessorEditor (&p), processorRef (p), visualizer (p.getVisualFeed(), *p.delaySizeParam)
 {
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
 
@@ -36,8 +36,16 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     setupSlider(grainDensitySlider);
     setupSlider(grainPitchSlider);
     setupSlider(grainSpreadSlider);
+    setupSlider(grainTaperSlider);
     setupToggle(granularModeToggle, "Granular Mode");
 
+    // the combo box items have to exist before the attachment is made
+    if (auto* shapeParam = dynamic_cast<juce::AudioParameterChoice*>(params.getParameter("grainShape")))
+    {
+        grainShapeBox.addItemList(shapeParam->choices, 1);
+    }
+    addAndMakeVisible(&grainShapeBox);
+
 
     delaySliderAttach = std::make_unique<SliderAttachment>(params, "delaySize", delaySlider);
     feedbackSliderAttach = std::make_unique<SliderAttachment>(params, "feedback", feedbackSlider);
@@ -51,6 +59,8 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     grainDensitySliderAttach = std::make_unique<SliderAttachment>(params, "grainDensity", grainDensitySlider);
     grainPitchSliderAttach = std::make_unique<SliderAttachment>(params, "grainPitch", grainPitchSlider);
     grainSpreadSliderAttach = std::make_unique<SliderAttachment>(params, "grainSpread", grainSpreadSlider);
+    grainTaperSliderAttach = std::make_unique<SliderAttachment>(params, "grainTaper", grainTaperSlider);
+    grainShapeAttach = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(params, "grainShape", grainShapeBox);
 
     setupLabel(delayLabel, "delay");
     setupLabel(feedbackLabel, "feedback");
@@ -63,20 +73,30 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     setupLabel(grainDensityLabel, "Density (Hz)");
     setupLabel(grainPitchLabel, "Pitch");
     setupLabel(grainSpreadLabel, "Spread (ms)");
+    setupLabel(grainShapeLabel, "Shape");
+    setupLabel(grainTaperLabel, "Taper");
 
     granularModeToggle.onStateChange = [this]() { granularModeChanged(); };
 
     // set granular control visibility
     granularModeChanged();
 
+    addAndMakeVisible(&visualizer);
+
+    telemetryLabel.setFont(12.0f);
+    telemetryLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+    addAndMakeVisible(&telemetryLabel);
+    startTimerHz(4);
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (600, 400);
+    setSize (600, 480);
     setResizable (true, true);
 }
 
 PluginEditor::~PluginEditor()
 {
+    stopTimer();
 }
 
 void PluginEditor::paint (juce::Graphics& g)
@@ -98,6 +118,23 @@ void PluginEditor::paint (juce::Graphics& g)
     }
 }
 
+void PluginEditor::timerCallback()
+{
+    telemetryFrame frame;
+    if (!processorRef.getTelemetry().getLatest(frame))
+    {
+        return;
+    }
+
+    auto text = juce::String::formatted("cpu %d%%  grains %u  governor %d",
+        juce::roundToInt(frame.load * 100.0f), frame.activeGrains, frame.governorLevel);
+    if ((frame.flags & telemetryFlags::nonFinite) != 0)
+    {
+        text << "  nan/inf!";
+    }
+    telemetryLabel.setText(text, juce::dontSendNotification);
+}
+
 void PluginEditor::granularModeChanged()
 {
     bool granularMode = granularModeToggle.getToggleState();
@@ -107,11 +144,15 @@ void PluginEditor::granularModeChanged()
     grainDensitySlider.setVisible(granularMode);
     grainPitchSlider.setVisible(granularMode);
     grainSpreadSlider.setVisible(granularMode);
+    grainShapeBox.setVisible(granularMode);
+    grainTaperSlider.setVisible(granularMode);
 
     grainSizeLabel.setVisible(granularMode);
     grainDensityLabel.setVisible(granularMode);
     grainPitchLabel.setVisible(granularMode);
     grainSpreadLabel.setVisible(granularMode);
+    grainShapeLabel.setVisible(granularMode);
+    grainTaperLabel.setVisible(granularMode);
 
     repaint();
 }
@@ -150,17 +191,25 @@ void PluginEditor::resized()
     auto granularRow = granularSection.removeFromTop(80);
     auto granularLabelRow = granularSection;
 
-    auto granularSliderWidth = granularRow.getWidth() / 4;
+    auto granularSliderWidth = granularRow.getWidth() / 6;
 
     // Position granular controls regardless of visibility
     grainSizeSlider.setBounds(granularRow.removeFromLeft(granularSliderWidth));
     grainDensitySlider.setBounds(granularRow.removeFromLeft(granularSliderWidth));
     grainPitchSlider.setBounds(granularRow.removeFromLeft(granularSliderWidth));
     grainSpreadSlider.setBounds(granularRow.removeFromLeft(granularSliderWidth));
+    grainShapeBox.setBounds(granularRow.removeFromLeft(granularSliderWidth).reduced(5, 25));
+    grainTaperSlider.setBounds(granularRow.removeFromLeft(granularSliderWidth));
 
-    auto granularLabelWidth = granularLabelRow.getWidth() / 4;
+    auto granularLabelWidth = granularLabelRow.getWidth() / 6;
     grainSizeLabel.setBounds(granularLabelRow.removeFromLeft(granularLabelWidth));
     grainDensityLabel.setBounds(granularLabelRow.removeFromLeft(granularLabelWidth));
     grainPitchLabel.setBounds(granularLabelRow.removeFromLeft(granularLabelWidth));
     grainSpreadLabel.setBounds(granularLabelRow.removeFromLeft(granularLabelWidth));
+    grainShapeLabel.setBounds(granularLabelRow.removeFromLeft(granularLabelWidth));
+    grainTaperLabel.setBounds(granularLabelRow.removeFromLeft(granularLabelWidth));
+
+    area.removeFromTop(10);
+    telemetryLabel.setBounds(area.removeFromBottom(20));
+    visualizer.setBounds(area.withTrimmedBottom(5));
 }
@@ -1,11 +1,12 @@
 #pragma once
 
 #include "PluginProcessor.h"
+#include "delayVisualizer.h"
 #include "BinaryData.h"
 #include "melatonin_inspector/melatonin_inspector.h"
 
 //==============================================================================
-class PluginEditor : public juce::AudioProcessorEditor
+class PluginEditor : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     explicit PluginEditor (PluginProcessor&);
@@ -28,8 +29,10 @@ private:
 
     // granular controls
     juce::ToggleButton granularModeToggle;
-    juce::Slider grainSizeSlider, grainDensitySlider, grainPitchSlider, grainSpreadSlider;
-    juce::Label granularModeLabel, grainSizeLabel, grainDensityLabel, grainPitchLabel, grainSpreadLabel;
+    juce::Slider grainSizeSlider, grainDensitySlider, grainPitchSlider, grainSpreadSlider, grainTaperSlider;
+    juce::Label granularModeLabel, grainSizeLabel, grainDensityLabel, grainPitchLabel, grainSpreadLabel,
+        grainShapeLabel, grainTaperLabel;
+    juce::ComboBox grainShapeBox;
 
     // set up delay slider attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> delaySliderAttach,
@@ -38,7 +41,15 @@ private:
     // granular delay attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> granularModeAttach;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainSizeSliderAttach,
-        grainDensitySliderAttach, grainPitchSliderAttach, grainSpreadSliderAttach;
+        grainDensitySliderAttach, grainPitchSliderAttach, grainSpreadSliderAttach, grainTaperSliderAttach;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> grainShapeAttach;
+
+    // delay history and grain cloud
+    delayVisualizer visualizer;
+
+    // engine status line, refreshed from the telemetry channel
+    juce::Label telemetryLabel;
+    void timerCallback() override;
 
     void granularModeChanged();
     ;
@@ -1,6 +1,12 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+// delay line sample format for this build, one of delayLine::Storage. set with
+// -DECHOES_DELAY_STORAGE=int16 (or float16) at configure time
+#ifndef ECHOES_DELAY_STORAGE
+    #define ECHOES_DELAY_STORAGE float32
+#endif
+
 //==============================================================================
 PluginProcessor::PluginProcessor()
      : AudioProcessor (BusesProperties()
@@ -26,11 +32,72 @@ PluginProcessor::PluginProcessor()
     grainDensityParam = apvts.getRawParameterValue("grainDensity");
     grainPitchParam = apvts.getRawParameterValue("grainPitch");
     grainSpreadParam = apvts.getRawParameterValue("grainSpread");
-
+    grainStealParam = apvts.getRawParameterValue("grainSteal");
+    grainShapeParam = apvts.getRawParameterValue("grainShape");
+    grainTaperParam = apvts.getRawParameterValue("grainTaper");
+    seedParam = apvts.getRawParameterValue("seed");
+    parallelGrainsParam = apvts.getRawParameterValue("parallelGrains");
+    grainHistoryParam = apvts.getRawParameterValue("grainHistory");
+
+    feedbackLowCutParam = apvts.getRawParameterValue("feedbackLowCut");
+    feedbackHighCutParam = apvts.getRawParameterValue("feedbackHighCut");
+    feedbackDriveParam = apvts.getRawParameterValue("feedbackDrive");
+    qualityParam = apvts.getRawParameterValue("quality");
+
+    multiTapParam = apvts.getRawParameterValue("multiTap");
+    tapCountParam = apvts.getRawParameterValue("tapCount");
+    tapPatternParam = apvts.getRawParameterValue("tapPattern");
+
+    spectralModeParam = apvts.getRawParameterValue("spectralMode");
+    spectralFreezeParam = apvts.getRawParameterValue("spectralFreeze");
+    spectralSmearParam = apvts.getRawParameterValue("spectralSmear");
+
+    reverbPositionParam = apvts.getRawParameterValue("reverbPosition");
+    reverbMixParam = apvts.getRawParameterValue("reverbMix");
+    reverbDecayParam = apvts.getRawParameterValue("reverbDecay");
+    reverbDampingParam = apvts.getRawParameterValue("reverbDamping");
+
+    cpuBudgetParam = apvts.getRawParameterValue("cpuBudget");
+    governorLevelParam = dynamic_cast<juce::AudioParameterInt*>(apvts.getParameter("governorLevel"));
+    jassert(governorLevelParam != nullptr);
+
+    // the audio thread reads all of them through the block's snapshot
+    const std::pair<int, std::atomic<float>*> bindings[] = {
+        { slot::delaySize, delaySizeParam }, { slot::gainBegin, gainBeginParam }, { slot::gainEnd, gainEndParam },
+        { slot::feedback, feedbackParam }, { slot::wetDry, wetDryParam },
+        { slot::granularMode, granularModeParam }, { slot::grainSize, grainSizeParam },
+        { slot::grainDensity, grainDensityParam }, { slot::grainPitch, grainPitchParam },
+        { slot::grainSpread, grainSpreadParam }, { slot::grainSteal, grainStealParam },
+        { slot::grainShape, grainShapeParam }, { slot::grainTaper, grainTaperParam }, { slot::seed, seedParam },
+        { slot::parallelGrains, parallelGrainsParam }, { slot::grainHistory, grainHistoryParam },
+        { slot::feedbackLowCut, feedbackLowCutParam }, { slot::feedbackHighCut, feedbackHighCutParam },
+        { slot::feedbackDrive, feedbackDriveParam }, { slot::quality, qualityParam },
+        { slot::multiTap, multiTapParam }, { slot::tapCount, tapCountParam }, { slot::tapPattern, tapPatternParam },
+        { slot::spectralMode, spectralModeParam }, { slot::spectralFreeze, spectralFreezeParam },
+        { slot::spectralSmear, spectralSmearParam },
+        { slot::reverbPosition, reverbPositionParam }, { slot::reverbMix, reverbMixParam },
+        { slot::reverbDecay, reverbDecayParam }, { slot::reverbDamping, reverbDampingParam },
+        { slot::cpuBudget, cpuBudgetParam }
+    };
+    for (const auto& [index, source] : bindings)
+    {
+        parameters.bind(index, source);
+    }
+
+    // notifying the host takes locks, so that happens on the message thread
+    startTimerHz(10);
+
+    // one file per instance when several are loaded
+    auto tracePath = juce::SystemStats::getEnvironmentVariable("ECHOES_TELEMETRY_TRACE", {});
+    if (tracePath.isNotEmpty())
+    {
+        startTelemetryTrace(juce::File(tracePath).getNonexistentSibling());
+    }
 }
 
 PluginProcessor::~PluginProcessor()
 {
+    stopTimer();
 }
 
 //======================create parameter layout=================================
@@ -46,9 +113,63 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
 
     params.push_back (std::make_unique<juce::AudioParameterBool> ("granularMode", "Granular Mode", false));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("grainSize", "Grain Size", 10.0f, 500.0f, 100.0f));
-    params.push_back (std::make_unique<juce::AudioParameterFloat> ("grainDensity", "Grain Density", 1.0f, 50.0f, 10.0f));
+    // up to dense clouds of a thousand grains, skewed so the sparse end keeps most of the travel
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("grainDensity", "Grain Density",
+        juce::NormalisableRange<float> (1.0f, grainProcessor::maxGrainDensityHz, 0.0f, 0.3f), 10.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("grainPitch", "Grain Pitch", 0.25f, 4.0f, 1.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("grainSpread", "Grain Spread", 0.0f, 200.0f, 50.0f));
+    // order matches grainPool::StealPolicy
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("grainSteal", "Grain Stealing",
+        juce::StringArray { "Oldest", "Quietest", "Reject" }, 0));
+    // order matches grainWindows::Shape, taper only applies to tukey and trapezoid
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("grainShape", "Grain Shape",
+        juce::StringArray { "Hann", "Tukey", "Gaussian", "Trapezoid", "Exp Decay" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("grainTaper", "Grain Taper", 0.01f, 1.0f, 0.5f));
+    // grain placement is random but repeatable, bounces with the same seed match bit for bit
+    params.push_back (std::make_unique<juce::AudioParameterInt> ("seed", "Seed", 0, 65535, 0));
+    // spreads dense grain clouds over worker threads, the output doesn't change
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("parallelGrains", "Parallel Grains", false));
+    // how far back grains reach, 0 follows the delay size. past the delay size the audio is kept
+    // in a compressed store that is sized in prepareToPlay, so growing it needs a re-prepare
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("grainHistory", "Grain History",
+        0.0f, delayProcessor::maxGrainHistorySeconds, 0.0f));
+    // shape what goes round the standard delay's loop. quality picks the oversampling of the
+    // saturator and the filter slopes, changing it isn't click free so it isn't automatable
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("feedbackLowCut", "Feedback Low Cut",
+        juce::NormalisableRange<float> (feedbackShaper::minLowCutHz, feedbackShaper::maxLowCutHz, 0.0f, 0.3f),
+        feedbackShaper::minLowCutHz));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("feedbackHighCut", "Feedback High Cut",
+        juce::NormalisableRange<float> (feedbackShaper::minHighCutHz, feedbackShaper::maxHighCutHz, 0.0f, 0.3f),
+        feedbackShaper::maxHighCutHz));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("feedbackDrive", "Feedback Drive", 0.0f, 1.0f, 0.0f));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("quality", "Quality",
+        juce::StringArray { "Eco", "Normal", "High" }, 1, juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+    // several read heads on the standard delay, laid out by the pattern across the delay size.
+    // the random pattern is drawn from the seed
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("multiTap", "Multi-Tap Mode", false));
+    params.push_back (std::make_unique<juce::AudioParameterInt> ("tapCount", "Tap Count", 1, multiTapDelay::maxTaps, 4));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("tapPattern", "Tap Pattern",
+        juce::StringArray { "Even", "Golden Ratio", "Dotted", "Random" }, 0));
+    // fft based delay, only the magnitudes repeat. freeze holds what's going into the loop, smear
+    // blurs each frame over the ones after it. it's a frame and a hop late, which the host compensates
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("spectralMode", "Spectral Mode", false));
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("spectralFreeze", "Spectral Freeze", false));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("spectralSmear", "Spectral Smear",
+        0.0f, spectralProcessor::maxSmear, 0.0f));
+    // diffuse tail after the grains, or inside the standard delay's feedback loop. off at mix 0
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("reverbPosition", "Reverb Position",
+        juce::StringArray { "Post Grains", "Feedback Loop" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("reverbMix", "Reverb Mix", 0.0f, 1.0f, 0.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("reverbDecay", "Reverb Decay",
+        juce::NormalisableRange<float> (fdnReverb::minDecaySeconds, fdnReverb::maxDecaySeconds, 0.0f, 0.3f), 3.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("reverbDamping", "Reverb Damping", 0.0f, 1.0f, 0.5f));
+    // share of each block's real-time deadline processing may use before the governor sheds
+    // work. the level it's at (0 is full quality, see cpuGovernor::getSettings) is reported
+    // back through governorLevel, which isn't meant to be automated
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("cpuBudget", "CPU Budget", 0.1f, 1.0f,
+        cpuGovernor::defaultBudget));
+    params.push_back (std::make_unique<juce::AudioParameterInt> ("governorLevel", "CPU Governor Level",
+        0, cpuGovernor::numLevels - 1, 0, juce::AudioParameterIntAttributes().withAutomatable (false)));
 
     return { params.begin(), params.end() };
 }
@@ -88,7 +209,18 @@ bool PluginProcessor::isMidiEffect() const
 
 double PluginProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // hosts ask from the message thread, often before the first block, so this works
+    // from the parameters and never from what the audio thread has set up
+    auto tailSeconds = delay.getTailLengthSeconds(*delaySizeParam, *feedbackParam, *granularModeParam > 0.5f,
+        *grainSizeParam, *grainHistoryParam, *spectralModeParam > 0.5f, *spectralFreezeParam > 0.5f,
+        *spectralSmearParam);
+
+    // the reverb rings on after the last echo
+    if (*reverbMixParam > 0.0f)
+    {
+        tailSeconds += juce::jlimit(fdnReverb::minDecaySeconds, fdnReverb::maxDecaySeconds, reverbDecayParam->load());
+    }
+    return tailSeconds;
 }
 
 int PluginProcessor::getNumPrograms()
@@ -121,9 +253,36 @@ void PluginProcessor::changeProgramName (int index, const juce::String& newName)
 //==============================================================================
 void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-
-    delay.prepare(sampleRate, getTotalNumOutputChannels(), 10.0f);
-
+    // all audio thread memory is allocated here, processBlock must not allocate
+    delay.setGrainSeed(static_cast<uint32_t>(*seedParam));
+    // a double host gets a double loop, unless a reduced storage format was built in
+    auto storage = delayLine::Storage::ECHOES_DELAY_STORAGE;
+    if (isUsingDoublePrecision() && storage == delayLine::Storage::float32)
+    {
+        storage = delayLine::Storage::float64;
+    }
+    delay.setDelayStorage(storage);
+    delay.setDoublePrecision(isUsingDoublePrecision());
+    delay.prepare(sampleRate, getTotalNumOutputChannels(), samplesPerBlock, 10.0f, *grainHistoryParam);
+    if (*parallelGrainsParam > 0.5f)
+    {
+        delay.startGrainWorkers();
+    }
+
+    // the host reads the latency before playback starts, later mode changes go through the timer
+    delay.setSpectral(*spectralModeParam > 0.5f, *spectralFreezeParam > 0.5f, *spectralSmearParam);
+    latencySamples.store(delay.getLatencySamples(), std::memory_order_relaxed);
+    setLatencySamples(delay.getLatencySamples());
+
+    loadMeasurer.reset(sampleRate, samplesPerBlock);
+    governor.prepare(sampleRate);
+
+    // the first block passes everything on again
+    parameters.invalidate();
+
+    blockIndex = 0;
+    preparedBlockSize = samplesPerBlock;
+    lastBlockSize = samplesPerBlock;
 }
 
 void PluginProcessor::releaseResources()
@@ -154,30 +313,159 @@ bool PluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
   #endif
 }
 
+bool PluginProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                               juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused (midiMessages);
+    processSamples (buffer);
+}
 
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    bool granularMode = *granularModeParam > 0.5f;
+void PluginProcessor::processBlock (juce::AudioBuffer<double>& buffer,
+                                              juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processSamples (buffer);
+}
 
+template <typename SampleType>
+void PluginProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer)
+{
+    juce::ScopedNoDenormals noDenormals;
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer (loadMeasurer, buffer.getNumSamples());
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    // every atomic is read once, here. the rest of the block works from the snapshot
+    parameters.capture();
+    auto get = [this] (int index) { return parameters.get(index); };
+
+    // the load of the blocks so far decides how much this one may spend. offline
+    // renders have no deadline and always run at full quality
+    if (isNonRealtime())
+    {
+        governor.reset();
+    }
+    else
+    {
+        governor.setBudget(get(slot::cpuBudget));
+        governor.update(loadMeasurer.getLoadAsProportion(), buffer.getNumSamples());
+    }
+
+    auto quality = cpuGovernor::getSettings(governor.getLevel());
+    delay.setGrainBudget(quality.densityScale, quality.grainLimit);
+    delay.setInterpolation(quality.interpolation);
+    governorLevel.store(governor.getLevel(), std::memory_order_relaxed);
+
+    // only what moved is passed on, so coefficients and patterns aren't worked out again every block
+    bool granularMode = get(slot::granularMode) > 0.5f;
+    if (parameters.changed(slot::grainSteal))
+    {
+        delay.setGrainStealPolicy(static_cast<grainPool::StealPolicy>(static_cast<int>(get(slot::grainSteal))));
+    }
+    if (parameters.changed(slot::grainShape, slot::grainTaper))
+    {
+        delay.setGrainShape(static_cast<grainWindows::Shape>(static_cast<int>(get(slot::grainShape))), get(slot::grainTaper));
+    }
+    if (parameters.changed(slot::seed))
+    {
+        delay.setGrainSeed(static_cast<uint32_t>(get(slot::seed)));
+    }
+    if (parameters.changed(slot::parallelGrains))
+    {
+        delay.setParallelGrains(get(slot::parallelGrains) > 0.5f);
+    }
+    if (parameters.changed(slot::quality))
+    {
+        delay.setQuality(static_cast<feedbackShaper::Quality>(static_cast<int>(get(slot::quality))));
+    }
+    if (parameters.changed(slot::feedbackLowCut, slot::feedbackHighCut, slot::feedbackDrive))
+    {
+        delay.setFeedbackShape(get(slot::feedbackLowCut), get(slot::feedbackHighCut), get(slot::feedbackDrive));
+    }
+    if (parameters.changed(slot::multiTap, slot::tapPattern, slot::tapCount, slot::seed))
+    {
+        delay.setMultiTap(get(slot::multiTap) > 0.5f, static_cast<multiTapDelay::Pattern>(static_cast<int>(get(slot::tapPattern))),
+            static_cast<int>(get(slot::tapCount)), static_cast<uint32_t>(get(slot::seed)));
+    }
+    if (parameters.changed(slot::reverbPosition, slot::reverbMix, slot::reverbDecay, slot::reverbDamping))
+    {
+        delay.setReverb(static_cast<fdnReverb::Position>(static_cast<int>(get(slot::reverbPosition))),
+            get(slot::reverbMix), get(slot::reverbDecay), get(slot::reverbDamping));
+    }
+    if (parameters.changed(slot::spectralMode, slot::spectralFreeze, slot::spectralSmear))
+    {
+        delay.setSpectral(get(slot::spectralMode) > 0.5f, get(slot::spectralFreeze) > 0.5f, get(slot::spectralSmear));
+        latencySamples.store(delay.getLatencySamples(), std::memory_order_relaxed);
+    }
+
+    // delay time, feedback and mix glide inside the engine, sub-block by sub-block
     delay.process(buffer,
-              *delaySizeParam,
-              *feedbackParam,
-              *wetDryParam,
-              *gainBeginParam,
-              *gainEndParam,
+              get(slot::delaySize),
+              get(slot::feedback),
+              get(slot::wetDry),
+              get(slot::gainBegin),
+              get(slot::gainEnd),
               getSampleRate(),
               granularMode,
-              *grainSizeParam,
-              *grainDensityParam,
-              *grainPitchParam,
-              *grainSpreadParam);
+              get(slot::grainSize),
+              get(slot::grainDensity),
+              get(slot::grainPitch),
+              get(slot::grainSpread),
+              get(slot::grainHistory));
+
+    // one telemetry frame per block, the output is scanned for nans and denormals
+    int numSamples = buffer.getNumSamples();
+    telemetryFrame frame {};
+    frame.blockIndex = blockIndex++;
+    frame.numSamples = static_cast<uint32_t>(numSamples);
+    frame.flags = granularMode ? telemetryFlags::granular : 0u;
+    if (numSamples != lastBlockSize)
+    {
+        frame.flags |= telemetryFlags::blockSizeChanged;
+    }
+    if (numSamples > preparedBlockSize)
+    {
+        frame.flags |= telemetryFlags::oversizedBlock;
+    }
+    lastBlockSize = numSamples;
+
+    delay.collectTelemetry(frame);
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        frame.flags |= telemetryScan::classify(buffer.getReadPointer(channel), numSamples);
+    }
+    frame.governorLevel = governor.getLevel();
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    frame.processMicroseconds = static_cast<float>(seconds * 1.0e6);
+    frame.load = numSamples > 0 ? static_cast<float>(seconds * getSampleRate() / numSamples) : 0.0f;
+    telemetry.push(frame);
+}
 
+void PluginProcessor::timerCallback()
+{
+    // also puts the value back if the host wrote to the parameter
+    int level = governorLevel.load(std::memory_order_relaxed);
+    if (governorLevelParam->get() != level)
+    {
+        governorLevelParam->setValueNotifyingHost(governorLevelParam->convertTo0to1(static_cast<float>(level)));
+    }
+
+    int latency = latencySamples.load(std::memory_order_relaxed);
+    if (getLatencySamples() != latency)
+    {
+        setLatencySamples(latency);
+    }
+
+    // an instance only gets grain worker threads once it renders in parallel
+    if (*parallelGrainsParam > 0.5f)
+    {
+        delay.startGrainWorkers();
+    }
 }
 
 //==============================================================================
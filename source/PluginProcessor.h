@@ -1,13 +1,17 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "cpuGovernor.h"
 #include "delayProcessor.h"
+#include "engineTelemetry.h"
+#include "parameterSnapshot.h"
+#include "telemetryTraceSink.h"
 
 #if (MSVC)
 #include "ipps.h"
 #endif
 
-class PluginProcessor : public juce::AudioProcessor
+class PluginProcessor : public juce::AudioProcessor, private juce::Timer
 {
 public:
     PluginProcessor();
@@ -18,7 +22,10 @@ public:
 
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
+    // both precisions run the same engine, the host picks one before prepareToPlay
+    bool supportsDoublePrecisionProcessing() const override;
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -41,6 +48,20 @@ public:
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    // what the engine did, one frame per block. any thread may read it with its own reader
+    const engineTelemetry& getTelemetry() const { return telemetry; }
+
+    // writes every frame to a binary file for offline analysis (see telemetryTraceSink).
+    // setting ECHOES_TELEMETRY_TRACE to a file path starts one when the plugin is created
+    bool startTelemetryTrace(const juce::File& file) { return traceSink.start(file); }
+    void stopTelemetryTrace() { traceSink.stop(); }
+
+    // feeds the editor's delay display
+    delayVisualFeed& getVisualFeed() { return delay.getVisualFeed(); }
+
+    // threads the grains render on, none until parallel grains are first switched on
+    int getNumGrainWorkers() const { return delay.getNumGrainWorkers(); }
+
     //==========================parameter setup=================================
 
     // standard delay parameters
@@ -56,6 +77,34 @@ public:
     std::atomic<float>* grainDensityParam;
     std::atomic<float>* grainPitchParam;
     std::atomic<float>* grainSpreadParam;
+    std::atomic<float>* grainStealParam;
+    std::atomic<float>* grainShapeParam;
+    std::atomic<float>* grainTaperParam;
+    std::atomic<float>* seedParam;
+    std::atomic<float>* parallelGrainsParam;
+    std::atomic<float>* grainHistoryParam;
+
+    std::atomic<float>* feedbackLowCutParam;
+    std::atomic<float>* feedbackHighCutParam;
+    std::atomic<float>* feedbackDriveParam;
+    std::atomic<float>* qualityParam;
+
+    std::atomic<float>* multiTapParam;
+    std::atomic<float>* tapCountParam;
+    std::atomic<float>* tapPatternParam;
+
+    std::atomic<float>* spectralModeParam;
+    std::atomic<float>* spectralFreezeParam;
+    std::atomic<float>* spectralSmearParam;
+
+    std::atomic<float>* reverbPositionParam;
+    std::atomic<float>* reverbMixParam;
+    std::atomic<float>* reverbDecayParam;
+    std::atomic<float>* reverbDampingParam;
+
+    // cpu governor, the level is written by the plugin and only read by the host
+    std::atomic<float>* cpuBudgetParam;
+    juce::AudioParameterInt* governorLevelParam;
 
     juce::AudioProcessorValueTreeState apvts;
 
@@ -63,5 +112,42 @@ private:
 
     delayProcessor delay;
 
+    // every parameter the audio thread reads, loaded once per block. the engine's setters
+    // only run for the ones that changed, and gliding is left to the engine
+    parameterSnapshot parameters;
+    struct slot
+    {
+        enum : int
+        {
+            delaySize, gainBegin, gainEnd, feedback, wetDry,
+            granularMode, grainSize, grainDensity, grainPitch, grainSpread,
+            grainSteal, grainShape, grainTaper, seed, parallelGrains, grainHistory,
+            feedbackLowCut, feedbackHighCut, feedbackDrive, quality,
+            multiTap, tapCount, tapPattern,
+            spectralMode, spectralFreeze, spectralSmear,
+            reverbPosition, reverbMix, reverbDecay, reverbDamping,
+            cpuBudget
+        };
+    };
+
+    // how long each block takes against its deadline, and what the governor makes of it
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+    cpuGovernor governor;
+
+    // the audio thread publishes the level, the timer passes it on to the host
+    std::atomic<int> governorLevel { 0 };
+    // same for the latency, which changes with the delay mode
+    std::atomic<int> latencySamples { 0 };
+    void timerCallback() override;
+
+    engineTelemetry telemetry;
+    telemetryTraceSink traceSink { telemetry };
+    uint64_t blockIndex { 0 };
+    int preparedBlockSize { 0 };
+    int lastBlockSize { 0 };
+
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginProcessor)
 };
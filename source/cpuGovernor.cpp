@@ -0,0 +1,72 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "cpuGovernor.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+
+cpuGovernor::cpuGovernor() {}
+
+cpuGovernor::Settings cpuGovernor::getSettings(int level)
+{
+    // the cheaper interpolator goes first since it's inaudible on most material,
+    // then fewer and sparser grains
+    switch (juce::jlimit(0, numLevels - 1, level))
+    {
+        case 1:
+            return { 1.0f, 0.75f, delayLine::Interpolation::linear };
+        case 2:
+            return { 0.5f, 0.5f, delayLine::Interpolation::linear };
+        case 3:
+            return { 0.25f, 0.25f, delayLine::Interpolation::linear };
+        case 0:
+        default:
+            return { 1.0f, 1.0f, delayLine::Interpolation::lagrange3 };
+    }
+}
+
+void cpuGovernor::prepare(double sampleRate)
+{
+    settleSamples = static_cast<int>(settleSeconds * sampleRate);
+    recoverSamples = static_cast<int>(recoverSeconds * sampleRate);
+    reset();
+}
+
+void cpuGovernor::reset()
+{
+    level = 0;
+    samplesSinceStep = settleSamples;
+    samplesUnderBudget = 0;
+}
+
+void cpuGovernor::update(double load, int numSamples)
+{
+    samplesSinceStep = juce::jmin(samplesSinceStep + numSamples, settleSamples);
+
+    if (load > budget)
+    {
+        samplesUnderBudget = 0;
+
+        if (level < numLevels - 1 && samplesSinceStep >= settleSamples)
+        {
+            ++level;
+            samplesSinceStep = 0;
+        }
+        return;
+    }
+
+    // between the two thresholds the level holds
+    if (load >= budget * recoverRatio)
+    {
+        samplesUnderBudget = 0;
+        return;
+    }
+
+    samplesUnderBudget += numSamples;
+
+    if (level > 0 && samplesUnderBudget >= recoverSamples)
+    {
+        --level;
+        samplesUnderBudget = 0;
+    }
+}
@@ -0,0 +1,64 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "delayLine.h"
+
+#ifndef CPUGOVERNOR_H
+#define CPUGOVERNOR_H
+
+// watches how much of each block's real-time deadline processing takes and picks
+// a degradation level from it. levels step up one at a time while the load is over
+// budget and come back down only after the load has stayed well under it for a
+// while, so a single slow block never makes the sound flap between settings
+class cpuGovernor {
+public:
+    // 0 is full quality, each level above sheds more work
+    static constexpr int numLevels = 4;
+
+    // what a level does to the engine
+    struct Settings
+    {
+        float densityScale;                     // multiplies the grain density
+        float grainLimit;                       // fraction of the grain pool that may be active
+        delayLine::Interpolation interpolation; // read interpolation of the standard delay
+    };
+
+    static Settings getSettings(int level);
+
+    // fraction of the deadline the governor aims to stay under
+    static constexpr float defaultBudget = 0.7f;
+
+    // the load has to fall below budget * recoverRatio for recoverSeconds before a level is given back
+    static constexpr float recoverRatio = 0.6f;
+    static constexpr double recoverSeconds = 2.0;
+
+    // after a step up the next one waits this long, so the load has time to reflect the change
+    static constexpr double settleSeconds = 0.25;
+
+    cpuGovernor();
+
+    void prepare(double sampleRate);
+    void reset();
+
+    void setBudget(float newBudget) { budget = newBudget; }
+    float getBudget() const { return budget; }
+
+    // load is the share of the last block's deadline it took to process (1 is a dropout),
+    // called once per block
+    void update(double load, int numSamples);
+
+    int getLevel() const { return level; }
+
+private:
+    float budget { defaultBudget };
+    int level { 0 };
+
+    int settleSamples { 0 };
+    int recoverSamples { 0 };
+    int samplesSinceStep { 0 };
+    int samplesUnderBudget { 0 };
+};
+
+#endif //CPUGOVERNOR_H
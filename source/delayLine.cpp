@@ -0,0 +1,191 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "delayLine.h"
+
+delayLine::delayLine(){}
+
+void delayLine::prepare(int numChannels, int maxDelaySamples, int maxBlockSize, Storage storage)
+{
+    // room for the longest delay, one block being written and the lagrange taps
+    capacity = juce::nextPowerOfTwo(maxDelaySamples + maxBlockSize + 4);
+    mask = capacity - 1;
+    this->maxDelaySamples = maxDelaySamples;
+    this->numChannels = numChannels;
+    this->storage = storage;
+
+    // only the format in use is allocated
+    buffer.setSize(storage == Storage::float32 ? numChannels : 0, storage == Storage::float32 ? capacity : 0);
+    wideBuffer.setSize(storage == Storage::float64 ? numChannels : 0, storage == Storage::float64 ? capacity : 0);
+    if (storage == Storage::int16 || storage == Storage::float16)
+    {
+        reducedSamples.resize(static_cast<size_t>(numChannels * capacity));
+    }
+    else
+    {
+        reducedSamples.clear();
+        reducedSamples.shrink_to_fit();
+    }
+
+    // a block at a constant delay, with some room for a glide
+    spanScratch.resize(static_cast<size_t>(2 * maxBlockSize + 8));
+    reset();
+}
+
+void delayLine::reset()
+{
+    // zero is all zero bits in every format
+    buffer.clear();
+    wideBuffer.clear();
+    std::fill(reducedSamples.begin(), reducedSamples.end(), uint16_t { 0 });
+    writePosition = 0;
+}
+
+template <typename SampleType>
+void delayLine::writeBlock(int channel, int offset, const SampleType* source, int numSamples)
+{
+    jassert(numSamples <= capacity);
+
+    int start = (writePosition + offset) & mask;
+    auto numSamplesToEnd = juce::jmin(numSamples, capacity - start);
+
+    auto copy = [this, channel] (int index, const SampleType* from, int count) {
+        switch (storage)
+        {
+            case Storage::int16:
+            case Storage::float16:
+                if constexpr (std::is_same_v<SampleType, float>)
+                {
+                    writeReduced(channel, index, from, count);
+                }
+                else
+                {
+                    // the reduced formats convert from float, a double block goes through in pieces
+                    float narrowed[256];
+                    for (int done = 0; done < count; done += 256)
+                    {
+                        int piece = juce::jmin(256, count - done);
+                        std::copy(from + done, from + done + piece, narrowed);
+                        writeReduced(channel, index + done, narrowed, piece);
+                    }
+                }
+                break;
+            case Storage::float64:
+                std::copy(from, from + count, wideBuffer.getWritePointer(channel) + index);
+                break;
+            case Storage::float32:
+            default:
+                std::copy(from, from + count, buffer.getWritePointer(channel) + index);
+                break;
+        }
+    };
+
+    copy(start, source, numSamplesToEnd);
+
+    if (numSamplesToEnd < numSamples)
+    {
+        copy(0, source + numSamplesToEnd, numSamples - numSamplesToEnd);
+    }
+}
+
+template void delayLine::writeBlock<float>(int, int, const float*, int);
+template void delayLine::writeBlock<double>(int, int, const double*, int);
+
+void delayLine::writeReduced(int channel, int index, const float* source, int numSamples)
+{
+    auto* reduced = reducedSamples.data() + channel * capacity + index;
+    if (storage == Storage::int16)
+    {
+        sampleConversion::toInt16(source, reinterpret_cast<int16_t*>(reduced), numSamples);
+    }
+    else
+    {
+        sampleConversion::toHalf(source, reduced, numSamples);
+    }
+}
+
+void delayLine::advance(int numSamples)
+{
+    writePosition = (writePosition + numSamples) & mask;
+}
+
+const float* delayLine::getReadPointer(int channel) const
+{
+    jassert(storage == Storage::float32);
+    return buffer.getReadPointer(channel);
+}
+
+void delayLine::readSpan(int channel, int position, int numSamples, float* destination) const
+{
+    jassert(numSamples <= capacity);
+
+    // at most two runs, up to the end of the ring and on from the start
+    for (int done = 0; done < numSamples;)
+    {
+        int index = (position + done) & mask;
+        int count = juce::jmin(numSamples - done, capacity - index);
+
+        switch (storage)
+        {
+            case Storage::int16:
+                sampleConversion::fromInt16(reinterpret_cast<const int16_t*>(getReducedPointer(channel)) + index,
+                    destination + done, count);
+                break;
+            case Storage::float16:
+                sampleConversion::fromHalf(getReducedPointer(channel) + index, destination + done, count);
+                break;
+            case Storage::float64:
+            {
+                const double* wide = wideBuffer.getReadPointer(channel) + index;
+                for (int i = 0; i < count; ++i)
+                {
+                    destination[done + i] = static_cast<float>(wide[i]);
+                }
+                break;
+            }
+            case Storage::float32:
+            default:
+                std::copy(buffer.getReadPointer(channel) + index, buffer.getReadPointer(channel) + index + count,
+                    destination + done);
+                break;
+        }
+
+        done += count;
+    }
+}
+
+template <typename SampleType>
+void delayLine::readBlock(int channel, int offset, const float* delaySamples, int numSamples, Interpolation interpolation, SampleType* destination)
+{
+    auto range = juce::FloatVectorOperations::findMinAndMax(delaySamples, numSamples);
+    jassert(range.getStart() >= static_cast<float>(numSamples + 1));
+
+    // from the oldest lagrange tap of the longest delay to the newest tap of the shortest
+    int position = writePosition + offset;
+    int firstPosition = position - static_cast<int>(range.getEnd()) - 3;
+    int lastPosition = position + numSamples - static_cast<int>(range.getStart());
+    int spanLength = lastPosition - firstPosition + 1;
+
+    // float32 and float64 have nothing to convert, and fast glides cover more than the scratch holds
+    if (storage == Storage::float32 || storage == Storage::float64 || spanLength > static_cast<int>(spanScratch.size()))
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            destination[i] = read<SampleType>(channel, offset + i, delaySamples[i], interpolation);
+        }
+        return;
+    }
+
+    readSpan(channel, firstPosition, spanLength, spanScratch.data());
+
+    const float* span = spanScratch.data();
+    for (int i = 0; i < numSamples; ++i)
+    {
+        destination[i] = static_cast<SampleType>(interpolate([span, firstPosition] (int index) { return span[index - firstPosition]; },
+            position + i, delaySamples[i], interpolation));
+    }
+}
+
+template void delayLine::readBlock<float>(int, int, const float*, int, Interpolation, float*);
+template void delayLine::readBlock<double>(int, int, const float*, int, Interpolation, double*);
@@ -0,0 +1,193 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "sampleConversion.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+#ifndef DELAYLINE_H
+#define DELAYLINE_H
+
+// fixed-capacity circular buffer shared by the standard and granular paths.
+// the capacity is a power of two so positions wrap with a mask instead of %,
+// and it is only ever allocated in prepare()
+class delayLine {
+public:
+    enum class Interpolation
+    {
+        linear,
+        lagrange3
+    };
+
+    // how samples are kept. the 16-bit formats halve the memory and the bandwidth
+    // random grain reads need, for a noise floor around -78 dBFS (int16) or
+    // -66 dB below the signal (float16). float64 is for hosts processing in double,
+    // it keeps the loop at double precision for as long as it recirculates
+    enum class Storage
+    {
+        float32,
+        int16,
+        float16,
+        float64
+    };
+
+    delayLine();
+
+    void prepare(int numChannels, int maxDelaySamples, int maxBlockSize, Storage storage = Storage::float32);
+    void reset();
+
+    // read the sample written delaySamples before (writePosition + offset).
+    // delaySamples must be >= 2 so the lagrange taps never reach unwritten samples.
+    // float64 storage interpolates in double, the rest in float
+    template <typename SampleType = float>
+    SampleType read(int channel, int offset, float delaySamples, Interpolation interpolation) const;
+    template <typename SampleType>
+    void write(int channel, int offset, SampleType sample);
+    // write() for numSamples from offset on, converted to the storage format in one go.
+    // float and double sources
+    template <typename SampleType>
+    void writeBlock(int channel, int offset, const SampleType* source, int numSamples);
+    void advance(int numSamples);
+
+    // read() for a whole block from offset on, with every delay time longer than the block
+    // (so nothing written during it is read). the stored span is converted in one go.
+    // float and double destinations
+    template <typename SampleType>
+    void readBlock(int channel, int offset, const float* delaySamples, int numSamples, Interpolation interpolation, SampleType* destination);
+
+    // numSamples of raw history from position on (masked), converted to float
+    void readSpan(int channel, int position, int numSamples, float* destination) const;
+
+    // direct access only exists for float32 storage, use readSpan() otherwise
+    const float* getReadPointer(int channel) const;
+    Storage getStorage() const { return storage; }
+    int getNumChannels() const { return numChannels; }
+    int getCapacity() const { return capacity; }
+    int getMask() const { return mask; }
+    int getWritePosition() const { return writePosition; }
+
+    // longest delay read() can serve
+    int getMaxDelaySamples() const { return maxDelaySamples; }
+
+    // the interpolators, sampleAt(position) returns the sample stored at an unmasked position.
+    // they work in whatever type sampleAt returns
+    template <typename SampleAt>
+    static auto interpolate(SampleAt&& sampleAt, int position, float delaySamples, Interpolation interpolation);
+
+private:
+    Storage storage { Storage::float32 };
+    juce::AudioBuffer<float> buffer;
+    juce::AudioBuffer<double> wideBuffer;   // float64 storage
+    std::vector<uint16_t> reducedSamples;   // numChannels * capacity, int16 or half bits
+    std::vector<float> spanScratch;         // readBlock's converted span
+    int numChannels { 0 };
+    int capacity { 0 };
+    int mask { 0 };
+    int writePosition { 0 };
+    int maxDelaySamples { 0 };
+
+    const uint16_t* getReducedPointer(int channel) const { return reducedSamples.data() + channel * capacity; }
+    void writeReduced(int channel, int index, const float* source, int numSamples);
+};
+
+// read/write are called per sample, so they live here where they can be inlined
+template <typename SampleAt>
+inline auto delayLine::interpolate(SampleAt&& sampleAt, int position, float delaySamples, Interpolation interpolation)
+{
+    using Value = std::decay_t<decltype(sampleAt(position))>;
+
+    if (interpolation == Interpolation::linear)
+    {
+        int whole = static_cast<int>(delaySamples);
+        Value fraction = static_cast<Value>(delaySamples - static_cast<float>(whole));
+
+        Value sample1 = sampleAt(position - whole);
+        Value sample2 = sampleAt(position - whole - 1);
+        return sample1 + fraction * (sample2 - sample1);
+    }
+
+    // third order lagrange with the fractional point between the two middle taps
+    int whole = static_cast<int>(delaySamples) - 1;
+    Value fraction = static_cast<Value>(delaySamples - static_cast<float>(whole));
+
+    Value value1 = sampleAt(position - whole);
+    Value value2 = sampleAt(position - whole - 1);
+    Value value3 = sampleAt(position - whole - 2);
+    Value value4 = sampleAt(position - whole - 3);
+
+    Value d1 = fraction - Value(1);
+    Value d2 = fraction - Value(2);
+    Value d3 = fraction - Value(3);
+
+    Value c1 = -d1 * d2 * d3 / Value(6);
+    Value c2 = d2 * d3 * Value(0.5);
+    Value c3 = -d1 * d3 * Value(0.5);
+    Value c4 = d1 * d2 / Value(6);
+
+    return value1 * c1 + fraction * (value2 * c2 + value3 * c3 + value4 * c4);
+}
+
+template <typename SampleType>
+inline SampleType delayLine::read(int channel, int offset, float delaySamples, Interpolation interpolation) const
+{
+    jassert(delaySamples >= 2.0f && delaySamples <= static_cast<float>(maxDelaySamples));
+
+    int position = writePosition + offset;
+    int wrap = mask;
+
+    switch (storage)
+    {
+        case Storage::int16:
+        {
+            auto* data = reinterpret_cast<const int16_t*>(getReducedPointer(channel));
+            return static_cast<SampleType>(interpolate([data, wrap] (int index) { return sampleConversion::fromInt16(data[index & wrap]); },
+                position, delaySamples, interpolation));
+        }
+        case Storage::float16:
+        {
+            auto* data = getReducedPointer(channel);
+            return static_cast<SampleType>(interpolate([data, wrap] (int index) { return sampleConversion::fromHalf(data[index & wrap]); },
+                position, delaySamples, interpolation));
+        }
+        case Storage::float64:
+        {
+            auto* data = wideBuffer.getReadPointer(channel);
+            return static_cast<SampleType>(interpolate([data, wrap] (int index) { return data[index & wrap]; },
+                position, delaySamples, interpolation));
+        }
+        case Storage::float32:
+        default:
+        {
+            auto* data = buffer.getReadPointer(channel);
+            return static_cast<SampleType>(interpolate([data, wrap] (int index) { return data[index & wrap]; },
+                position, delaySamples, interpolation));
+        }
+    }
+}
+
+template <typename SampleType>
+inline void delayLine::write(int channel, int offset, SampleType sample)
+{
+    int index = (writePosition + offset) & mask;
+
+    switch (storage)
+    {
+        case Storage::int16:
+            reducedSamples[static_cast<size_t>(channel * capacity + index)] = static_cast<uint16_t>(sampleConversion::toInt16(static_cast<float>(sample)));
+            break;
+        case Storage::float16:
+            reducedSamples[static_cast<size_t>(channel * capacity + index)] = sampleConversion::toHalf(static_cast<float>(sample));
+            break;
+        case Storage::float64:
+            wideBuffer.getWritePointer(channel)[index] = static_cast<double>(sample);
+            break;
+        case Storage::float32:
+        default:
+            buffer.getWritePointer(channel)[index] = static_cast<float>(sample);
+            break;
+    }
+}
+
+#endif //DELAYLINE_H
@@ -0,0 +1,178 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "delayMipmap.h"
+
+delayMipmap::delayMipmap()
+{
+    // kaiser windowed half-band, about 70 dB down from 0.3 of the sample rate
+    constexpr double beta = 7.0;
+    auto besselI0 = [] (double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 30; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    double total = 0.0;
+    for (size_t i = 0; i < coefficients.size(); ++i)
+    {
+        double offset = static_cast<double>(2 * i + 1);
+        double x = offset / (halfLength + 1);
+        double window = besselI0(beta * std::sqrt(1.0 - x * x)) / besselI0(beta);
+        double sinc = std::sin(juce::MathConstants<double>::halfPi * offset) / (juce::MathConstants<double>::pi * offset);
+        coefficients[i] = static_cast<float>(sinc * window);
+        total += 2.0 * sinc * window;
+    }
+
+    // unity at dc, the centre tap is 0.5
+    for (auto& coefficient : coefficients)
+    {
+        coefficient = static_cast<float>(coefficient * 0.5 / total);
+    }
+}
+
+void delayMipmap::prepare(int numChannels, int delayCapacity, int maxBlockSize)
+{
+    jassert(juce::isPowerOfTwo(delayCapacity));
+    this->numChannels = numChannels;
+    this->delayCapacity = delayCapacity;
+
+    for (int level = 1; level <= numLevels; ++level)
+    {
+        levels[static_cast<size_t>(level - 1)].assign(static_cast<size_t>(numChannels * getCapacity(level)), 0.0f);
+    }
+
+    // a block's worth of new centres and the taps either side
+    inputScratch.assign(static_cast<size_t>(maxBlockSize + 2 * halfLength + 4), 0.0f);
+    reset();
+}
+
+void delayMipmap::reset()
+{
+    for (auto& level : levels)
+    {
+        std::fill(level.begin(), level.end(), 0.0f);
+    }
+
+    // the first sample of each level waits for halfLength samples after it
+    nextIndex.fill(0);
+    lead.fill(-(halfLength + 1));
+}
+
+const float* delayMipmap::getReadPointer(int level, int channel) const
+{
+    jassert(level >= 1 && level <= numLevels);
+    return levels[static_cast<size_t>(level - 1)].data() + channel * getCapacity(level);
+}
+
+int delayMipmap::getLatency(int level) const
+{
+    // each level waits halfLength of the level above, plus a sample of rounding,
+    // and a span reads up to three samples past its last position
+    int latency = 0;
+    for (int l = 1; l <= level; ++l)
+    {
+        latency += (halfLength + 2) << (l - 1);
+    }
+    return latency + (4 << level);
+}
+
+int delayMipmap::getLevelForIncrement(float increment)
+{
+    if (increment > 2.0f)
+    {
+        return 2;
+    }
+    return increment > 1.0f ? 1 : 0;
+}
+
+float delayMipmap::filterAt(const float* input, int centre) const
+{
+    // zero phase, so the output lines up with input[centre]
+    float sum = 0.5f * input[centre];
+    for (size_t i = 0; i < coefficients.size(); ++i)
+    {
+        int offset = static_cast<int>(2 * i + 1);
+        sum += coefficients[i] * (input[centre - offset] + input[centre + offset]);
+    }
+    return sum;
+}
+
+void delayMipmap::append(const delayLine& source, int numSamples)
+{
+    if (delayCapacity == 0)
+    {
+        return;
+    }
+
+    jassert(source.getCapacity() == delayCapacity);
+
+    // level 1 centres whose look-ahead has now been written
+    lead[0] += numSamples;
+    int count = lead[0] >= 0 ? lead[0] / 2 + 1 : 0;
+    if (count == 0)
+    {
+        return;
+    }
+
+    int firstCentre = nextIndex[0] * 2;
+    int spanLength = 2 * (count - 1) + 2 * halfLength + 1;
+    jassert(spanLength <= static_cast<int>(inputScratch.size()));
+    int mask1 = getMask(1);
+
+    for (int channel = 0; channel < juce::jmin(numChannels, source.getNumChannels()); ++channel)
+    {
+        source.readSpan(channel, firstCentre - halfLength, spanLength, inputScratch.data());
+        auto* level1 = levels[0].data() + channel * getCapacity(1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            level1[(nextIndex[0] + i) & mask1] = filterAt(inputScratch.data(), halfLength + 2 * i);
+        }
+    }
+
+    nextIndex[0] = (nextIndex[0] + count) & mask1;
+    lead[0] -= 2 * count;
+
+    computeLevel2(count);
+}
+
+void delayMipmap::computeLevel2(int count)
+{
+    lead[1] += count;
+    int count2 = lead[1] >= 0 ? lead[1] / 2 + 1 : 0;
+    if (count2 == 0)
+    {
+        return;
+    }
+
+    int mask1 = getMask(1);
+    int mask2 = getMask(2);
+
+    // level 1 is a ring of floats already, the taps are read in place
+    std::array<float, 2 * halfLength + 1> taps {};
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* level1 = levels[0].data() + channel * getCapacity(1);
+        auto* level2 = levels[1].data() + channel * getCapacity(2);
+
+        for (int i = 0; i < count2; ++i)
+        {
+            int centre = (nextIndex[1] + i) * 2;
+            for (int t = 0; t < static_cast<int>(taps.size()); ++t)
+            {
+                taps[static_cast<size_t>(t)] = level1[(centre - halfLength + t) & mask1];
+            }
+            level2[(nextIndex[1] + i) & mask2] = filterAt(taps.data(), halfLength);
+        }
+    }
+
+    nextIndex[1] = (nextIndex[1] + count2) & mask2;
+    lead[1] -= 2 * count2;
+}
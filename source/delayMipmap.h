@@ -0,0 +1,73 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "delayLine.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <vector>
+
+#ifndef DELAYMIPMAP_H
+#define DELAYMIPMAP_H
+
+// half and quarter rate copies of the delay line for pitched up grains. each level
+// is the one above it through a zero phase half-band lowpass, keeping every other
+// sample, so level sample k sits exactly at full rate position k << level. a grain
+// reading at pitch p from the level with 2^level >= p never sees anything above
+// its own nyquist, and the linear interpolation stays as cheap as at unity.
+//
+// levels are filled as audio is appended, trailing the write position by the
+// filter's look-ahead (getLatency()). positions are masked like the delay line's,
+// level ring L holds the same span of time in capacity >> L samples
+class delayMipmap {
+public:
+    static constexpr int numLevels = 2;
+
+    // half-band taps either side of the centre, odd offsets only (the even ones are zero)
+    static constexpr int halfLength = 23;
+
+    delayMipmap();
+
+    void prepare(int numChannels, int delayCapacity, int maxBlockSize);
+    void reset();
+
+    // picks up the numSamples source has just written at its write position.
+    // call once per block, before source.advance()
+    void append(const delayLine& source, int numSamples);
+
+    const float* getReadPointer(int level, int channel) const;
+    int getCapacity(int level) const { return delayCapacity >> level; }
+    int getMask(int level) const { return (delayCapacity >> level) - 1; }
+
+    // full rate samples between the source's write position and the newest finished
+    // sample of level, after append() and including the interpolation taps
+    int getLatency(int level) const;
+
+    // level whose rate suits a grain reading increment samples per output sample
+    static int getLevelForIncrement(float increment);
+
+private:
+    int numChannels { 0 };
+    int delayCapacity { 0 };
+
+    // rings for levels 1 and 2, numChannels * (delayCapacity >> level)
+    std::array<std::vector<float>, numLevels> levels;
+
+    // full rate samples around the new level 1 centres, converted from the delay line
+    std::vector<float> inputScratch;
+
+    // odd taps of the half-band, coefficients[i] is the tap at offset 2i + 1
+    std::array<float, (halfLength + 1) / 2> coefficients {};
+
+    // per level: the next sample to compute (in that level's index space), and how many
+    // more samples of the level above have arrived than that sample needs (negative
+    // while it is still waiting for its look-ahead)
+    std::array<int, numLevels> nextIndex {};
+    std::array<int, numLevels> lead {};
+
+    float filterAt(const float* input, int centre) const;
+    void computeLevel2(int count);
+};
+
+#endif //DELAYMIPMAP_H
@@ -6,179 +6,679 @@
 
 delayProcessor::delayProcessor(){}
 
-void delayProcessor::prepare(double sampleRate, int numChannels, float maxDelaySeconds)
+void delayProcessor::prepare(double sampleRate, int numChannels, int hostBlockSize, float maxDelaySeconds,
+    float grainHistorySeconds)
 {
-    int bufferSize = static_cast<int>(sampleRate * maxDelaySeconds);
-    delayBuffer.setSize(numChannels, bufferSize);
-    delayBuffer.clear();
-    writePosition = 0;
-    previousDelaySeconds = 1.0f;
+    // everything below is sized for one sub-block, process() works through the host's
+    // blocks a sub-block at a time. grains pay their setup on every call, so the granular
+    // path takes longer ones and the scratch is sized for those
+    subBlockFrames = subBlockSize > 0 ? juce::jmin(hostBlockSize, subBlockSize) : hostBlockSize;
+    maxBlockSize = subBlockSize > 0 ? juce::jmin(hostBlockSize, subBlockSize * granularSubBlockFactor) : hostBlockSize;
+    granularFeedbackDelay = juce::jmax(2, hostBlockSize);
+    currentSampleRate = sampleRate;
+
+    // the ring buffer is allocated once at the maximum delay, delay time changes only move the read head
+    delayBuffer.prepare(numChannels, static_cast<int>(std::ceil(sampleRate * maxDelaySeconds)), maxBlockSize, delayStorage);
+
+    mipmap.prepare(numChannels, delayBuffer.getCapacity(), maxBlockSize);
+
+    delayTimeRamp.reset(sampleRate, delayGlideSeconds);
+    delayTimeNeedsReset = true;
+    delayTimeBuffer.setSize(1, maxBlockSize);
+    feedbackRamp.reset(sampleRate, mixGlideSeconds);
+    wetDryRamp.reset(sampleRate, mixGlideSeconds);
+    rampsNeedReset = true;
+    rampBuffer.setSize(2, maxBlockSize);
+    blockBuffer.setSize(numChannels, maxBlockSize);
+    tapBuffer.setSize(numChannels, maxBlockSize);
+    writeBuffer.setSize(numChannels, maxBlockSize);
+    wideBlockBuffer.setSize(doublePrecision ? numChannels : 0, doublePrecision ? maxBlockSize : 0);
+    wideWriteBuffer.setSize(doublePrecision ? numChannels : 0, doublePrecision ? maxBlockSize : 0);
+    shaper.prepare(sampleRate, numChannels, maxBlockSize, doublePrecision);
+    multiTap.prepare(sampleRate, numChannels, maxBlockSize, delayGlideSeconds);
+
+    // history the delay line can't hold goes to the store, reads on top of it reach
+    // back by up to the spread plus a grain length and run up to the block end
+    grainHistorySeconds = juce::jmin(grainHistorySeconds, maxGrainHistorySeconds);
+    int grainHistorySamples = 0;
+    if (grainHistorySeconds > maxDelaySeconds)
+    {
+        grainHistorySamples = static_cast<int>(std::ceil(sampleRate * grainHistorySeconds));
+    }
+    auto maxGrainReach = static_cast<int>(std::ceil(sampleRate * (grainProcessor::maxGrainSpreadMs + grainProcessor::maxGrainSizeMs) / 1000.0));
+    history.prepare(numChannels, grainHistorySamples, delayBuffer.getCapacity() + maxGrainReach + maxBlockSize);
+
+    grainProcessor.prepare(sampleRate, numChannels, maxBlockSize, delayBuffer.getCapacity(), history.getCapacity());
+    visualFeed.prepare(sampleRate, maxBlockSize);
+    reverb.prepare(sampleRate, maxBlockSize);
+    spectral.prepare(sampleRate, numChannels, maxBlockSize, maxDelaySeconds);
+
+    // the ring starts out cleared, so it already counts as silent
+    silentHistorySamples = getHistoryCapacity();
+    bypassed = false;
 }
 
-void delayProcessor::process(juce::AudioBuffer<float>& buffer,
+template <typename SampleType>
+void delayProcessor::process(juce::AudioBuffer<SampleType>& buffer,
     float delaySeconds, float feedback, float wetDry,
     float gainBegin, float gainEnd, double sampleRate,
     bool granularMode,
     float grainSize, float grainDensity,
-    float grainPitch, float grainSpread)
+    float grainPitch, float grainSpread, float grainHistorySeconds)
 {
-    if (granularMode) {
+    jassert(maxBlockSize > 0);
+    if (maxBlockSize <= 0)
+    {
+        return;
+    }
+
+    // the double scratch only exists when it was asked for at prepare time
+    if constexpr (std::is_same_v<SampleType, double>)
+    {
+        jassert(doublePrecision);
+        if (!doublePrecision)
+        {
+            return;
+        }
+    }
+
+    // a grain job the workers were given up on last block may still be reading the delay line
+    grainProcessor.finishAbandonedJobs();
+
+    // bigger blocks go through the whole chain one sub-block at a time, so a sub-block's
+    // samples stay in cache from the read to the write back. that covers hosts sending
+    // bigger blocks than they announced as well, the scratch buffers never have to grow
+    int numSamples = buffer.getNumSamples();
+    int chunkSize = granularMode && !spectralMode ? maxBlockSize : subBlockFrames;
+    if (numSamples > chunkSize)
+    {
+        auto gainStep = (gainEnd - gainBegin) / static_cast<float>(numSamples);
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            // referencing constructor, uses the buffer's preallocated channel array
+            int length = juce::jmin(chunkSize, numSamples - start);
+            juce::AudioBuffer<SampleType> chunk(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, length);
+
+            // the gain ramps over the host's block, each sub-block takes its stretch of it
+            process(chunk, delaySeconds, feedback, wetDry,
+                gainBegin + gainStep * static_cast<float>(start), gainBegin + gainStep * static_cast<float>(start + length),
+                sampleRate, granularMode, grainSize, grainDensity, grainPitch, grainSpread, grainHistorySeconds);
+        }
+        return;
+    }
+
+    // nothing coming in and nothing audible left in the history, skip the whole path
+    if (canBypass(buffer, granularMode, grainSize, grainSpread, grainHistorySeconds))
+    {
+        if (!bypassed)
+        {
+            // clearing once on the way in means nothing below the threshold can come back
+            // later, when a longer delay time reaches further into the history
+            resetHistory();
+            grainProcessor.reset();
+            delayTimeNeedsReset = true;
+            rampsNeedReset = true;
+            bypassed = true;
+
+            // cleared counts as silent, or the reset delay time would reach the whole
+            // history and the next sub-block couldn't bypass
+            silentHistorySamples = getHistoryCapacity();
+        }
+        buffer.clear();
+
+        // the display keeps scrolling through the silence
+        if (visualFeed.isActive())
+        {
+            visualFeed.endBlock(numSamples);
+        }
+        return;
+    }
+    bypassed = false;
+    granularBlock = granularMode && !spectralMode;
+    fillParameterRamps(numSamples, feedback, wetDry);
+    reverbInLoop = false;
+    writtenPeak = 0.0f;
+
+    if (spectralMode) {
+        // frames pick their parameters up a hop at a time, the ramps' values at the block end are smooth enough
+        processSpectralDelay(buffer, delaySeconds, feedbackRamp.getCurrentValue(), wetDryRamp.getCurrentValue(),
+            gainBegin, gainEnd);
+    } else if (granularMode) {
         processGranularDelay(buffer, delaySeconds, feedback, wetDry,
                            gainBegin, gainEnd, sampleRate,
-                           grainSize, grainDensity, grainPitch, grainSpread);
+                           grainSize, grainDensity, grainPitch, grainSpread, grainHistorySeconds);
+    } else if (multiTapMode) {
+        processMultiTapDelay(buffer, delaySeconds, feedback, wetDry,
+                           gainBegin, gainEnd, sampleRate);
     } else {
         processStandardDelay(buffer, delaySeconds, feedback, wetDry,
                            gainBegin, gainEnd, sampleRate);
     }
+
+    // the reverb follows the delay unless the standard loop already ran it
+    if (reverbMix > 0.0f && !reverbInLoop)
+    {
+        reverb.process(buffer.getArrayOfWritePointers(), juce::jmin(2, buffer.getNumChannels()), numSamples, reverbMix);
+    }
+
+    if (writtenPeak < silenceThreshold)
+    {
+        silentHistorySamples = juce::jmin(silentHistorySamples + numSamples, getHistoryCapacity());
+    }
+    else
+    {
+        silentHistorySamples = 0;
+    }
 }
 
-void delayProcessor::fillBuffer(int channel, int bufferSize, int delayBufferSize, float* channelData)
+void delayProcessor::collectTelemetry(telemetryFrame& frame)
 {
-    if (delayBufferSize > bufferSize + writePosition)
+    wetMeter.add(grainProcessor.getWetMeter());
+    grainProcessor.getWetMeter().clear();
+    wetMeter.add(spectral.getWetMeter());
+    spectral.getWetMeter().clear();
+
+    const auto& grains = grainProcessor.getGrainPool();
+    frame.activeGrains = static_cast<uint32_t>(grains.getNumActive());
+    frame.grainsSpawned = grains.getNumSpawned();
+    frame.grainsStolen = grains.getNumStolen();
+    frame.grainsRejected = grains.getNumRejected();
+
+    frame.wetPeak = wetMeter.peak;
+    frame.wetRms = wetMeter.getRms();
+    frame.feedbackPeak = feedbackMeter.peak;
+    frame.feedbackRms = feedbackMeter.getRms();
+    frame.flags |= feedbackMeter.getFlags() | wetMeter.getFlags();
+    if (bypassed)
     {
-        delayBuffer.copyFrom(channel, writePosition, channelData, bufferSize);
+        frame.flags |= telemetryFlags::bypassed;
     }
-    else
+
+    wetMeter.clear();
+    feedbackMeter.clear();
+}
+
+void delayProcessor::setReverb(fdnReverb::Position position, float mix, float decaySeconds, float damping)
+{
+    reverbPosition = position;
+    reverb.setParameters(decaySeconds, damping);
+
+    // switched off: the old tail mustn't come back when it's switched on again
+    if (mix <= 0.0f && reverbMix > 0.0f)
     {
-        auto numSamplesToEnd = delayBufferSize - writePosition;
-        delayBuffer.copyFrom(channel, writePosition, channelData, numSamplesToEnd);
-        auto numSamplesAtStart = bufferSize - numSamplesToEnd;
-        channelData += numSamplesToEnd;
-        delayBuffer.copyFrom(channel, 0, channelData, numSamplesAtStart);
+        reverb.reset();
     }
+    reverbMix = juce::jlimit(0.0f, 1.0f, mix);
 }
 
-void delayProcessor::processStandardDelay(juce::AudioBuffer<float>& buffer,
-    float delaySeconds, float feedback, float wetDry,
-    float gainBegin, float gainEnd, double sampleRate)
+void delayProcessor::setMultiTap(bool enabled, multiTapDelay::Pattern pattern, int numTaps, uint32_t seed)
 {
-    int bufferSize = buffer.getNumSamples();
-    int totalNumInputChannels = buffer.getNumChannels();
-    int delayBufferSize = delayBuffer.getNumSamples();
+    multiTap.setPattern(pattern, numTaps, seed);
 
-    delaySeconds = std::clamp(delaySeconds, 0.01f, 10.0f);
-    int newDelayBufferSize = static_cast<int>(sampleRate * delaySeconds);
+    // switched on: the taps come in at their pattern, not gliding over from where they were left
+    if (enabled && !multiTapMode)
+    {
+        multiTap.reset();
+    }
+    multiTapMode = enabled;
+}
 
-    if (newDelayBufferSize != bufferSize)
+void delayProcessor::setSpectral(bool enabled, bool freeze, float smear)
+{
+    spectral.setFreeze(freeze);
+    spectral.setSmear(smear);
+
+    // switched on: whatever was left in its loop from last time stays there
+    if (enabled && !spectralMode)
     {
-        delayBuffer.setSize(totalNumInputChannels, newDelayBufferSize, true, false, false);
-        writePosition =  writePosition % newDelayBufferSize;
-        delayBufferSize = newDelayBufferSize;
-        previousDelaySeconds = delaySeconds;
+        spectral.reset();
     }
+    spectralMode = enabled;
+}
 
-    juce::AudioBuffer<float> dryBuffer;
-    dryBuffer.makeCopyOf(buffer);
+void delayProcessor::resetHistory()
+{
+    delayBuffer.reset();
+    mipmap.reset();
+    history.reset();
+    reverb.reset();
+    shaper.reset();
+    spectral.reset();
+}
 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+void delayProcessor::advanceHistory(int numSamples)
+{
+    if (visualFeed.isActive())
     {
-        auto* channelData = buffer.getWritePointer(channel);
-        auto* dryChannelData = dryBuffer.getReadPointer(channel);
+        feedVisuals(numSamples);
+    }
 
-        auto readPosition = writePosition - static_cast<int>(delaySeconds * sampleRate);
-        if (readPosition < 0)
-        {
-            readPosition += delayBufferSize;
-        }
+    // both pick the block up from the delay line before its write position moves on
+    mipmap.append(delayBuffer, numSamples);
+    history.append(delayBuffer, numSamples);
+    delayBuffer.advance(numSamples);
+}
 
-        juce::AudioBuffer<float> delayedBuffer(2, bufferSize);
-        auto* delayedData = delayedBuffer.getWritePointer(0);
+void delayProcessor::feedVisuals(int numSamples)
+{
+    // the block that was just written, before the write position moves on
+    auto* block = blockBuffer.getWritePointer(0);
+    for (int channel = 0; channel < delayBuffer.getNumChannels(); ++channel)
+    {
+        delayBuffer.readSpan(channel, delayBuffer.getWritePosition(), numSamples, block);
+        visualFeed.addChannel(block, numSamples);
+    }
+    visualFeed.endBlock(numSamples);
 
-        if (readPosition + bufferSize <= delayBufferSize)
+    if (visualFeed.wantsGrainSnapshot(numSamples))
+    {
+        if (granularBlock)
         {
-            delayedBuffer.copyFromWithRamp(0, 0, delayBuffer.getReadPointer(channel, readPosition),
-                bufferSize, gainBegin, gainEnd);
+            grainProcessor.fillGrainSnapshot(grainSnapshot);
         }
         else
         {
-            auto numSamplesToEnd = delayBufferSize - readPosition;
-            auto numSamplesAtStart = bufferSize - numSamplesToEnd;
+            grainSnapshot.numGrains = 0;
+        }
+        visualFeed.pushGrains(grainSnapshot);
+    }
+}
 
-            delayedBuffer.copyFromWithRamp(0, 0, delayBuffer.getReadPointer(channel, readPosition),
-                numSamplesToEnd, gainBegin, gainEnd);
-            delayedBuffer.copyFromWithRamp(0, numSamplesToEnd, delayBuffer.getReadPointer(channel, 0),
-                numSamplesAtStart, gainBegin, gainEnd);
+int delayProcessor::getGrainHistorySamples(float grainHistorySeconds) const
+{
+    if (!history.isEnabled() || grainHistorySeconds <= 0.0f)
+    {
+        return 0;
+    }
+    auto samples = static_cast<int>(currentSampleRate * grainHistorySeconds);
+    return juce::jlimit(1, history.getMaxHistorySamples(), samples);
+}
+
+int delayProcessor::getReachableHistory(bool granularMode, float grainSize, float grainSpread,
+    float grainHistorySeconds, int bufferSize) const
+{
+    if (delayTimeNeedsReset)
+    {
+        // the first block after a reset can jump anywhere
+        return getHistoryCapacity();
+    }
+
+    auto delaySamples = juce::jmax(delayTimeRamp.getCurrentValue(), delayTimeRamp.getTargetValue());
+
+    if (!granularMode)
+    {
+        // plus the lagrange taps
+        return static_cast<int>(delaySamples) + 4;
+    }
+
+    // grains start up to the history plus the spread back, and a grain that is still
+    // playing started up to its length ago. the feedback tap is one host block back
+    auto msToSamples = static_cast<float>(currentSampleRate / 1000.0);
+    auto grainHistory = juce::jmax(delaySamples, static_cast<float>(getGrainHistorySamples(grainHistorySeconds)));
+    return static_cast<int>(grainHistory + (grainSpread + grainSize) * msToSamples) + juce::jmax(bufferSize, granularFeedbackDelay) + 4;
+}
+
+template <typename SampleType>
+bool delayProcessor::canBypass(const juce::AudioBuffer<SampleType>& buffer, bool granularMode, float grainSize, float grainSpread,
+    float grainHistorySeconds) const
+{
+    int numSamples = buffer.getNumSamples();
+    if (reverbMix > 0.0f && reverb.isRinging())
+    {
+        return false;
+    }
+    if (spectralMode && spectral.isRinging())
+    {
+        return false;
+    }
+    if (silentHistorySamples < getReachableHistory(granularMode, grainSize, grainSpread, grainHistorySeconds, numSamples))
+    {
+        return false;
+    }
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        if (buffer.getMagnitude(channel, 0, numSamples) >= static_cast<SampleType>(silenceThreshold))
+        {
+            return false;
         }
-        for (int sample = 0; sample < bufferSize; ++sample)
+    }
+    return true;
+}
+
+double delayProcessor::getTailLengthSeconds(float delaySeconds, float feedback, bool granularMode, float grainSize,
+    float grainHistorySeconds, bool spectralEnabled, bool spectralFreeze, float spectralSmear) const
+{
+    delaySeconds = std::clamp(delaySeconds, 0.01f, 10.0f);
+    feedback = std::abs(feedback);
+    if (feedback >= 0.999f)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    // repeats until feedback^n drops below the threshold
+    double repeats = 0.0;
+    if (feedback > silenceThreshold)
+    {
+        repeats = std::ceil(std::log(static_cast<double>(silenceThreshold)) / std::log(static_cast<double>(feedback)));
+    }
+
+    if (spectralEnabled)
+    {
+        if (spectralFreeze)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        // the echoes come out a latency late, and smear lets each frame fade over many hops
+        spectralSmear = juce::jlimit(0.0f, spectralProcessor::maxSmear, spectralSmear);
+        double smearSeconds = 0.0;
+        if (spectralSmear > 0.0f)
         {
-            float wetSignal = delayedData[sample];
-            float drySignal = dryChannelData[sample];
-            channelData[sample] = drySignal * (1.0f - wetDry) + wetSignal * wetDry;
+            smearSeconds = std::log(static_cast<double>(silenceThreshold)) / std::log(static_cast<double>(spectralSmear))
+                           * spectralProcessor::hopSize / currentSampleRate;
         }
+        return delaySeconds * (repeats + 1.0) + spectralProcessor::getLatencySamples() / currentSampleRate
+               + smearSeconds;
+    }
 
-        juce::AudioBuffer<float> feedbackBuffer(2, bufferSize);
-        feedbackBuffer.copyFrom(0, 0, dryChannelData, bufferSize);
-        feedbackBuffer.addFromWithRamp(0, 0, delayedData, bufferSize, feedback, feedback);
+    if (!granularMode)
+    {
+        return delaySeconds * (repeats + 1.0);
+    }
 
-        fillBuffer(channel, bufferSize, delayBufferSize, feedbackBuffer.getWritePointer(0));
+    // the granular feedback loop goes round once per host block, and grains can pick up
+    // anything from the history they draw from and keep playing for a grain length
+    auto blockSeconds = static_cast<double>(granularFeedbackDelay) / currentSampleRate;
+    auto grainHistory = juce::jmax(static_cast<double>(delaySeconds),
+        getGrainHistorySamples(grainHistorySeconds) / currentSampleRate);
+    return grainHistory + blockSeconds * repeats + grainSize / 1000.0;
+}
+
+float delayProcessor::getDelayTimeTarget(float delaySeconds, double sampleRate) const
+{
+    delaySeconds = std::clamp(delaySeconds, 0.01f, 10.0f);
+    auto delaySamples = static_cast<float>(sampleRate * delaySeconds);
+    return juce::jlimit(2.0f, static_cast<float>(delayBuffer.getMaxDelaySamples()), delaySamples);
+}
+
+const float* delayProcessor::fillDelayTimes(int numSamples, float delaySeconds, double sampleRate)
+{
+    // one glide curve per block, shared by every channel. what's written reaches the line
+    // the shaper's latency late, so the read head sits that much closer, and a quality
+    // change glides instead of jumping
+    auto target = juce::jmax(2.0f, getDelayTimeTarget(delaySeconds, sampleRate) - shaper.getLatencySamples());
+    if (delayTimeNeedsReset)
+    {
+        delayTimeRamp.setCurrentAndTargetValue(target);
+        delayTimeNeedsReset = false;
     }
-    writePosition += bufferSize;
-    writePosition %= delayBufferSize;
+    delayTimeRamp.setTargetValue(target);
+
+    auto* delayTimes = delayTimeBuffer.getWritePointer(0);
+    delayTimeRamp.fill(delayTimes, numSamples);
+    return delayTimes;
 }
 
-void delayProcessor::processGranularDelay(juce::AudioBuffer<float>& buffer,
+void delayProcessor::fillParameterRamps(int numSamples, float feedback, float wetDry)
+{
+    // the first block after a reset starts where the parameters are
+    if (rampsNeedReset)
+    {
+        feedbackRamp.setCurrentAndTargetValue(feedback);
+        wetDryRamp.setCurrentAndTargetValue(wetDry);
+        rampsNeedReset = false;
+    }
+    feedbackRamp.setTargetValue(feedback);
+    wetDryRamp.setTargetValue(wetDry);
+
+    // settled, the paths use the plain values and the mix kernels picked for them
+    rampsMoving = feedbackRamp.isSmoothing() || wetDryRamp.isSmoothing();
+    if (rampsMoving)
+    {
+        feedbackRamp.fill(rampBuffer.getWritePointer(0), numSamples);
+        wetDryRamp.fill(rampBuffer.getWritePointer(1), numSamples);
+    }
+}
+
+template <typename SampleType>
+void delayProcessor::processStandardDelay(juce::AudioBuffer<SampleType>& buffer,
     float delaySeconds, float feedback, float wetDry,
-    float gainBegin, float gainEnd, double sampleRate,
-    float grainSize, float grainDensity, float grainPitch, float grainSpread)
+    float gainBegin, float gainEnd, double sampleRate)
 {
     int bufferSize = buffer.getNumSamples();
-    int totalNumInputChannels = buffer.getNumChannels();
-    int delayBufferSize = delayBuffer.getNumSamples();
+    int totalNumInputChannels = juce::jmin(buffer.getNumChannels(), delayBuffer.getNumChannels());
+    auto& wetBuffer = getBlockBuffer<SampleType>();
+    auto& loopBuffer = getWriteBuffer<SampleType>();
 
-    delaySeconds = std::clamp(delaySeconds, 0.01f, 10.0f);
-    int newDelayBufferSize = static_cast<int>(sampleRate * delaySeconds);
+    auto* delayTimes = fillDelayTimes(bufferSize, delaySeconds, sampleRate);
+
+    auto gainStep = (gainEnd - gainBegin) / static_cast<float>(bufferSize);
+    float peak = 0.0f;
+    float feedbackSquares = 0.0f;
+
+    // the mix is picked once for the block, fully wet or dry, no feedback and a flat
+    // gain each get a kernel that leaves that part out
+    auto mix = mixKernels::getKernel<SampleType, SampleType>(rampsMoving ? mixKernels::shape::smoothedRamps()
+        : mixKernels::shape::of(gainBegin, gainEnd, wetDry, feedback, totalNumInputChannels));
+    mixRun<SampleType, SampleType> run { buffer.getArrayOfWritePointers(), 0, wetBuffer.getArrayOfReadPointers(),
+        wetBuffer.getArrayOfReadPointers(), loopBuffer.getArrayOfWritePointers(), totalNumInputChannels, 0,
+        gainBegin, gainStep, 0, wetDry, feedback, rampBuffer.getReadPointer(1), rampBuffer.getReadPointer(0) };
+
+    // a run no longer than the delay never reads what it writes, so it can be read up front
+    // (a 16-bit delay line converted in one go), diffused by the reverb and shaped as a block
+    // before it's written back. with the 10 ms minimum delay that's the whole block unless
+    // the host's blocks are very long
+    int runLength = juce::jlimit(1, bufferSize, static_cast<int>(juce::jmin(delayTimes[0], delayTimes[bufferSize - 1])) - 1);
+    reverbInLoop = reverbMix > 0.0f && reverbPosition == fdnReverb::Position::feedbackLoop;
+
+    for (int start = 0; start < bufferSize; start += runLength)
+    {
+        int numSamples = juce::jmin(runLength, bufferSize - start);
+
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        {
+            delayBuffer.readBlock(channel, start, delayTimes + start, numSamples, interpolation, wetBuffer.getWritePointer(channel));
+        }
+
+        // in the loop the reverb needs every channel's taps at once
+        if (reverbInLoop)
+        {
+            reverb.process(wetBuffer.getArrayOfWritePointers(), juce::jmin(2, totalNumInputChannels), numSamples, reverbMix);
+        }
+
+        // the loop is the wet signal itself
+        run.outputOffset = start;
+        run.rampPosition = start;
+        run.numSamples = numSamples;
+        mix(run);
+
+        writeRun<SampleType>(start, numSamples, totalNumInputChannels, peak, feedbackSquares);
+    }
+    writtenPeak = juce::jmax(writtenPeak, peak);
+    wetMeter.add(run.wetPeak, run.wetSquares, bufferSize * totalNumInputChannels);
+    feedbackMeter.add(peak, feedbackSquares, bufferSize * totalNumInputChannels);
+
+    advanceHistory(bufferSize);
+}
+
+template <typename SampleType>
+void delayProcessor::writeRun(int start, int numSamples, int numChannels, float& peak, float& squares)
+{
+    // tone and saturation, then into the line
+    auto& loopBuffer = getWriteBuffer<SampleType>();
+    shaper.process(loopBuffer.getArrayOfWritePointers(), numChannels, numSamples);
 
-    if (newDelayBufferSize != bufferSize)
+    for (int channel = 0; channel < numChannels; ++channel)
     {
-        delayBuffer.setSize(totalNumInputChannels, newDelayBufferSize, true, false, false);
-        writePosition = writePosition % newDelayBufferSize;
-        delayBufferSize = newDelayBufferSize;
-        previousDelaySeconds = delaySeconds;
-        grainProcessor.prepare(sampleRate, totalNumInputChannels, delaySeconds);
+        const SampleType* written = loopBuffer.getReadPointer(channel);
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            peak = juce::jmax(peak, static_cast<float>(std::abs(written[sample])));
+            squares += static_cast<float>(written[sample] * written[sample]);
+        }
+        delayBuffer.writeBlock(channel, start, written, numSamples);
     }
+}
 
-    // Store dry signal
-    juce::AudioBuffer<float> dryBuffer;
-    dryBuffer.makeCopyOf(buffer);
+template <typename SampleType>
+void delayProcessor::processSpectralDelay(juce::AudioBuffer<SampleType>& buffer,
+    float delaySeconds, float feedback, float wetDry, float gainBegin, float gainEnd)
+{
+    int bufferSize = buffer.getNumSamples();
+    int totalNumInputChannels = juce::jmin(buffer.getNumChannels(), delayBuffer.getNumChannels());
 
-    // Fill delay buffer with input + feedback first
+    // the delay line keeps recording the input, so the display carries on and the other
+    // modes find a history when they're switched back to
+    float peak = 0.0f;
     for (int channel = 0; channel < totalNumInputChannels; ++channel)
     {
-        auto* channelData = buffer.getWritePointer(channel);
-        auto* dryChannelData = dryBuffer.getReadPointer(channel);
+        const auto* channelData = buffer.getReadPointer(channel);
+        for (int sample = 0; sample < bufferSize; ++sample)
+        {
+            peak = juce::jmax(peak, static_cast<float>(std::abs(channelData[sample])));
+        }
+        delayBuffer.writeBlock(channel, 0, channelData, bufferSize);
+    }
+    writtenPeak = juce::jmax(writtenPeak, peak);
+    advanceHistory(bufferSize);
+
+    spectral.process(buffer, std::clamp(delaySeconds, 0.01f, 10.0f), feedback, wetDry, gainBegin, gainEnd);
+}
+
+template <typename SampleType>
+void delayProcessor::processMultiTapDelay(juce::AudioBuffer<SampleType>& buffer,
+    float delaySeconds, float feedback, float wetDry,
+    float gainBegin, float gainEnd, double sampleRate)
+{
+    int bufferSize = buffer.getNumSamples();
+    int totalNumInputChannels = juce::jmin(buffer.getNumChannels(), delayBuffer.getNumChannels());
+    auto& delayedBuffer = getBlockBuffer<SampleType>();
+    auto& loopBuffer = getWriteBuffer<SampleType>();
+    auto* delayTimes = fillDelayTimes(bufferSize, delaySeconds, sampleRate);
+
+    auto gainStep = (gainEnd - gainBegin) / static_cast<float>(bufferSize);
+    float peak = 0.0f;
+    float feedbackSquares = 0.0f;
 
-        // Create feedback buffer (input + delayed signal with feedback)
-        juce::AudioBuffer<float> feedbackBuffer(2, bufferSize);
-        feedbackBuffer.copyFrom(0, 0, dryChannelData, bufferSize);
+    // the taps are the wet signal, the loop goes round at the delay size whatever they do
+    auto mix = mixKernels::getKernel<SampleType, float>(rampsMoving ? mixKernels::shape::smoothedRamps()
+        : mixKernels::shape::of(gainBegin, gainEnd, wetDry, feedback, totalNumInputChannels));
+    mixRun<SampleType, float> run { buffer.getArrayOfWritePointers(), 0, tapBuffer.getArrayOfReadPointers(),
+        delayedBuffer.getArrayOfReadPointers(), loopBuffer.getArrayOfWritePointers(), totalNumInputChannels, 0,
+        gainBegin, gainStep, 0, wetDry, feedback, rampBuffer.getReadPointer(1), rampBuffer.getReadPointer(0) };
 
-        // Add feedback from delay buffer if we have enough history
-        if (writePosition >= bufferSize) {
-            auto readPos = writePosition - bufferSize;
-            feedbackBuffer.addFromWithRamp(0, 0, delayBuffer.getReadPointer(channel, readPos),
-                                         bufferSize, feedback, feedback);
+    // every tap and the feedback are read a run at a time, so a run can't be longer than
+    // the shortest of them. that's the whole block unless a tap is very short
+    int runLength = juce::jlimit(1, bufferSize, static_cast<int>(multiTap.getShortestDelay(delayTimes, bufferSize)) - 1);
+
+    for (int start = 0; start < bufferSize; start += runLength)
+    {
+        int numSamples = juce::jmin(runLength, bufferSize - start);
+
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        {
+            juce::FloatVectorOperations::clear(tapBuffer.getWritePointer(channel), numSamples);
         }
+        multiTap.process(delayBuffer, start, delayTimes + start, numSamples, interpolation,
+            tapBuffer.getArrayOfWritePointers(), totalNumInputChannels);
 
-        fillBuffer(channel, bufferSize, delayBufferSize, feedbackBuffer.getWritePointer(0));
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        {
+            delayBuffer.readBlock(channel, start, delayTimes + start, numSamples, interpolation,
+                delayedBuffer.getWritePointer(channel));
+        }
+
+        run.outputOffset = start;
+        run.rampPosition = start;
+        run.numSamples = numSamples;
+        mix(run);
+
+        writeRun<SampleType>(start, numSamples, totalNumInputChannels, peak, feedbackSquares);
     }
+    writtenPeak = juce::jmax(writtenPeak, peak);
+    wetMeter.add(run.wetPeak, run.wetSquares, bufferSize * totalNumInputChannels);
+    feedbackMeter.add(peak, feedbackSquares, bufferSize * totalNumInputChannels);
 
-    // Process granular delay
-    grainProcessor.process(buffer, delayBuffer, writePosition,
-                         grainSize, grainDensity, grainPitch, grainSpread, wetDry);
+    advanceHistory(bufferSize);
+}
+
+template <typename SampleType>
+void delayProcessor::processGranularDelay(juce::AudioBuffer<SampleType>& buffer,
+    float delaySeconds, float feedback, float wetDry,
+    float gainBegin, float gainEnd, double sampleRate,
+    float grainSize, float grainDensity, float grainPitch, float grainSpread, float grainHistorySeconds)
+{
+    int bufferSize = buffer.getNumSamples();
+    int totalNumInputChannels = juce::jmin(buffer.getNumChannels(), delayBuffer.getNumChannels());
+
+    // grains are drawn from the last delaySeconds of history, following the same glide
+    auto target = getDelayTimeTarget(delaySeconds, sampleRate);
+    if (delayTimeNeedsReset)
+    {
+        delayTimeRamp.setCurrentAndTargetValue(target);
+        delayTimeNeedsReset = false;
+    }
+    delayTimeRamp.setTargetValue(target);
+    auto historySamples = static_cast<int>(delayTimeRamp.skip(bufferSize));
+
+    // with a history store grains can reach further back than any delay time
+    historySamples = juce::jmax(historySamples, getGrainHistorySamples(grainHistorySeconds));
 
-    // Mix dry signal back in (grain processor handles wet/dry internally, but we can adjust)
+    // Fill delay buffer with input + feedback first, the feedback comes from one host block
+    // back. that's a whole number of samples and never reaches this sub-block, so it is
+    // read as one span and the sub-block is written in one go
+    auto* block = blockBuffer.getWritePointer(0);
+    const float* feedbackValues = rampsMoving ? rampBuffer.getReadPointer(0) : nullptr;
+    float peak = 0.0f;
     for (int channel = 0; channel < totalNumInputChannels; ++channel)
     {
-        auto* channelData = buffer.getWritePointer(channel);
-        auto* dryChannelData = dryBuffer.getReadPointer(channel);
+        auto* channelData = buffer.getReadPointer(channel);
+        delayBuffer.readSpan(channel, delayBuffer.getWritePosition() - granularFeedbackDelay, bufferSize, block);
 
         for (int sample = 0; sample < bufferSize; ++sample)
         {
-            // Apply gain ramping to the final output
-            float gainRamp = gainBegin + (gainEnd - gainBegin) * (static_cast<float>(sample) / bufferSize);
-            channelData[sample] *= gainRamp;
+            float sampleFeedback = feedbackValues != nullptr ? feedbackValues[sample] : feedback;
+            float written = static_cast<float>(channelData[sample]) + block[sample] * sampleFeedback;
+            peak = juce::jmax(peak, std::abs(written));
+            block[sample] = written;
         }
+        feedbackMeter.add(block, bufferSize);
+        delayBuffer.writeBlock(channel, 0, block, bufferSize);
     }
+    writtenPeak = juce::jmax(writtenPeak, peak);
 
-    writePosition += bufferSize;
-    writePosition %= delayBufferSize;
+    // Process granular delay
+    grainProcessor.process(buffer, delayBuffer, history, mipmap, historySamples,
+                         grainSize, grainDensity, grainPitch, grainSpread, wetDry,
+                         rampsMoving ? rampBuffer.getReadPointer(1) : nullptr);
+
+    // grain processor handles wet/dry internally, the gain ramps over the whole output,
+    // dry included, so it stays out of the grains' mix kernel. a flat gain is one multiply
+    // per sample and unity gain none
+    if (gainBegin != gainEnd)
+    {
+        auto gainStep = (gainEnd - gainBegin) / static_cast<float>(bufferSize);
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        {
+            auto* channelData = buffer.getWritePointer(channel);
+            for (int sample = 0; sample < bufferSize; ++sample)
+            {
+                channelData[sample] *= gainBegin + gainStep * static_cast<float>(sample);
+            }
+        }
+    }
+    else if (gainBegin != 1.0f)
+    {
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        {
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel), static_cast<SampleType>(gainBegin), bufferSize);
+        }
+    }
+
+    advanceHistory(bufferSize);
 }
+
+template void delayProcessor::process<float>(juce::AudioBuffer<float>&, float, float, float, float, float, double,
+    bool, float, float, float, float, float);
+template void delayProcessor::process<double>(juce::AudioBuffer<double>&, float, float, float, float, float, double,
+    bool, float, float, float, float, float);
@@ -3,7 +3,16 @@
 //
 #pragma once
 
+#include "delayLine.h"
+#include "delayMipmap.h"
+#include "fdnReverb.h"
+#include "feedbackShaper.h"
 #include "grainProcessor.h"
+#include "historyStore.h"
+#include "mixKernels.h"
+#include "multiTapDelay.h"
+#include "parameterRamp.h"
+#include "spectralProcessor.h"
 #include <juce_audio_processors/juce_audio_processors.h>
 
 #ifndef DELAYPROCESSOR_H
@@ -14,27 +23,228 @@
 class delayProcessor {
 public:
     delayProcessor();
-    void prepare(double sampleRate, int numChannels, float maxDelaySeconds);
-    void process(juce::AudioBuffer<float>& buffer,
+
+    // everything the audio thread touches is sized here, process() never allocates.
+    // grainHistorySeconds beyond maxDelaySeconds adds a compressed history store for grains
+    void prepare(double sampleRate, int numChannels, int hostBlockSize, float maxDelaySeconds,
+        float grainHistorySeconds = 0.0f);
+
+    // host blocks longer than this are processed in sub-blocks of it, each one through
+    // every stage before the next, so the working set stays in L1 however big the host's
+    // blocks are. granular mode uses granularSubBlockFactor times as many frames. 0
+    // processes host blocks whole. takes effect at the next prepare()
+    void setSubBlockSize(int frames) { subBlockSize = frames; }
+    static constexpr int defaultSubBlockSize = 128;
+    static constexpr int granularSubBlockFactor = 4;
+
+    // grainHistorySeconds is how far back grains reach, 0 follows the delay time.
+    // float or double, double needs setDoublePrecision(true) before prepare()
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer,
         float delaySeconds, float feedback, float wetDry,
         float gainBegin, float gainEnd, double sampleRate,
         bool granularMode = false, float grainSize = 100.0f, float grainDensity = 10.0f,
-        float grainPitch = 1.0f, float grainSpread = 50.0f);
+        float grainPitch = 1.0f, float grainSpread = 50.0f, float grainHistorySeconds = 0.0f);
+
+    void setGrainStealPolicy(grainPool::StealPolicy policy) { grainProcessor.setStealPolicy(policy); }
+    void setGrainShape(grainWindows::Shape shape, float taper) { grainProcessor.setGrainShape(shape, taper); }
+    void setGrainSeed(uint32_t seed) { grainProcessor.setSeed(seed); }
+    void setParallelGrains(bool shouldRenderInParallel) { grainProcessor.setParallelRendering(shouldRenderInParallel); }
+    // off the audio thread, the first time parallel grains are switched on
+    void startGrainWorkers() { grainProcessor.startWorkers(); }
+    int getNumGrainWorkers() const { return grainProcessor.getNumWorkers(); }
+    void setGrainBudget(float densityScale, float grainLimit) { grainProcessor.setGrainBudget(densityScale, grainLimit); }
+
+    // read interpolation of the standard delay, granular mode always reads linearly
+    void setInterpolation(delayLine::Interpolation newInterpolation) { interpolation = newInterpolation; }
+
+    // the diffuse tail, off while mix is 0. granular mode always runs it on the output
+    void setReverb(fdnReverb::Position position, float mix, float decaySeconds, float damping);
+
+    // tone and saturation of everything the standard and multi-tap delays write, and the
+    // oversampling they run at. granular mode's loop isn't shaped
+    void setFeedbackShape(float lowCutHz, float highCutHz, float drive) { shaper.setParameters(lowCutHz, highCutHz, drive); }
+    void setQuality(feedbackShaper::Quality quality) { shaper.setQuality(quality); }
+
+    // the standard delay with up to multiTapDelay::maxTaps read heads instead of one,
+    // the feedback still comes round once per delay size. granular mode takes precedence
+    void setMultiTap(bool enabled, multiTapDelay::Pattern pattern, int numTaps, uint32_t seed);
+    multiTapDelay& getMultiTap() { return multiTap; }
+
+    // the stft delay: magnitude echoes, smeared over time and frozen on request. takes
+    // precedence over granular and multi-tap, and delays the whole output by getLatencySamples()
+    void setSpectral(bool enabled, bool freeze, float smear);
+    bool isSpectral() const { return spectralMode; }
+
+    // what the host has to compensate for with the current mode
+    int getLatencySamples() const { return spectralMode ? spectralProcessor::getLatencySamples() : 0; }
+
+    // sample format of the delay line, takes effect at the next prepare()
+    void setDelayStorage(delayLine::Storage storage) { delayStorage = storage; }
+
+    // sizes the double scratch and the shaper's double oversamplers at the next prepare().
+    // the standard and multi-tap loops then run in double, grains, taps, the reverb and
+    // the spectral frames stay float inside and are mixed into the double buffer
+    void setDoublePrecision(bool shouldUseDouble) { doublePrecision = shouldUseDouble; }
+
+    // how long the echoes keep ringing after the input stops, infinite when feedback doesn't
+    // decay or the spectrum is frozen. the reverb's decay comes on top, the caller adds it
+    // from its parameters. everything comes in as parameters, hosts ask from their own thread
+    double getTailLengthSeconds(float delaySeconds, float feedback, bool granularMode, float grainSize,
+        float grainHistorySeconds = 0.0f, bool spectralEnabled = false, bool spectralFreeze = false,
+        float spectralSmear = 0.0f) const;
+
+    // true while input and delay line are silent and process() only clears the buffer
+    bool isBypassed() const { return bypassed; }
+
+    // fills in the grain counts and the wet and feedback levels since the last call
+    void collectTelemetry(telemetryFrame& frame);
+
+    // overview and grain positions for the editor's display, idle unless a display switches it on
+    delayVisualFeed& getVisualFeed() { return visualFeed; }
+
+    // how long a delay time change takes to settle, the read head glides like a tape head
+    static constexpr double delayGlideSeconds = 0.25;
+
+    // feedback and mix changes ramp over this long instead of stepping at a block edge
+    static constexpr double mixGlideSeconds = 0.05;
+
+    // -100 dB, anything quieter counts as silence for the bypass and the tail length
+    static constexpr float silenceThreshold = 1.0e-5f;
+
+    // longest grain history, the store is sized for what was asked for at prepare time
+    static constexpr float maxGrainHistorySeconds = 120.0f;
 
 private:
-    juce::AudioBuffer<float> delayBuffer;
-    int writePosition { 0 };
-    float previousDelaySeconds = 1.0f;
+    delayLine delayBuffer;
+    delayMipmap mipmap;
+    historyStore history;
     grainProcessor grainProcessor;
+    delayLine::Interpolation interpolation { delayLine::Interpolation::lagrange3 };
+    delayLine::Storage delayStorage { delayLine::Storage::float32 };
+    bool doublePrecision { false };
+    int subBlockSize { defaultSubBlockSize };
+
+    // delay time in samples, smoothed so changes never jump the read head
+    parameterRamp delayTimeRamp;
+    bool delayTimeNeedsReset { true };
+
+    // feedback (channel 0) and wetDry (channel 1) per sample, filled only while one of
+    // them is still gliding. sized to a sub-block in prepare()
+    parameterRamp feedbackRamp;
+    parameterRamp wetDryRamp;
+    juce::AudioBuffer<float> rampBuffer;
+    bool rampsNeedReset { true };
+    bool rampsMoving { false };
+
+    // per-sample delay times for the current block, and a block of samples per channel
+    // on their way into or out of the delay line. sized once in prepare() to maxBlockSize,
+    // the granular sub-block, the other modes split at subBlockFrames
+    juce::AudioBuffer<float> delayTimeBuffer;
+    juce::AudioBuffer<float> blockBuffer;
+    int maxBlockSize { 0 };
+    int subBlockFrames { 0 };
+    double currentSampleRate { 44100.0 };
+
+    // the granular loop feeds back the line from one announced host block back, so it
+    // sounds the same whatever the sub-block size
+    int granularFeedbackDelay { 2 };
+
+    // silence tracking: the loudest sample written this block, and how many of the
+    // most recently written samples were all below the threshold
+    float writtenPeak { 0.0f };
+    int silentHistorySamples { 0 };
+    bool bypassed { false };
+
+    // telemetry levels, accumulated until collectTelemetry()
+    signalMeter wetMeter;
+    signalMeter feedbackMeter;
+
+    multiTapDelay multiTap;
+    bool multiTapMode { false };
+    juce::AudioBuffer<float> tapBuffer;
+
+    spectralProcessor spectral;
+    bool spectralMode { false };
+
+    // the run on its way into the line, shaped as a block first
+    feedbackShaper shaper;
+    juce::AudioBuffer<float> writeBuffer;
+    template <typename SampleType>
+    void writeRun(int start, int numSamples, int numChannels, float& peak, float& squares);
 
-    void fillBuffer(int channel, int bufferSize, int delayBufferSize, float* channelData);
-    void processStandardDelay(juce::AudioBuffer<float>& buffer,
+    // blockBuffer and writeBuffer for double blocks, empty unless double precision is on
+    juce::AudioBuffer<double> wideBlockBuffer;
+    juce::AudioBuffer<double> wideWriteBuffer;
+
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType>& getBlockBuffer()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+        {
+            return wideBlockBuffer;
+        }
+        else
+        {
+            return blockBuffer;
+        }
+    }
+
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType>& getWriteBuffer()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+        {
+            return wideWriteBuffer;
+        }
+        else
+        {
+            return writeBuffer;
+        }
+    }
+
+    fdnReverb reverb;
+    fdnReverb::Position reverbPosition { fdnReverb::Position::postGrains };
+    float reverbMix { 0.0f };
+    bool reverbInLoop { false };    // this block's reverb already ran in the feedback loop
+
+    delayVisualFeed visualFeed;
+    delayVisualFeed::grainSnapshot grainSnapshot {};
+    bool granularBlock { false };
+    void feedVisuals(int numSamples);
+
+    // the delay line, its mipmap and the history store always move together
+    void resetHistory();
+    void advanceHistory(int numSamples);
+    int getHistoryCapacity() const { return juce::jmax(delayBuffer.getCapacity(), history.getCapacity()); }
+
+    int getGrainHistorySamples(float grainHistorySeconds) const;
+    int getReachableHistory(bool granularMode, float grainSize, float grainSpread, float grainHistorySeconds, int bufferSize) const;
+    template <typename SampleType>
+    bool canBypass(const juce::AudioBuffer<SampleType>& buffer, bool granularMode, float grainSize, float grainSpread,
+        float grainHistorySeconds) const;
+
+    float getDelayTimeTarget(float delaySeconds, double sampleRate) const;
+    // this block's feedback and wetDry ramps, into rampBuffer when they're moving
+    void fillParameterRamps(int numSamples, float feedback, float wetDry);
+    // the block's per-sample delay times in samples, following the glide
+    const float* fillDelayTimes(int numSamples, float delaySeconds, double sampleRate);
+    template <typename SampleType>
+    void processStandardDelay(juce::AudioBuffer<SampleType>& buffer,
+        float delaySeconds, float feedback, float wetDry, float gainBegin, float gainEnd,
+        double sampleRate);
+    template <typename SampleType>
+    void processMultiTapDelay(juce::AudioBuffer<SampleType>& buffer,
         float delaySeconds, float feedback, float wetDry, float gainBegin, float gainEnd,
         double sampleRate);
-    void processGranularDelay(juce::AudioBuffer<float>& buffer, float delaySeconds,
+    template <typename SampleType>
+    void processSpectralDelay(juce::AudioBuffer<SampleType>& buffer,
+        float delaySeconds, float feedback, float wetDry, float gainBegin, float gainEnd);
+    template <typename SampleType>
+    void processGranularDelay(juce::AudioBuffer<SampleType>& buffer, float delaySeconds,
         float feedback, float wetDry, float gainBegin, float gainEnd,
         double sampleRate, float grainSize, float grainDensity, float grainPitch,
-        float grainSpread);
+        float grainSpread, float grainHistorySeconds);
 };
 
 #endif //DELAYPROCESSOR_H
@@ -0,0 +1,111 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "delayVisualFeed.h"
+
+delayVisualFeed::delayVisualFeed()
+    : columns(static_cast<size_t>(columnCapacity)), snapshots(static_cast<size_t>(snapshotCapacity))
+{
+}
+
+void delayVisualFeed::prepare(double newSampleRate, int maxBlockSize)
+{
+    sampleRate.store(newSampleRate, std::memory_order_relaxed);
+
+    // a block can finish maxBlockSize / samplesPerColumn columns and start another
+    pendingColumns.assign(static_cast<size_t>(maxBlockSize / samplesPerColumn + 2), column { 0.0f, 0.0f });
+    columnFill = 0;
+
+    samplesPerSnapshot = static_cast<int>(newSampleRate / snapshotRateHz);
+    samplesSinceSnapshot = samplesPerSnapshot;
+}
+
+void delayVisualFeed::addChannel(const float* data, int numSamples)
+{
+    jassert(columnFill + numSamples <= static_cast<int>(pendingColumns.size()) * samplesPerColumn);
+
+    // one run per column, so the inner loop is a plain min/max
+    int start = 0;
+    for (int index = 0; start < numSamples; ++index)
+    {
+        int end = juce::jmin(numSamples, (index + 1) * samplesPerColumn - columnFill);
+        auto range = juce::FloatVectorOperations::findMinAndMax(data + start, end - start);
+
+        auto& target = pendingColumns[static_cast<size_t>(index)];
+        target.minimum = juce::jmin(target.minimum, range.getStart());
+        target.maximum = juce::jmax(target.maximum, range.getEnd());
+        start = end;
+    }
+}
+
+void delayVisualFeed::endBlock(int numSamples)
+{
+    int total = columnFill + numSamples;
+    int numComplete = total / samplesPerColumn;
+
+    if (numComplete > 0)
+    {
+        int start1, size1, start2, size2;
+        columnFifo.prepareToWrite(numComplete, start1, size1, start2, size2);
+        std::copy_n(pendingColumns.begin(), size1, columns.begin() + start1);
+        std::copy_n(pendingColumns.begin() + size1, size2, columns.begin() + start2);
+        columnFifo.finishedWrite(size1 + size2);
+
+        // the partial column moves to the front
+        pendingColumns.front() = pendingColumns[static_cast<size_t>(numComplete)];
+        std::fill(pendingColumns.begin() + 1, pendingColumns.end(), column { 0.0f, 0.0f });
+    }
+
+    columnFill = total - numComplete * samplesPerColumn;
+}
+
+bool delayVisualFeed::wantsGrainSnapshot(int numSamples)
+{
+    samplesSinceSnapshot += numSamples;
+    if (samplesSinceSnapshot < samplesPerSnapshot)
+    {
+        return false;
+    }
+    samplesSinceSnapshot = 0;
+    return true;
+}
+
+void delayVisualFeed::pushGrains(const grainSnapshot& snapshot)
+{
+    // a stalled display misses snapshots until it catches up, it only ever shows the newest anyway
+    int start1, size1, start2, size2;
+    snapshotFifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 > 0)
+    {
+        snapshots[static_cast<size_t>(start1)] = snapshot;
+        snapshotFifo.finishedWrite(1);
+    }
+}
+
+int delayVisualFeed::popColumns(column* destination, int maxColumns)
+{
+    int start1, size1, start2, size2;
+    columnFifo.prepareToRead(maxColumns, start1, size1, start2, size2);
+    std::copy_n(columns.begin() + start1, size1, destination);
+    std::copy_n(columns.begin() + start2, size2, destination + size1);
+    columnFifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+bool delayVisualFeed::popLatestGrains(grainSnapshot& destination)
+{
+    int numReady = snapshotFifo.getNumReady();
+    if (numReady == 0)
+    {
+        return false;
+    }
+
+    // skip to the newest
+    int start1, size1, start2, size2;
+    snapshotFifo.prepareToRead(numReady, start1, size1, start2, size2);
+    int newest = size2 > 0 ? start2 + size2 - 1 : start1 + size1 - 1;
+    destination = snapshots[static_cast<size_t>(newest)];
+    snapshotFifo.finishedRead(size1 + size2);
+    return true;
+}
@@ -0,0 +1,91 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <vector>
+
+#ifndef DELAYVISUALFEED_H
+#define DELAYVISUALFEED_H
+
+// what the editor's display needs from the audio thread, through two lock-free
+// fifos: a min/max overview of everything written to the delay line, one column
+// per samplesPerColumn samples, and now and then a snapshot of where the grains
+// are. nothing is pushed while no display is open
+class delayVisualFeed {
+public:
+    static constexpr int samplesPerColumn = 256;
+    static constexpr int maxVisualGrains = 64;
+
+    // grain snapshots per second, about what a display can show
+    static constexpr double snapshotRateHz = 60.0;
+
+    struct column
+    {
+        float minimum;
+        float maximum;
+    };
+
+    // ages are in samples behind the write head when the snapshot was taken
+    struct grainMarker
+    {
+        float startAge;
+        float readAge;
+        float amplitude;
+    };
+
+    struct grainSnapshot
+    {
+        int numGrains;
+        grainMarker grains[maxVisualGrains];
+    };
+
+    delayVisualFeed();
+
+    // called from prepareToPlay, while nothing is being pushed
+    void prepare(double sampleRate, int maxBlockSize);
+
+    // the display switches the feed on while it's showing
+    void setActive(bool shouldBeActive) { active.store(shouldBeActive, std::memory_order_relaxed); }
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+
+    double getSampleRate() const { return sampleRate.load(std::memory_order_relaxed); }
+
+    // audio thread: every channel of a block with addChannel(), then endBlock() once
+    void addChannel(const float* data, int numSamples);
+    void endBlock(int numSamples);
+
+    // audio thread: true when it's time for the next grain snapshot
+    bool wantsGrainSnapshot(int numSamples);
+    void pushGrains(const grainSnapshot& snapshot);
+
+    // display thread: oldest columns first, columns that didn't fit the fifo are lost
+    int popColumns(column* destination, int maxColumns);
+
+    // display thread: the newest snapshot, false when none arrived since the last call
+    bool popLatestGrains(grainSnapshot& destination);
+
+private:
+    std::atomic<bool> active { false };
+    std::atomic<double> sampleRate { 44100.0 };
+
+    static constexpr int columnCapacity = 2048;
+    static constexpr int snapshotCapacity = 4;
+
+    juce::AbstractFifo columnFifo { columnCapacity };
+    std::vector<column> columns;
+
+    juce::AbstractFifo snapshotFifo { snapshotCapacity };
+    std::vector<grainSnapshot> snapshots;
+
+    // the columns the current block touches, the first one carries over the partial column
+    std::vector<column> pendingColumns;
+    int columnFill { 0 };
+
+    int samplesPerSnapshot { 0 };
+    int samplesSinceSnapshot { 0 };
+};
+
+#endif //DELAYVISUALFEED_H
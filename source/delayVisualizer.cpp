@@ -0,0 +1,154 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "delayVisualizer.h"
+
+delayVisualizer::delayVisualizer(delayVisualFeed& source, const std::atomic<float>& seconds)
+    : feed(source), visibleSeconds(seconds), incoming(512)
+{
+    setOpaque(true);
+    grains.numGrains = 0;
+
+    // the audio thread only does the extra work while a display exists
+    feed.setActive(true);
+    startTimerHz(frameRateHz);
+}
+
+delayVisualizer::~delayVisualizer()
+{
+    stopTimer();
+    feed.setActive(false);
+}
+
+float delayVisualizer::getVisibleSamples() const
+{
+    return shownSeconds * static_cast<float>(historySampleRate);
+}
+
+void delayVisualizer::timerCallback()
+{
+    auto sampleRate = feed.getSampleRate();
+    if (sampleRate != historySampleRate)
+    {
+        historySampleRate = sampleRate;
+        auto numColumns = static_cast<size_t>(std::ceil(sampleRate * maxVisibleSeconds / delayVisualFeed::samplesPerColumn)) + 1;
+        history.assign(numColumns, delayVisualFeed::column { 0.0f, 0.0f });
+        historyWrite = 0;
+        overviewDirty = true;
+    }
+
+    bool changed = overviewDirty;
+
+    for (;;)
+    {
+        int numColumns = feed.popColumns(incoming.data(), static_cast<int>(incoming.size()));
+        if (numColumns == 0)
+        {
+            break;
+        }
+        for (int i = 0; i < numColumns; ++i)
+        {
+            history[static_cast<size_t>(historyWrite)] = incoming[static_cast<size_t>(i)];
+            historyWrite = (historyWrite + 1) % static_cast<int>(history.size());
+        }
+        overviewDirty = changed = true;
+    }
+
+    auto seconds = juce::jlimit(0.01f, static_cast<float>(maxVisibleSeconds), visibleSeconds.load(std::memory_order_relaxed));
+    if (seconds != shownSeconds)
+    {
+        shownSeconds = seconds;
+        overviewDirty = changed = true;
+    }
+
+    changed = feed.popLatestGrains(grains) || changed;
+
+    if (changed)
+    {
+        repaint();
+    }
+}
+
+void delayVisualizer::resized()
+{
+    overviewDirty = true;
+}
+
+void delayVisualizer::renderOverview()
+{
+    auto scale = juce::Component::getApproximateScaleFactorForComponent(this);
+    int width = juce::jmax(1, juce::roundToInt(static_cast<float>(getWidth()) * scale));
+    int height = juce::jmax(1, juce::roundToInt(static_cast<float>(getHeight()) * scale));
+
+    if (!overview.isValid() || overview.getWidth() != width || overview.getHeight() != height)
+    {
+        overview = juce::Image(juce::Image::RGB, width, height, false);
+    }
+
+    juce::Graphics g(overview);
+    g.fillAll(juce::Colours::black);
+    overviewDirty = false;
+
+    if (history.empty())
+    {
+        return;
+    }
+
+    // each pixel column covers a run of overview columns, newest on the right
+    auto numHistory = static_cast<int>(history.size());
+    auto visibleColumns = juce::jmin(static_cast<float>(numHistory - 1),
+        getVisibleSamples() / static_cast<float>(delayVisualFeed::samplesPerColumn));
+    auto columnsPerPixel = visibleColumns / static_cast<float>(width);
+    auto middle = static_cast<float>(height) * 0.5f;
+
+    g.setColour(juce::Colours::lightblue.withAlpha(0.8f));
+    for (int x = 0; x < width; ++x)
+    {
+        int newest = static_cast<int>(static_cast<float>(width - x - 1) * columnsPerPixel);
+        int oldest = juce::jmax(newest, static_cast<int>(static_cast<float>(width - x) * columnsPerPixel) - 1);
+
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+        for (int age = newest; age <= oldest; ++age)
+        {
+            const auto& column = history[static_cast<size_t>((historyWrite - 1 - age + numHistory) % numHistory)];
+            minimum = juce::jmin(minimum, column.minimum);
+            maximum = juce::jmax(maximum, column.maximum);
+        }
+
+        auto top = middle - juce::jlimit(-1.0f, 1.0f, maximum) * middle;
+        auto bottom = middle - juce::jlimit(-1.0f, 1.0f, minimum) * middle;
+        g.drawVerticalLine(x, top, juce::jmax(top + 1.0f, bottom));
+    }
+}
+
+void delayVisualizer::paint(juce::Graphics& g)
+{
+    if (overviewDirty)
+    {
+        renderOverview();
+    }
+    g.drawImage(overview, getLocalBounds().toFloat());
+
+    auto visibleSamples = getVisibleSamples();
+    if (visibleSamples <= 0.0f)
+    {
+        return;
+    }
+
+    // grains spread out vertically by their index so overlapping ones stay apart
+    auto width = static_cast<float>(getWidth());
+    auto height = static_cast<float>(getHeight());
+    auto toX = [&](float age) { return width * (1.0f - age / visibleSamples); };
+
+    for (int i = 0; i < grains.numGrains; ++i)
+    {
+        const auto& grain = grains.grains[i];
+        auto y = height * (0.1f + 0.8f * static_cast<float>((i * 37) % 64) / 64.0f);
+
+        g.setColour(juce::Colours::orange.withAlpha(0.3f + 0.7f * grain.amplitude));
+        g.drawLine(toX(grain.startAge), y, toX(grain.readAge), y, 1.0f);
+        g.fillEllipse(toX(grain.readAge) - 2.5f, y - 2.5f, 5.0f, 5.0f);
+    }
+}
@@ -0,0 +1,52 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "delayVisualFeed.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+#ifndef DELAYVISUALIZER_H
+#define DELAYVISUALIZER_H
+
+// the last visibleSeconds of the delay history as a min/max overview, newest on
+// the right, with the grains drawn over it: a line from where each grain started
+// to where it's reading now. the overview is drawn into a cached image only when
+// new columns arrive, and nothing repaints faster than frameRateHz
+class delayVisualizer : public juce::Component, private juce::Timer {
+public:
+    static constexpr int frameRateHz = 30;
+    static constexpr double maxVisibleSeconds = 10.0;
+
+    // visibleSeconds is read every frame, usually the delay size parameter
+    delayVisualizer(delayVisualFeed& feed, const std::atomic<float>& visibleSeconds);
+    ~delayVisualizer() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    delayVisualFeed& feed;
+    const std::atomic<float>& visibleSeconds;
+
+    // ring of every column for maxVisibleSeconds, sized for the feed's sample rate
+    std::vector<delayVisualFeed::column> history;
+    int historyWrite { 0 };
+    double historySampleRate { 0.0 };
+    std::vector<delayVisualFeed::column> incoming;
+
+    delayVisualFeed::grainSnapshot grains {};
+
+    juce::Image overview;
+    bool overviewDirty { true };
+    float shownSeconds { 0.0f };
+
+    void timerCallback() override;
+    void renderOverview();
+    float getVisibleSamples() const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (delayVisualizer)
+};
+
+#endif //DELAYVISUALIZER_H
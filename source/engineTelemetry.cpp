@@ -0,0 +1,179 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "engineTelemetry.h"
+#include <cstring>
+
+void signalMeter::add(const float* data, int count)
+{
+    float blockPeak = 0.0f;
+    float blockSumOfSquares = 0.0f;
+
+    for (int i = 0; i < count; ++i)
+    {
+        blockPeak = juce::jmax(blockPeak, std::abs(data[i]));
+        blockSumOfSquares += data[i] * data[i];
+    }
+
+    add(blockPeak, blockSumOfSquares, count);
+}
+
+void signalMeter::add(float blockPeak, float blockSumOfSquares, int count)
+{
+    peak = juce::jmax(peak, blockPeak);
+    sumOfSquares += blockSumOfSquares;
+    numSamples += count;
+}
+
+float signalMeter::getRms() const
+{
+    return numSamples > 0 ? std::sqrt(sumOfSquares / static_cast<float>(numSamples)) : 0.0f;
+}
+
+uint32_t signalMeter::getFlags() const
+{
+    return telemetryScan::classify(&sumOfSquares, 1);
+}
+
+namespace telemetryScan
+{
+    uint32_t classify(const float* data, int numSamples)
+    {
+        // exponent all ones is inf or nan, all zeros with a mantissa is a denormal.
+        // branch free so it vectorises
+        uint32_t nonFinite = 0;
+        uint32_t denormal = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, data + i, sizeof(bits));
+            uint32_t exponent = bits & 0x7f800000u;
+            uint32_t mantissa = bits & 0x007fffffu;
+
+            nonFinite |= static_cast<uint32_t>(exponent == 0x7f800000u);
+            denormal |= static_cast<uint32_t>(exponent == 0 && mantissa != 0);
+        }
+
+        return (nonFinite != 0 ? telemetryFlags::nonFinite : 0u) | (denormal != 0 ? telemetryFlags::denormal : 0u);
+    }
+
+    uint32_t classify(const double* data, int numSamples)
+    {
+        // same again with double's 11 bit exponent
+        uint64_t nonFinite = 0;
+        uint64_t denormal = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, data + i, sizeof(bits));
+            uint64_t exponent = bits & 0x7ff0000000000000ull;
+            uint64_t mantissa = bits & 0x000fffffffffffffull;
+
+            nonFinite |= static_cast<uint64_t>(exponent == 0x7ff0000000000000ull);
+            denormal |= static_cast<uint64_t>(exponent == 0 && mantissa != 0);
+        }
+
+        return (nonFinite != 0 ? telemetryFlags::nonFinite : 0u) | (denormal != 0 ? telemetryFlags::denormal : 0u);
+    }
+}
+
+engineTelemetry::engineTelemetry()
+    : slots(std::make_unique<slot[]>(capacity))
+{
+}
+
+void engineTelemetry::push(const telemetryFrame& frame)
+{
+    // only the audio thread writes, so the count can't move under us
+    auto index = numWritten.load(std::memory_order_relaxed);
+    auto& target = slots[index & mask];
+
+    uint64_t words[frameWords];
+    std::memcpy(words, &frame, sizeof(words));
+
+    target.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < frameWords; ++i)
+    {
+        target.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    target.sequence.store(2 * index + 2, std::memory_order_release);
+
+    numWritten.store(index + 1, std::memory_order_release);
+}
+
+bool engineTelemetry::readSlot(uint64_t index, telemetryFrame& destination) const
+{
+    // seqlock read: the copy only counts if the slot held frame index before and after it
+    const auto& source = slots[index & mask];
+    auto expected = 2 * index + 2;
+
+    if (source.sequence.load(std::memory_order_acquire) != expected)
+    {
+        return false;
+    }
+
+    uint64_t words[frameWords];
+    for (int i = 0; i < frameWords; ++i)
+    {
+        words[i] = source.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (source.sequence.load(std::memory_order_relaxed) != expected)
+    {
+        return false;
+    }
+
+    std::memcpy(&destination, words, sizeof(words));
+    return true;
+}
+
+int engineTelemetry::read(reader& position, telemetryFrame* destination, int maxFrames) const
+{
+    auto end = numWritten.load(std::memory_order_acquire);
+
+    // anything older than a full ring has already been overwritten
+    if (end - position.next > static_cast<uint64_t>(capacity))
+    {
+        position.missed += end - capacity - position.next;
+        position.next = end - capacity;
+    }
+
+    int numRead = 0;
+    while (numRead < maxFrames && position.next < end)
+    {
+        if (readSlot(position.next, destination[numRead]))
+        {
+            ++numRead;
+        }
+        else
+        {
+            // the writer lapped us on this slot
+            ++position.missed;
+        }
+        ++position.next;
+    }
+
+    return numRead;
+}
+
+bool engineTelemetry::getLatest(telemetryFrame& destination) const
+{
+    // the newest slot can be overwritten while we copy it, one retry with the then newest is plenty
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        auto end = numWritten.load(std::memory_order_acquire);
+        if (end == 0)
+        {
+            return false;
+        }
+        if (readSlot(end - 1, destination))
+        {
+            return true;
+        }
+    }
+    return false;
+}
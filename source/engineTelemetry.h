@@ -0,0 +1,123 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#ifndef ENGINETELEMETRY_H
+#define ENGINETELEMETRY_H
+
+namespace telemetryFlags
+{
+    enum : uint32_t
+    {
+        nonFinite = 1 << 0,         // a nan or inf reached the output or the feedback path
+        denormal = 1 << 1,          // a denormal reached the output
+        blockSizeChanged = 1 << 2,  // the block isn't the size of the one before it
+        oversizedBlock = 1 << 3,    // bigger than announced in prepareToPlay, the engine split it
+        bypassed = 1 << 4,          // silent, the delay path was skipped
+        granular = 1 << 5
+    };
+}
+
+// one processed block. plain data, the trace file is a header followed by these as they are
+struct telemetryFrame
+{
+    uint64_t blockIndex;            // counts from 0 at prepareToPlay, gaps mean frames were missed
+    uint32_t numSamples;
+    uint32_t flags;                 // telemetryFlags
+    float processMicroseconds;
+    float load;                     // processing time over the block's duration
+    uint32_t activeGrains;
+    uint32_t grainsSpawned;         // running totals since prepareToPlay, so
+    uint32_t grainsStolen;          // a missed frame doesn't lose any
+    uint32_t grainsRejected;
+    float wetPeak;
+    float wetRms;
+    float feedbackPeak;             // what went back into the delay line
+    float feedbackRms;
+    int32_t governorLevel;
+    uint32_t reserved;
+};
+
+static_assert(std::is_trivially_copyable_v<telemetryFrame>);
+static_assert(sizeof(telemetryFrame) == 64);
+
+// peak and mean square of a signal over however many blocks were added since clear()
+struct signalMeter
+{
+    float peak { 0.0f };
+    float sumOfSquares { 0.0f };
+    int numSamples { 0 };
+
+    void add(const float* data, int count);
+    void add(float blockPeak, float blockSumOfSquares, int count);
+    void add(const signalMeter& other) { add(other.peak, other.sumOfSquares, other.numSamples); }
+    void clear() { *this = {}; }
+
+    float getRms() const;
+
+    // a nan or inf anywhere in the samples leaves the sum non-finite
+    uint32_t getFlags() const;
+};
+
+namespace telemetryScan
+{
+    // telemetryFlags::nonFinite and denormal for the samples. works on the bit
+    // patterns, fast math is free to assume std::isnan is always false
+    uint32_t classify(const float* data, int numSamples);
+    uint32_t classify(const double* data, int numSamples);
+}
+
+// fixed size channel of frames written by the audio thread. the writer never
+// waits and never allocates, when readers fall behind the oldest frames are
+// overwritten. every reader keeps its own cursor, so the editor, a trace file
+// and a test can all follow the same engine
+class engineTelemetry {
+public:
+    // frames, a bit over a second of 16 sample blocks at 48 kHz
+    static constexpr int capacity = 4096;
+
+    engineTelemetry();
+
+    // audio thread only
+    void push(const telemetryFrame& frame);
+
+    struct reader
+    {
+        uint64_t next { 0 };
+        uint64_t missed { 0 };  // frames that were overwritten before this reader got to them
+    };
+
+    // copies up to maxFrames frames the reader hasn't seen, oldest first
+    int read(reader& position, telemetryFrame* destination, int maxFrames) const;
+
+    // the newest frame, false until something has been pushed
+    bool getLatest(telemetryFrame& destination) const;
+
+    uint64_t getNumPushed() const { return numWritten.load(std::memory_order_acquire); }
+
+private:
+    static constexpr uint64_t mask = capacity - 1;
+
+    // sequence is 2n + 1 while frame n is being written and 2n + 2 once it's complete.
+    // the frame is kept as atomic words so a read racing the writer is only stale, never undefined
+    static constexpr int frameWords = sizeof(telemetryFrame) / sizeof(uint64_t);
+
+    struct slot
+    {
+        std::atomic<uint64_t> sequence { 0 };
+        std::atomic<uint64_t> words[frameWords] {};
+    };
+
+    std::unique_ptr<slot[]> slots;
+    std::atomic<uint64_t> numWritten { 0 };
+
+    bool readSlot(uint64_t index, telemetryFrame& destination) const;
+};
+
+#endif //ENGINETELEMETRY_H
@@ -0,0 +1,34 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "fastRandom.h"
+
+fastRandom::fastRandom(uint64_t seed)
+{
+    setSeed(seed);
+}
+
+void fastRandom::setSeed(uint64_t seed)
+{
+    // splitmix64 spreads even small neighbouring seeds over the whole state
+    for (int i = 0; i < 4; i += 2)
+    {
+        seed += 0x9e3779b97f4a7c15ull;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+
+        state[i] = static_cast<uint32_t>(z);
+        state[i + 1] = static_cast<uint32_t>(z >> 32);
+    }
+}
+
+void fastRandom::fillFloats(float* destination, int numValues)
+{
+    for (int i = 0; i < numValues; ++i)
+    {
+        destination[i] = nextFloat();
+    }
+}
@@ -0,0 +1,58 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <cstdint>
+
+#ifndef FASTRANDOM_H
+#define FASTRANDOM_H
+
+// xoshiro128+ : 16 bytes of state, a handful of integer ops per draw and the
+// same sequence on every platform for a given seed, so renders are repeatable
+class fastRandom {
+public:
+    explicit fastRandom(uint64_t seed = 0);
+
+    // the state is expanded from seed with splitmix64, any value (0 included) is fine
+    void setSeed(uint64_t seed);
+
+    uint32_t nextUInt32();
+
+    // uniform in [0, 1)
+    float nextFloat();
+
+    // numValues draws of nextFloat() in one go, same sequence as calling it repeatedly
+    void fillFloats(float* destination, int numValues);
+
+private:
+    uint32_t state[4];
+
+    static uint32_t rotateLeft(uint32_t value, int shift)
+    {
+        return (value << shift) | (value >> (32 - shift));
+    }
+};
+
+inline uint32_t fastRandom::nextUInt32()
+{
+    uint32_t result = state[0] + state[3];
+    uint32_t shifted = state[1] << 9;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= shifted;
+    state[3] = rotateLeft(state[3], 11);
+
+    return result;
+}
+
+inline float fastRandom::nextFloat()
+{
+    // the top 24 bits are the strongest ones in xoshiro+ and fill a float mantissa exactly
+    return static_cast<float>(nextUInt32() >> 8) * (1.0f / 16777216.0f);
+}
+
+#endif //FASTRANDOM_H
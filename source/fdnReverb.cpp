@@ -0,0 +1,295 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "fdnReverb.h"
+
+// spread over roughly an octave so the echo density builds up quickly,
+// each rounded to a prime number of samples so no two lines share a period
+static constexpr float lineLengthsMs[fdnReverb::numLines] = { 23.1f, 27.9f, 31.7f, 36.5f, 41.3f, 45.9f, 52.7f, 59.3f };
+
+// slow and unrelated, a few tenths of a millisecond is enough to break up the metallic ringing
+static constexpr double lfoRatesHz[fdnReverb::numLines] = { 0.31, 0.37, 0.43, 0.47, 0.53, 0.59, 0.67, 0.71 };
+static constexpr float modulationDepthMs = 0.3f;
+
+static constexpr float silenceThreshold = 1.0e-5f;
+
+// each side feeds four lines
+static constexpr float inputGain = 0.5f;
+
+static int nextPrime(int value)
+{
+    auto isPrime = [](int n) {
+        for (int d = 2; d * d <= n; ++d)
+        {
+            if (n % d == 0)
+            {
+                return false;
+            }
+        }
+        return n > 1;
+    };
+
+    while (!isPrime(value))
+    {
+        ++value;
+    }
+    return value;
+}
+
+fdnReverb::fdnReverb() {}
+
+void fdnReverb::prepare(double newSampleRate, int maxBlockSize)
+{
+    sampleRate = newSampleRate;
+    modulationDepth = static_cast<float>(modulationDepthMs * sampleRate / 1000.0);
+
+    for (size_t k = 0; k < numLines; ++k)
+    {
+        lengths[k] = static_cast<float>(nextPrime(static_cast<int>(lineLengthsMs[k] * sampleRate / 1000.0)));
+        lfoIncrement[k] = juce::MathConstants<double>::twoPi * lfoRatesHz[k] / sampleRate;
+        lfoPhase[k] = juce::MathConstants<double>::twoPi * static_cast<double>(k) / numLines;
+    }
+
+    // a sub-block never reads what it writes: the shortest line minus its modulation and the interpolation tap
+    maxLineSamples = static_cast<int>(std::ceil(lengths.back() + modulationDepth)) + 2;
+    maxChunk = juce::jmin(maxBlockSize, static_cast<int>(lengths.front() - modulationDepth) - 2);
+    jassert(maxChunk > 0);
+
+    lines.setSize(numLines, juce::nextPowerOfTwo(maxLineSamples + 1));
+    mask = lines.getNumSamples() - 1;
+    rows.setSize(numLines, maxChunk);
+    wet.setSize(2, maxChunk);
+
+    // recomputed for the new rate
+    decaySeconds = -1.0f;
+    setParameters(3.0f, 0.5f);
+    reset();
+}
+
+void fdnReverb::reset()
+{
+    lines.clear();
+    dampingState.fill(0.0f);
+    writePosition = 0;
+    silentSamples = maxLineSamples;
+}
+
+void fdnReverb::setParameters(float newDecaySeconds, float newDamping)
+{
+    newDecaySeconds = juce::jlimit(minDecaySeconds, maxDecaySeconds, newDecaySeconds);
+    newDamping = juce::jlimit(0.0f, 1.0f, newDamping);
+    if (newDecaySeconds == decaySeconds && newDamping == damping)
+    {
+        return;
+    }
+    decaySeconds = newDecaySeconds;
+    damping = newDamping;
+
+    // each pass through line k loses 60 dB * length / T60. the damping cutoff is lower for
+    // longer lines, which the signal goes round less often, so the highs fade evenly
+    float meanLength = 0.0f;
+    for (auto length : lengths)
+    {
+        meanLength += length / static_cast<float>(numLines);
+    }
+
+    float cutoff = 20000.0f * std::pow(0.05f, damping);
+    for (size_t k = 0; k < numLines; ++k)
+    {
+        gains[k] = std::pow(10.0f, -3.0f * lengths[k] / (decaySeconds * static_cast<float>(sampleRate)));
+
+        auto lineCutoff = juce::jmin(cutoff * meanLength / lengths[k], 0.45f * static_cast<float>(sampleRate));
+        dampingCoefficients[k] = 1.0f - std::exp(-juce::MathConstants<float>::twoPi * lineCutoff / static_cast<float>(sampleRate));
+    }
+
+    // white noise going round a line with loop gain |G|^2 = g^2 |H|^2 comes out with
+    // |G|^2 / (1 - |G|^2) times the power that went in (the hadamard mix keeps the
+    // lines uncorrelated and their power unchanged). averaged over the band and the
+    // lines that gives the wet gain, and the output is scaled back by it
+    constexpr int numFrequencies = 64;
+    double powerGain = 0.0;
+    for (size_t k = 0; k < numLines; ++k)
+    {
+        double c = dampingCoefficients[k];
+        double g2 = juce::square(static_cast<double>(gains[k]));
+        for (int f = 0; f < numFrequencies; ++f)
+        {
+            double omega = juce::MathConstants<double>::pi * (f + 0.5) / numFrequencies;
+            double filter = c * c / (1.0 - 2.0 * (1.0 - c) * std::cos(omega) + juce::square(1.0 - c));
+            double loop = g2 * filter;
+            powerGain += loop / (1.0 - loop) / (numFrequencies * numLines);
+        }
+    }
+
+    // each line is fed with inputGain, each side sums four lines
+    outputGain = static_cast<float>(1.0 / std::sqrt(4.0 * juce::square(inputGain) * powerGain));
+}
+
+template <typename SampleType>
+void fdnReverb::process(SampleType* const* channels, int numChannels, int numSamples, float mix)
+{
+    jassert(numChannels >= 1 && numChannels <= 2);
+
+    for (int start = 0; start < numSamples; start += maxChunk)
+    {
+        processChunk(channels, numChannels, start, juce::jmin(maxChunk, numSamples - start), mix);
+    }
+}
+
+void fdnReverb::readLine(int line, int numSamples, float* destination)
+{
+    auto k = static_cast<size_t>(line);
+
+    // the modulated length glides linearly across the sub-block
+    float startDelay = lengths[k] + modulationDepth * static_cast<float>(std::sin(lfoPhase[k]));
+    lfoPhase[k] = std::fmod(lfoPhase[k] + lfoIncrement[k] * numSamples, juce::MathConstants<double>::twoPi);
+    float endDelay = lengths[k] + modulationDepth * static_cast<float>(std::sin(lfoPhase[k]));
+    float step = (endDelay - startDelay) / static_cast<float>(numSamples);
+
+    const float* source = lines.getReadPointer(line);
+
+    // a glide of a few tenths of a millisecond crosses a whole sample only once or twice per
+    // sub-block. between crossings the taps are two plain runs of the line, so the
+    // interpolation is a straight vector loop, and only a run across the wrap takes the mask
+    int i = 0;
+    while (i < numSamples)
+    {
+        int whole = static_cast<int>(startDelay + step * static_cast<float>(i));
+        int end = numSamples;
+        if (step > 0.0f)
+        {
+            end = juce::jlimit(i + 1, numSamples, static_cast<int>(std::ceil((static_cast<float>(whole + 1) - startDelay) / step)));
+        }
+        else if (step < 0.0f)
+        {
+            end = juce::jlimit(i + 1, numSamples, static_cast<int>(std::floor((static_cast<float>(whole) - startDelay) / step)) + 1);
+        }
+
+        float fraction = startDelay - static_cast<float>(whole);
+        int newest = writePosition - whole;
+        if (((newest + i - 1) & mask) + (end - i) <= mask)
+        {
+            const float* newer = source + ((newest + i) & mask) - i;
+            const float* older = newer - 1;
+            for (int j = i; j < end; ++j)
+            {
+                float t = fraction + step * static_cast<float>(j);
+                destination[j] = newer[j] + t * (older[j] - newer[j]);
+            }
+        }
+        else
+        {
+            for (int j = i; j < end; ++j)
+            {
+                float t = fraction + step * static_cast<float>(j);
+                float n = source[(newest + j) & mask];
+                float o = source[(newest + j - 1) & mask];
+                destination[j] = n + t * (o - n);
+            }
+        }
+        i = end;
+    }
+}
+
+template <typename SampleType>
+void fdnReverb::processChunk(SampleType* const* channels, int numChannels, int start, int numSamples, float mix)
+{
+    for (int line = 0; line < numLines; ++line)
+    {
+        readLine(line, numSamples, rows.getWritePointer(line));
+    }
+
+    // damped and scaled for the decay. the one-poles are recursive in time, so all eight
+    // run side by side and each sample's update is independent across the lines
+    std::array<float*, numLines> row {};
+    for (int line = 0; line < numLines; ++line)
+    {
+        row[static_cast<size_t>(line)] = rows.getWritePointer(line);
+    }
+    auto state = dampingState;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (size_t k = 0; k < numLines; ++k)
+        {
+            state[k] += dampingCoefficients[k] * (row[k][i] - state[k]);
+            row[k][i] = state[k] * gains[k];
+        }
+    }
+    dampingState = state;
+
+    // wet output before the mix: even lines on the left, odd ones on the right, alternating signs
+    for (int side = 0; side < 2; ++side)
+    {
+        auto* out = wet.getWritePointer(side);
+        const float* a = rows.getReadPointer(side);
+        const float* b = rows.getReadPointer(side + 2);
+        const float* c = rows.getReadPointer(side + 4);
+        const float* d = rows.getReadPointer(side + 6);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            out[i] = (a[i] - b[i] + c[i] - d[i]) * outputGain;
+        }
+    }
+
+    // 8x8 hadamard as three butterfly stages, each a pass over two whole rows
+    for (int span = 1; span < numLines; span *= 2)
+    {
+        for (int first = 0; first < numLines; first += 2 * span)
+        {
+            for (int line = first; line < first + span; ++line)
+            {
+                auto* x = rows.getWritePointer(line);
+                auto* y = rows.getWritePointer(line + span);
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    float sum = x[i] + y[i];
+                    float difference = x[i] - y[i];
+                    x[i] = sum;
+                    y[i] = difference;
+                }
+            }
+        }
+    }
+
+    // normalise the matrix, add the input and write the lines
+    const float matrixScale = 1.0f / std::sqrt(static_cast<float>(numLines));
+    float peak = 0.0f;
+
+    for (int line = 0; line < numLines; ++line)
+    {
+        const SampleType* input = channels[juce::jmin(line & 1, numChannels - 1)] + start;
+        const float* row = rows.getReadPointer(line);
+        float* target = lines.getWritePointer(line);
+
+        int first = writePosition & mask;
+        int firstPart = juce::jmin(numSamples, mask + 1 - first);
+        for (int i = 0; i < firstPart; ++i)
+        {
+            target[first + i] = row[i] * matrixScale + static_cast<float>(input[i]) * inputGain;
+            peak = juce::jmax(peak, std::abs(target[first + i]));
+        }
+        for (int i = firstPart; i < numSamples; ++i)
+        {
+            target[i - firstPart] = row[i] * matrixScale + static_cast<float>(input[i]) * inputGain;
+            peak = juce::jmax(peak, std::abs(target[i - firstPart]));
+        }
+    }
+    writePosition = (writePosition + numSamples) & mask;
+    silentSamples = peak < silenceThreshold ? juce::jmin(silentSamples + numSamples, maxLineSamples) : 0;
+
+    const auto dryGain = static_cast<SampleType>(1.0f - mix);
+    const auto wetGain = static_cast<SampleType>(mix);
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = channels[channel] + start;
+        const float* reverb = wet.getReadPointer(channel);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            data[i] = data[i] * dryGain + static_cast<SampleType>(reverb[i]) * wetGain;
+        }
+    }
+}
+
+template void fdnReverb::process<float>(float* const*, int, int, float);
+template void fdnReverb::process<double>(double* const*, int, int, float);
@@ -0,0 +1,83 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+
+#ifndef FDNREVERB_H
+#define FDNREVERB_H
+
+// eight line feedback delay network for the diffuse tail. the lines are kept
+// line by line and the network runs in sub-blocks no longer than its shortest
+// line, so nothing written in a sub-block is read back in it. that turns the
+// modulated reads, the hadamard mix and the writes into loops over time for one
+// line or one pair of lines, which the compiler vectorises. only the damping is
+// recursive, and it runs all eight lines side by side instead
+class fdnReverb {
+public:
+    static constexpr int numLines = 8;
+
+    // where the delay processor runs the network
+    enum class Position
+    {
+        postGrains,     // on the output of either engine
+        feedbackLoop    // on the standard delay's taps, so every repeat is more diffuse
+    };
+
+    static constexpr float minDecaySeconds = 0.2f;
+    static constexpr float maxDecaySeconds = 20.0f;
+
+    fdnReverb();
+
+    void prepare(double sampleRate, int maxBlockSize);
+    void reset();
+
+    // decay is the broadband T60, damping from 0 (bright) to 1 (dark)
+    void setParameters(float decaySeconds, float damping);
+
+    // in place, left goes into the even lines and right into the odd ones. the wet
+    // signal is scaled to about the input's level on noise whatever the decay. the
+    // lines are float either way, double only keeps the dry part of the mix exact
+    template <typename SampleType>
+    void process(SampleType* const* channels, int numChannels, int numSamples, float mix);
+
+    // false once everything in the lines has decayed below the threshold
+    bool isRinging() const { return silentSamples < maxLineSamples; }
+
+    double getTailLengthSeconds() const { return decaySeconds; }
+
+private:
+    double sampleRate { 44100.0 };
+
+    // one row per line, power of two capacity so positions wrap with a mask
+    juce::AudioBuffer<float> lines;
+    int mask { 0 };
+    int writePosition { 0 };
+
+    // sub-block scratch: the line outputs (mixed in place into the line inputs), and the wet output
+    juce::AudioBuffer<float> rows;
+    juce::AudioBuffer<float> wet;
+    int maxChunk { 0 };
+
+    std::array<float, numLines> lengths {};
+    std::array<float, numLines> gains {};
+    std::array<float, numLines> dampingCoefficients {};
+    std::array<float, numLines> dampingState {};
+    std::array<double, numLines> lfoPhase {};
+    std::array<double, numLines> lfoIncrement {};
+    float modulationDepth { 0.0f };
+    float outputGain { 1.0f };
+
+    float decaySeconds { -1.0f };
+    float damping { -1.0f };
+    int maxLineSamples { 0 };
+    int silentSamples { 0 };
+
+    template <typename SampleType>
+    void processChunk(SampleType* const* channels, int numChannels, int start, int numSamples, float mix);
+    void readLine(int line, int numSamples, float* destination);
+};
+
+#endif //FDNREVERB_H
@@ -0,0 +1,337 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "feedbackShaper.h"
+
+// two stage butterworth: each stage's damping, k = 1 / Q
+static constexpr std::array<float, 2> butterworthDamping = { 0.76537f, 1.84776f };
+static constexpr float singleStageDamping = 1.41421f;
+
+// the saturator's curve at full drive, and the offset that makes it lopsided like tape
+static constexpr float maxDrive = 3.0f;
+static constexpr float tapeBias = 0.15f;
+
+static constexpr double cutoffGlideSeconds = 0.05;
+
+feedbackShaper::feedbackShaper() {}
+
+template <typename SampleType>
+static void makeOversamplers(std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, 2>& oversamplers,
+    int numChannels, int maxBlockSize)
+{
+    using Oversampling = juce::dsp::Oversampling<SampleType>;
+    oversamplers[0] = std::make_unique<Oversampling>(static_cast<size_t>(numChannels), 1,
+        Oversampling::filterHalfBandPolyphaseIIR, true, true);
+    oversamplers[1] = std::make_unique<Oversampling>(static_cast<size_t>(numChannels), 2,
+        Oversampling::filterHalfBandFIREquiripple, true, true);
+    for (auto& oversampler : oversamplers)
+    {
+        oversampler->initProcessing(static_cast<size_t>(maxBlockSize));
+    }
+}
+
+void feedbackShaper::prepare(double newSampleRate, int newNumChannels, int maxBlockSize, bool doublePrecision)
+{
+    sampleRate = newSampleRate;
+    numChannels = newNumChannels;
+
+    makeOversamplers(oversamplers, numChannels, maxBlockSize);
+    if (doublePrecision)
+    {
+        makeOversamplers(wideOversamplers, numChannels, maxBlockSize);
+    }
+    else
+    {
+        wideOversamplers = {};
+    }
+
+    lowCutSmoothed.reset(sampleRate, cutoffGlideSeconds);
+    highCutSmoothed.reset(sampleRate, cutoffGlideSeconds);
+    driveSmoothed.reset(sampleRate, cutoffGlideSeconds);
+
+    lowCutState.assign(static_cast<size_t>(numChannels * maxStages), svfState {});
+    highCutState.assign(static_cast<size_t>(numChannels * maxStages), svfState {});
+    reset();
+}
+
+void feedbackShaper::reset()
+{
+    for (auto& oversampler : oversamplers)
+    {
+        if (oversampler != nullptr)
+        {
+            oversampler->reset();
+        }
+    }
+    for (auto& oversampler : wideOversamplers)
+    {
+        if (oversampler != nullptr)
+        {
+            oversampler->reset();
+        }
+    }
+    lowCutSmoothed.setCurrentAndTargetValue(lowCutSmoothed.getTargetValue());
+    highCutSmoothed.setCurrentAndTargetValue(highCutSmoothed.getTargetValue());
+    driveSmoothed.setCurrentAndTargetValue(driveSmoothed.getTargetValue());
+    oversampling = driveSmoothed.getTargetValue() > 0.0f;
+    std::fill(lowCutState.begin(), lowCutState.end(), svfState {});
+    std::fill(highCutState.begin(), highCutState.end(), svfState {});
+}
+
+void feedbackShaper::setQuality(Quality newQuality)
+{
+    if (newQuality == quality)
+    {
+        return;
+    }
+    quality = newQuality;
+
+    if (auto* oversampler = getOversampler<float>())
+    {
+        oversampler->reset();
+    }
+    if (auto* oversampler = getOversampler<double>())
+    {
+        oversampler->reset();
+    }
+    std::fill(lowCutState.begin(), lowCutState.end(), svfState {});
+    std::fill(highCutState.begin(), highCutState.end(), svfState {});
+}
+
+void feedbackShaper::setParameters(float lowCutHz, float highCutHz, float drive)
+{
+    lowCutSmoothed.setTargetValue(juce::jlimit(minLowCutHz, maxLowCutHz, lowCutHz));
+    driveSmoothed.setTargetValue(juce::jlimit(0.0f, 1.0f, drive));
+    if (driveSmoothed.getTargetValue() > 0.0f)
+    {
+        setOversampling(true);
+    }
+
+    // switched on from off, it starts where it's set instead of sweeping down from the top
+    highCutHz = juce::jlimit(minHighCutHz, maxHighCutHz, highCutHz);
+    bool enable = highCutHz < maxHighCutHz;
+    if (enable && !highCutEnabled)
+    {
+        highCutSmoothed.setCurrentAndTargetValue(highCutHz);
+        std::fill(highCutState.begin(), highCutState.end(), svfState {});
+    }
+    highCutSmoothed.setTargetValue(highCutHz);
+    highCutEnabled = enable;
+}
+
+template <typename SampleType>
+juce::dsp::Oversampling<SampleType>* feedbackShaper::getOversampler() const
+{
+    size_t index;
+    switch (quality)
+    {
+        case Quality::normal:
+            index = 0;
+            break;
+        case Quality::high:
+            index = 1;
+            break;
+        case Quality::eco:
+        default:
+            return nullptr;
+    }
+
+    if constexpr (std::is_same_v<SampleType, double>)
+    {
+        return wideOversamplers[index].get();
+    }
+    else
+    {
+        return oversamplers[index].get();
+    }
+}
+
+void feedbackShaper::setOversampling(bool shouldOversample)
+{
+    if (shouldOversample == oversampling)
+    {
+        return;
+    }
+    oversampling = shouldOversample;
+
+    // whatever it held from last time is stale, it starts from silence
+    if (oversampling)
+    {
+        if (auto* oversampler = getOversampler<float>())
+        {
+            oversampler->reset();
+        }
+        if (auto* oversampler = getOversampler<double>())
+        {
+            oversampler->reset();
+        }
+    }
+}
+
+float feedbackShaper::getLatencySamples() const
+{
+    // both precisions use the same filters, so the same latency. the IIR's isn't whole,
+    // rounding it off would put every repeat that fraction late
+    auto* oversampler = getOversampler<float>();
+    return oversampling && oversampler != nullptr ? static_cast<float>(oversampler->getLatencyInSamples()) : 0.0f;
+}
+
+feedbackShaper::svfCoefficients feedbackShaper::makeCoefficients(float cutoffHz, int stage) const
+{
+    svfCoefficients coefficients;
+    cutoffHz = juce::jmin(cutoffHz, 0.45f * static_cast<float>(sampleRate));
+    float g = std::tan(juce::MathConstants<float>::pi * cutoffHz / static_cast<float>(sampleRate));
+    coefficients.k = getNumStages() == 1 ? singleStageDamping : butterworthDamping[static_cast<size_t>(stage)];
+    coefficients.a1 = 1.0f / (1.0f + g * (g + coefficients.k));
+    coefficients.a2 = g * coefficients.a1;
+    coefficients.a3 = g * coefficients.a2;
+    return coefficients;
+}
+
+template <typename SampleType>
+void feedbackShaper::filter(SampleType* const* channels, int numChannelsToProcess, int numSamples,
+    const svfCoefficients* coefficients, std::vector<svfState>& state, bool highPass)
+{
+    for (int stage = 0; stage < getNumStages(); ++stage)
+    {
+        const auto k = static_cast<SampleType>(coefficients[stage].k);
+        const auto a1 = static_cast<SampleType>(coefficients[stage].a1);
+        const auto a2 = static_cast<SampleType>(coefficients[stage].a2);
+        const auto a3 = static_cast<SampleType>(coefficients[stage].a3);
+        for (int channel = 0; channel < numChannelsToProcess; ++channel)
+        {
+            auto& s = state[static_cast<size_t>(channel * maxStages + stage)];
+            auto ic1 = static_cast<SampleType>(s.ic1);
+            auto ic2 = static_cast<SampleType>(s.ic2);
+            auto* data = channels[channel];
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                SampleType v0 = data[i];
+                SampleType v3 = v0 - ic2;
+                SampleType v1 = a1 * ic1 + a2 * v3;
+                SampleType v2 = ic2 + a2 * ic1 + a3 * v3;
+                ic1 = SampleType(2) * v1 - ic1;
+                ic2 = SampleType(2) * v2 - ic2;
+                data[i] = highPass ? v0 - k * v1 - v2 : v2;
+            }
+
+            s.ic1 = ic1;
+            s.ic2 = ic2;
+        }
+    }
+}
+
+template <typename SampleType>
+void feedbackShaper::saturate(SampleType* const* channels, int numChannelsToProcess, int numSamples, float driveStart, float driveEnd)
+{
+    // tanh(d (x + b)) - tanh(d b), over d: a slope of at most 1 at zero so the loop gain
+    // never rises, and flattening towards 1/d. the bias makes it lopsided, the low cut
+    // takes out the dc that leaves behind
+    float dStart = juce::jmax(1.0e-3f, driveStart * maxDrive);
+    float dEnd = juce::jmax(1.0e-3f, driveEnd * maxDrive);
+    float dStep = (dEnd - dStart) / static_cast<float>(numSamples);
+    float offsetStart = std::tanh(dStart * tapeBias);
+    float offsetStep = (std::tanh(dEnd * tapeBias) - offsetStart) / static_cast<float>(numSamples);
+
+    for (int channel = 0; channel < numChannelsToProcess; ++channel)
+    {
+        auto* data = channels[channel];
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto d = static_cast<SampleType>(dStart + dStep * static_cast<float>(i));
+            auto offset = static_cast<SampleType>(offsetStart + offsetStep * static_cast<float>(i));
+            data[i] = (std::tanh(d * (data[i] + static_cast<SampleType>(tapeBias))) - offset) / d;
+        }
+    }
+}
+
+template <typename SampleType>
+void feedbackShaper::process(SampleType* const* channels, int numChannelsToProcess, int numSamples)
+{
+    numChannelsToProcess = juce::jmin(numChannelsToProcess, numChannels);
+
+    // double needs the oversamplers from a double precision prepare()
+    jassert(quality == Quality::eco || getOversampler<SampleType>() != nullptr);
+
+    // the cutoffs glide in steps of coefficientInterval, each step filtered with fixed coefficients
+    for (int start = 0; start < numSamples; start += coefficientInterval)
+    {
+        int count = juce::jmin(coefficientInterval, numSamples - start);
+        std::array<SampleType*, 8> run {};
+        int numRunChannels = juce::jmin(numChannelsToProcess, static_cast<int>(run.size()));
+        for (int channel = 0; channel < numRunChannels; ++channel)
+        {
+            run[static_cast<size_t>(channel)] = channels[channel] + start;
+        }
+
+        std::array<svfCoefficients, maxStages> coefficients;
+        auto lowCut = lowCutSmoothed.skip(count);
+        for (int stage = 0; stage < getNumStages(); ++stage)
+        {
+            coefficients[static_cast<size_t>(stage)] = makeCoefficients(lowCut, stage);
+        }
+        filter(run.data(), numRunChannels, count, coefficients.data(), lowCutState, true);
+    }
+
+    // the oversampler works on the whole block, its latency stays the same while the drive
+    // moves. at 0 it's left out, so a clean loop isn't smeared by its filters every repeat
+    auto driveStart = driveSmoothed.getCurrentValue();
+    auto driveEnd = driveSmoothed.skip(numSamples);
+    bool saturating = driveStart > 0.0f || driveEnd > 0.0f;
+    auto* oversampler = oversampling ? getOversampler<SampleType>() : nullptr;
+
+    if (oversampler != nullptr)
+    {
+        juce::dsp::AudioBlock<SampleType> block(channels, static_cast<size_t>(numChannelsToProcess), static_cast<size_t>(numSamples));
+        auto oversampled = oversampler->processSamplesUp(block);
+        if (saturating)
+        {
+            std::array<SampleType*, 8> up {};
+            int numUpChannels = juce::jmin(numChannelsToProcess, static_cast<int>(up.size()));
+            for (int channel = 0; channel < numUpChannels; ++channel)
+            {
+                up[static_cast<size_t>(channel)] = oversampled.getChannelPointer(static_cast<size_t>(channel));
+            }
+            saturate(up.data(), numUpChannels, static_cast<int>(oversampled.getNumSamples()), driveStart, driveEnd);
+        }
+        oversampler->processSamplesDown(block);
+    }
+    else if (saturating)
+    {
+        saturate(channels, numChannelsToProcess, numSamples, driveStart, driveEnd);
+    }
+
+    // settled at 0, the next block goes without
+    if (!saturating && driveSmoothed.getTargetValue() <= 0.0f)
+    {
+        setOversampling(false);
+    }
+
+    if (!highCutEnabled && !highCutSmoothed.isSmoothing())
+    {
+        return;
+    }
+    for (int start = 0; start < numSamples; start += coefficientInterval)
+    {
+        int count = juce::jmin(coefficientInterval, numSamples - start);
+        std::array<SampleType*, 8> run {};
+        int numRunChannels = juce::jmin(numChannelsToProcess, static_cast<int>(run.size()));
+        for (int channel = 0; channel < numRunChannels; ++channel)
+        {
+            run[static_cast<size_t>(channel)] = channels[channel] + start;
+        }
+
+        std::array<svfCoefficients, maxStages> coefficients;
+        auto highCut = highCutSmoothed.skip(count);
+        for (int stage = 0; stage < getNumStages(); ++stage)
+        {
+            coefficients[static_cast<size_t>(stage)] = makeCoefficients(highCut, stage);
+        }
+        filter(run.data(), numRunChannels, count, coefficients.data(), highCutState, false);
+    }
+}
+
+template void feedbackShaper::process<float>(float* const*, int, int);
+template void feedbackShaper::process<double>(double* const*, int, int);
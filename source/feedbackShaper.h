@@ -0,0 +1,114 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+#ifndef FEEDBACKSHAPER_H
+#define FEEDBACKSHAPER_H
+
+// what the standard delay does to a block before it goes into the delay line: a
+// state variable low cut, a tape style saturator and a state variable high cut.
+// every repeat goes through it again, so the echoes darken, thin out and grind
+// down the way they do on tape. the saturator runs oversampled, which delays the
+// block by getLatencySamples(). the delay processor reads that much earlier so
+// the echoes still land on time. with the drive at 0 the oversampler is left out
+// and the loop is only the two filters
+class feedbackShaper {
+public:
+    // order matches the "quality" parameter
+    enum class Quality
+    {
+        eco,        // no oversampling, 12 dB/oct filters
+        normal,     // 2x polyphase IIR, 24 dB/oct filters
+        high        // 4x linear phase FIR, 24 dB/oct filters
+    };
+
+    static constexpr float minLowCutHz = 20.0f;
+    static constexpr float maxLowCutHz = 2000.0f;
+    static constexpr float minHighCutHz = 1000.0f;
+    static constexpr float maxHighCutHz = 20000.0f;
+
+    feedbackShaper();
+
+    // the oversamplers for every quality are built here, switching never allocates.
+    // doublePrecision builds the double ones as well
+    void prepare(double sampleRate, int numChannels, int maxBlockSize, bool doublePrecision = false);
+    void reset();
+
+    // switching resets the new quality's oversampler, so it isn't click free. nor is
+    // bringing the drive up from 0 or letting it settle there, which switch it in and out
+    void setQuality(Quality newQuality);
+    Quality getQuality() const { return quality; }
+
+    // the low cut is always on and keeps the saturator's dc out of the loop, the
+    // high cut is off at maxHighCutHz. drive 0 leaves the saturator out
+    void setParameters(float lowCutHz, float highCutHz, float drive);
+
+    // samples the oversampler delays the signal by, fractional for the IIR. 0 for eco
+    // and while the drive is at 0
+    float getLatencySamples() const;
+
+    // in place, numSamples up to the prepared block size. double needs a double precision prepare()
+    template <typename SampleType>
+    void process(SampleType* const* channels, int numChannels, int numSamples);
+
+private:
+    // Zavalishin's trapezoidal state variable filter, low or high pass
+    struct svfCoefficients
+    {
+        float k { 1.0f };
+        float a1 { 0.0f };
+        float a2 { 0.0f };
+        float a3 { 0.0f };
+    };
+
+    // double either way, a float path reads back exactly what it stored
+    struct svfState
+    {
+        double ic1 { 0.0 };
+        double ic2 { 0.0 };
+    };
+
+    static constexpr int maxStages = 2;
+    // cutoffs move to their new coefficients every this many samples
+    static constexpr int coefficientInterval = 32;
+
+    double sampleRate { 44100.0 };
+    int numChannels { 0 };
+    Quality quality { Quality::normal };
+
+    // normal and high, eco has none
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 2> oversamplers;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<double>>, 2> wideOversamplers;
+
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> lowCutSmoothed { minLowCutHz };
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> highCutSmoothed { maxHighCutHz };
+    juce::SmoothedValue<float> driveSmoothed;
+    bool highCutEnabled { false };
+    // the up/down pass runs from the block the drive leaves 0 until it has settled back there
+    bool oversampling { false };
+
+    // numChannels * maxStages each
+    std::vector<svfState> lowCutState;
+    std::vector<svfState> highCutState;
+
+    int getNumStages() const { return quality == Quality::eco ? 1 : maxStages; }
+    template <typename SampleType>
+    juce::dsp::Oversampling<SampleType>* getOversampler() const;
+    void setOversampling(bool shouldOversample);
+
+    svfCoefficients makeCoefficients(float cutoffHz, int stage) const;
+    template <typename SampleType>
+    void filter(SampleType* const* channels, int numChannels, int numSamples, const svfCoefficients* coefficients,
+        std::vector<svfState>& state, bool highPass);
+    template <typename SampleType>
+    void saturate(SampleType* const* channels, int numChannels, int numSamples, float driveStart, float driveEnd);
+};
+
+#endif //FEEDBACKSHAPER_H
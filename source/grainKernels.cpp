@@ -0,0 +1,307 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "grainKernels.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+
+// the x86 kernels are compiled with per-function target attributes, so the rest
+// of the plugin keeps its baseline flags and the choice is made at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+    #define ECHOES_X86_KERNELS 1
+    #include <immintrin.h>
+    #if defined(__GNUC__)
+        #define ECHOES_TARGET(isa) __attribute__((target(isa)))
+    #else
+        #define ECHOES_TARGET(isa)
+    #endif
+#else
+    #define ECHOES_X86_KERNELS 0
+#endif
+
+namespace grainKernels
+{
+    // unity pitch with the fraction already below one reads straight runs of source,
+    // anything else needs a gather
+    static bool isContiguous(const grainSpan& span)
+    {
+        return span.increment == 1.0f && span.readOffset < 1.0f;
+    }
+
+    // a grain at exactly pitch 1 starts on a whole sample and stays on them, so it is a
+    // scaled copy of the source. the interpolation it skips would add 0 times the slope
+    static bool isUnity(const grainSpan& span)
+    {
+        return span.increment == 1.0f && span.readOffset == 0.0f;
+    }
+
+    // shared by the reference kernel and the tails of the vectorised ones
+    static void renderScalarRange(const grainSpan& span, int start)
+    {
+        if (isUnity(span))
+        {
+            for (int i = start; i < span.numSamples; ++i)
+            {
+                span.output[i] += span.source[i] * span.envelope[i] * span.amplitude;
+            }
+            return;
+        }
+
+        if (isContiguous(span))
+        {
+            // the fraction is the same for the whole span
+            for (int i = start; i < span.numSamples; ++i)
+            {
+                float sample1 = span.source[i];
+                float sample2 = span.source[i + 1];
+                float interpolated = sample1 + span.readOffset * (sample2 - sample1);
+
+                span.output[i] += interpolated * span.envelope[i] * span.amplitude;
+            }
+            return;
+        }
+
+        for (int i = start; i < span.numSamples; ++i)
+        {
+            float position = span.readOffset + static_cast<float>(i) * span.increment;
+            int index = static_cast<int>(position);
+            float fraction = position - static_cast<float>(index);
+
+            float sample1 = span.source[index];
+            float sample2 = span.source[index + 1];
+            float interpolated = sample1 + fraction * (sample2 - sample1);
+
+            span.output[i] += interpolated * span.envelope[i] * span.amplitude;
+        }
+    }
+
+    void renderScalar(const grainSpan& span)
+    {
+        renderScalarRange(span, 0);
+    }
+
+#if ECHOES_X86_KERNELS
+    alignas(64) static const float laneOffsets[16] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f,
+        8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f };
+
+    ECHOES_TARGET("sse2")
+    static void renderSse2(const grainSpan& span)
+    {
+        const int numSamples = span.numSamples;
+        const __m128 amplitude = _mm_set1_ps(span.amplitude);
+        int i = 0;
+
+        if (isUnity(span))
+        {
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                __m128 grain = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(span.source + i), _mm_loadu_ps(span.envelope + i)), amplitude);
+                _mm_storeu_ps(span.output + i, _mm_add_ps(_mm_loadu_ps(span.output + i), grain));
+            }
+        }
+        else if (isContiguous(span))
+        {
+            const __m128 fraction = _mm_set1_ps(span.readOffset);
+
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                __m128 sample1 = _mm_loadu_ps(span.source + i);
+                __m128 sample2 = _mm_loadu_ps(span.source + i + 1);
+                __m128 interpolated = _mm_add_ps(sample1, _mm_mul_ps(fraction, _mm_sub_ps(sample2, sample1)));
+                __m128 grain = _mm_mul_ps(_mm_mul_ps(interpolated, _mm_loadu_ps(span.envelope + i)), amplitude);
+                _mm_storeu_ps(span.output + i, _mm_add_ps(_mm_loadu_ps(span.output + i), grain));
+            }
+        }
+        else
+        {
+            // no gather before avx2, the four lanes are loaded one by one
+            const __m128 lanes = _mm_load_ps(laneOffsets);
+            const __m128 increment = _mm_set1_ps(span.increment);
+            const __m128 readOffset = _mm_set1_ps(span.readOffset);
+            alignas(16) int indices[4];
+
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                __m128 sampleIndex = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lanes);
+                __m128 position = _mm_add_ps(readOffset, _mm_mul_ps(sampleIndex, increment));
+                __m128i index = _mm_cvttps_epi32(position);
+                __m128 fraction = _mm_sub_ps(position, _mm_cvtepi32_ps(index));
+                _mm_store_si128(reinterpret_cast<__m128i*>(indices), index);
+
+                const float* source = span.source;
+                __m128 sample1 = _mm_setr_ps(source[indices[0]], source[indices[1]], source[indices[2]], source[indices[3]]);
+                __m128 sample2 = _mm_setr_ps(source[indices[0] + 1], source[indices[1] + 1], source[indices[2] + 1], source[indices[3] + 1]);
+
+                __m128 interpolated = _mm_add_ps(sample1, _mm_mul_ps(fraction, _mm_sub_ps(sample2, sample1)));
+                __m128 grain = _mm_mul_ps(_mm_mul_ps(interpolated, _mm_loadu_ps(span.envelope + i)), amplitude);
+                _mm_storeu_ps(span.output + i, _mm_add_ps(_mm_loadu_ps(span.output + i), grain));
+            }
+        }
+
+        renderScalarRange(span, i);
+    }
+
+    ECHOES_TARGET("avx2")
+    static void renderAvx2(const grainSpan& span)
+    {
+        const int numSamples = span.numSamples;
+        const __m256 amplitude = _mm256_set1_ps(span.amplitude);
+        int i = 0;
+
+        if (isUnity(span))
+        {
+            for (; i + 8 <= numSamples; i += 8)
+            {
+                __m256 grain = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(span.source + i), _mm256_loadu_ps(span.envelope + i)), amplitude);
+                _mm256_storeu_ps(span.output + i, _mm256_add_ps(_mm256_loadu_ps(span.output + i), grain));
+            }
+        }
+        else if (isContiguous(span))
+        {
+            const __m256 fraction = _mm256_set1_ps(span.readOffset);
+
+            for (; i + 8 <= numSamples; i += 8)
+            {
+                __m256 sample1 = _mm256_loadu_ps(span.source + i);
+                __m256 sample2 = _mm256_loadu_ps(span.source + i + 1);
+                __m256 interpolated = _mm256_add_ps(sample1, _mm256_mul_ps(fraction, _mm256_sub_ps(sample2, sample1)));
+                __m256 grain = _mm256_mul_ps(_mm256_mul_ps(interpolated, _mm256_loadu_ps(span.envelope + i)), amplitude);
+                _mm256_storeu_ps(span.output + i, _mm256_add_ps(_mm256_loadu_ps(span.output + i), grain));
+            }
+        }
+        else
+        {
+            const __m256 lanes = _mm256_load_ps(laneOffsets);
+            const __m256 increment = _mm256_set1_ps(span.increment);
+            const __m256 readOffset = _mm256_set1_ps(span.readOffset);
+
+            for (; i + 8 <= numSamples; i += 8)
+            {
+                __m256 sampleIndex = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lanes);
+                __m256 position = _mm256_add_ps(readOffset, _mm256_mul_ps(sampleIndex, increment));
+                __m256i index = _mm256_cvttps_epi32(position);
+                __m256 fraction = _mm256_sub_ps(position, _mm256_cvtepi32_ps(index));
+
+                __m256 sample1 = _mm256_i32gather_ps(span.source, index, 4);
+                __m256 sample2 = _mm256_i32gather_ps(span.source + 1, index, 4);
+
+                __m256 interpolated = _mm256_add_ps(sample1, _mm256_mul_ps(fraction, _mm256_sub_ps(sample2, sample1)));
+                __m256 grain = _mm256_mul_ps(_mm256_mul_ps(interpolated, _mm256_loadu_ps(span.envelope + i)), amplitude);
+                _mm256_storeu_ps(span.output + i, _mm256_add_ps(_mm256_loadu_ps(span.output + i), grain));
+            }
+        }
+
+        renderScalarRange(span, i);
+    }
+
+    ECHOES_TARGET("avx512f")
+    static void renderAvx512(const grainSpan& span)
+    {
+        const int numSamples = span.numSamples;
+        const __m512 amplitude = _mm512_set1_ps(span.amplitude);
+        int i = 0;
+
+        if (isUnity(span))
+        {
+            for (; i + 16 <= numSamples; i += 16)
+            {
+                __m512 grain = _mm512_mul_ps(_mm512_mul_ps(_mm512_loadu_ps(span.source + i), _mm512_loadu_ps(span.envelope + i)), amplitude);
+                _mm512_storeu_ps(span.output + i, _mm512_add_ps(_mm512_loadu_ps(span.output + i), grain));
+            }
+        }
+        else if (isContiguous(span))
+        {
+            const __m512 fraction = _mm512_set1_ps(span.readOffset);
+
+            for (; i + 16 <= numSamples; i += 16)
+            {
+                __m512 sample1 = _mm512_loadu_ps(span.source + i);
+                __m512 sample2 = _mm512_loadu_ps(span.source + i + 1);
+                __m512 interpolated = _mm512_add_ps(sample1, _mm512_mul_ps(fraction, _mm512_sub_ps(sample2, sample1)));
+                __m512 grain = _mm512_mul_ps(_mm512_mul_ps(interpolated, _mm512_loadu_ps(span.envelope + i)), amplitude);
+                _mm512_storeu_ps(span.output + i, _mm512_add_ps(_mm512_loadu_ps(span.output + i), grain));
+            }
+        }
+        else
+        {
+            const __m512 lanes = _mm512_load_ps(laneOffsets);
+            const __m512 increment = _mm512_set1_ps(span.increment);
+            const __m512 readOffset = _mm512_set1_ps(span.readOffset);
+
+            for (; i + 16 <= numSamples; i += 16)
+            {
+                __m512 sampleIndex = _mm512_add_ps(_mm512_set1_ps(static_cast<float>(i)), lanes);
+                __m512 position = _mm512_add_ps(readOffset, _mm512_mul_ps(sampleIndex, increment));
+                __m512i index = _mm512_cvttps_epi32(position);
+                __m512 fraction = _mm512_sub_ps(position, _mm512_cvtepi32_ps(index));
+
+                __m512 sample1 = _mm512_i32gather_ps(index, span.source, 4);
+                __m512 sample2 = _mm512_i32gather_ps(index, span.source + 1, 4);
+
+                __m512 interpolated = _mm512_add_ps(sample1, _mm512_mul_ps(fraction, _mm512_sub_ps(sample2, sample1)));
+                __m512 grain = _mm512_mul_ps(_mm512_mul_ps(interpolated, _mm512_loadu_ps(span.envelope + i)), amplitude);
+                _mm512_storeu_ps(span.output + i, _mm512_add_ps(_mm512_loadu_ps(span.output + i), grain));
+            }
+        }
+
+        renderScalarRange(span, i);
+    }
+#endif
+
+    Kernel getKernel(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::scalar:
+                return renderScalar;
+#if ECHOES_X86_KERNELS
+            // sse2 is part of the x86-64 baseline
+            case Isa::sse2:
+                return renderSse2;
+            case Isa::avx2:
+                return juce::SystemStats::hasAVX2() ? renderAvx2 : nullptr;
+            case Isa::avx512:
+                return juce::SystemStats::hasAVX512F() ? renderAvx512 : nullptr;
+#endif
+            default:
+                return nullptr;
+        }
+    }
+
+    Isa getBestIsa()
+    {
+        static const Isa best = [] {
+            for (auto isa : { Isa::avx512, Isa::avx2, Isa::sse2 })
+            {
+                if (getKernel(isa) != nullptr)
+                {
+                    return isa;
+                }
+            }
+            return Isa::scalar;
+        }();
+
+        return best;
+    }
+
+    Kernel getBestKernel()
+    {
+        return getKernel(getBestIsa());
+    }
+
+    const char* getIsaName(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::sse2:
+                return "sse2";
+            case Isa::avx2:
+                return "avx2";
+            case Isa::avx512:
+                return "avx512";
+            case Isa::scalar:
+            default:
+                return "scalar";
+        }
+    }
+}
@@ -0,0 +1,50 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+
+#ifndef GRAINKERNELS_H
+#define GRAINKERNELS_H
+
+// the inner loop of every grain: an interpolated read from the delay line,
+// scaled by the envelope and amplitude and accumulated into the output.
+// read positions are relative to source, which must be contiguous for the
+// whole span (the grain processor stages wrapped spans before calling)
+struct grainSpan
+{
+    const float* source;
+    const float* envelope;
+    float* output;
+    float readOffset;   // 0 <= readOffset, position of the first output sample in source
+    float increment;    // source samples per output sample, 1 is unity pitch
+    float amplitude;
+    int numSamples;
+};
+
+namespace grainKernels
+{
+    enum class Isa
+    {
+        scalar,
+        sse2,
+        avx2,
+        avx512
+    };
+
+    using Kernel = void (*)(const grainSpan&);
+
+    // plain c++ version, the reference the vectorised kernels are tested against
+    void renderScalar(const grainSpan& span);
+
+    // nullptr when the kernel isn't built for this platform or the cpu can't run it
+    Kernel getKernel(Isa isa);
+
+    // fastest kernel the cpu supports, checked once at runtime
+    Isa getBestIsa();
+    Kernel getBestKernel();
+
+    const char* getIsaName(Isa isa);
+}
+
+#endif //GRAINKERNELS_H
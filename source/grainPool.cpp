@@ -0,0 +1,197 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "grainPool.h"
+
+grainPool::grainPool(){}
+
+void grainPool::prepare(int capacity)
+{
+    this->capacity = capacity;
+    limit = capacity;
+
+    auto size = static_cast<size_t>(capacity);
+    startPosition.assign(size, 0);
+    position.assign(size, 0);
+    length.assign(size, 0);
+    increment.assign(size, 1.0f);
+    amplitude.assign(size, 0.0f);
+    channel.assign(size, 0);
+    level.assign(size, 0);
+    releaseEnd.assign(size, noRelease);
+
+    activeSlots.assign(size, 0);
+    freeSlots.assign(size, 0);
+    clear();
+
+    numSpawned = 0;
+    numStolen = 0;
+    numRejected = 0;
+}
+
+void grainPool::clear()
+{
+    numActive = 0;
+    numReleasing = 0;
+    std::fill(releaseEnd.begin(), releaseEnd.end(), noRelease);
+
+    // lowest slots on top of the stack so a fresh pool fills from the front
+    numFree = capacity;
+    for (int i = 0; i < capacity; ++i)
+    {
+        freeSlots[static_cast<size_t>(i)] = capacity - 1 - i;
+    }
+}
+
+int grainPool::spawn(StealPolicy policy)
+{
+    if (numActive - numReleasing >= limit)
+    {
+        if (policy == StealPolicy::reject || numActive == numReleasing)
+        {
+            ++numRejected;
+            return -1;
+        }
+
+        ++numStolen;
+        auto victim = static_cast<size_t>(activeSlots[static_cast<size_t>(findVictim(policy))]);
+        if (releaseLength == 0)
+        {
+            // the victim keeps its place in the active list and is simply re-initialised by the caller
+            ++numSpawned;
+            return static_cast<int>(victim);
+        }
+
+        // cut off mid window it would click, so it fades out and retires on its own
+        releaseEnd[victim] = position[victim] + releaseLength;
+        ++numReleasing;
+    }
+
+    ++numSpawned;
+    int slot;
+    if (numFree > 0)
+    {
+        slot = freeSlots[static_cast<size_t>(--numFree)];
+        activeSlots[static_cast<size_t>(numActive++)] = slot;
+    }
+    else
+    {
+        // every slot is playing or fading, the fade closest to silence makes way
+        slot = activeSlots[static_cast<size_t>(findShortestRelease())];
+        --numReleasing;
+    }
+    releaseEnd[static_cast<size_t>(slot)] = noRelease;
+    return slot;
+}
+
+void grainPool::retire(int activeIndex)
+{
+    jassert(juce::isPositiveAndBelow(activeIndex, numActive));
+
+    int slot = activeSlots[static_cast<size_t>(activeIndex)];
+    auto& release = releaseEnd[static_cast<size_t>(slot)];
+    if (release != noRelease)
+    {
+        release = noRelease;
+        --numReleasing;
+    }
+
+    activeSlots[static_cast<size_t>(activeIndex)] = activeSlots[static_cast<size_t>(--numActive)];
+    freeSlots[static_cast<size_t>(numFree++)] = slot;
+}
+
+void grainPool::copyActiveFrom(const grainPool& other)
+{
+    jassert(other.capacity <= capacity);
+
+    numActive = other.numActive;
+    numReleasing = other.numReleasing;
+    releaseLength = other.releaseLength;
+
+    for (int i = 0; i < numActive; ++i)
+    {
+        auto slot = static_cast<size_t>(other.activeSlots[static_cast<size_t>(i)]);
+        activeSlots[static_cast<size_t>(i)] = static_cast<int>(slot);
+        startPosition[slot] = other.startPosition[slot];
+        position[slot] = other.position[slot];
+        length[slot] = other.length[slot];
+        increment[slot] = other.increment[slot];
+        amplitude[slot] = other.amplitude[slot];
+        channel[slot] = other.channel[slot];
+        level[slot] = other.level[slot];
+        releaseEnd[slot] = other.releaseEnd[slot];
+    }
+}
+
+int grainPool::findVictim(StealPolicy policy) const
+{
+    // only runs when the pool is at its limit, a scan of the dense active list is fine here.
+    // grains already fading out aren't stolen twice
+    int victim = -1;
+    float victimGain = 0.0f;
+
+    for (int i = 0; i < numActive; ++i)
+    {
+        auto candidate = static_cast<size_t>(activeSlots[static_cast<size_t>(i)]);
+        if (releaseEnd[candidate] != noRelease)
+        {
+            continue;
+        }
+
+        if (policy == StealPolicy::oldest)
+        {
+            if (victim < 0 || position[candidate] > position[static_cast<size_t>(activeSlots[static_cast<size_t>(victim)])])
+            {
+                victim = i;
+            }
+        }
+        else
+        {
+            // what the grain is playing right now, a loud grain near the end of its window is quiet
+            auto gain = getCurrentGain(candidate);
+            if (victim < 0 || gain < victimGain)
+            {
+                victim = i;
+                victimGain = gain;
+            }
+        }
+    }
+
+    jassert(victim >= 0);
+    return victim;
+}
+
+int grainPool::findShortestRelease() const
+{
+    int shortest = -1;
+    int shortestLeft = 0;
+
+    for (int i = 0; i < numActive; ++i)
+    {
+        auto slot = static_cast<size_t>(activeSlots[static_cast<size_t>(i)]);
+        if (releaseEnd[slot] != noRelease)
+        {
+            int left = releaseEnd[slot] - position[slot];
+            if (shortest < 0 || left < shortestLeft)
+            {
+                shortest = i;
+                shortestLeft = left;
+            }
+        }
+    }
+
+    jassert(shortest >= 0);
+    return shortest;
+}
+
+float grainPool::getCurrentGain(size_t slot) const
+{
+    if (windowLookup == nullptr || length[slot] <= 0)
+    {
+        return amplitude[slot];
+    }
+
+    auto phase = static_cast<float>(position[slot]) / static_cast<float>(length[slot]);
+    return amplitude[slot] * windowLookup(windowContext, juce::jlimit(0.0f, 1.0f, phase));
+}
@@ -0,0 +1,109 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <limits>
+#include <vector>
+
+#ifndef GRAINPOOL_H
+#define GRAINPOOL_H
+
+// grain state kept as structure-of-arrays. live grains are listed densely in
+// the active list and free slots sit on a stack, so spawning and retiring are
+// O(1) and the render loop never looks at an idle slot
+class grainPool {
+public:
+    // what spawn() does when every slot is taken
+    enum class StealPolicy
+    {
+        oldest,
+        quietest,
+        reject
+    };
+
+    grainPool();
+
+    // the only place the pool allocates
+    void prepare(int capacity);
+    void clear();
+
+    // returns the slot for the new grain, or -1 if the pool is full and the policy rejects.
+    // a stolen grain fades out over the release length and the new one gets a free slot,
+    // only when none is left does a release get cut short and its slot reused
+    int spawn(StealPolicy policy);
+
+    // retires the grain at activeIndex by swapping the last active grain into its place,
+    // so loops over the active list must not advance after retiring
+    void retire(int activeIndex);
+
+    int getCapacity() const { return capacity; }
+
+    // takes over other's active grains and their state, and nothing else. for a copy that
+    // is only rendered from: its free list is stale, so it must not spawn or retire
+    void copyActiveFrom(const grainPool& other);
+
+    // samples a stolen grain takes to fade out, 0 cuts it off and reuses its slot at once
+    void setReleaseLength(int numSamples) { releaseLength = juce::jmax(0, numSamples); }
+    int getReleaseLength() const { return releaseLength; }
+
+    // the window value at a phase (0..1 over the grain), so the quietest policy ranks
+    // grains by what they're playing now. without one it goes by amplitude alone
+    using WindowLookup = float (*)(const void* context, float phase);
+    void setWindowLookup(WindowLookup lookup, const void* context)
+    {
+        windowLookup = lookup;
+        windowContext = context;
+    }
+
+    // spawn() treats the pool as full once limit grains are active, releasing ones don't
+    // count. lowering it doesn't cut grains off, the extra ones finish on their own
+    void setLimit(int newLimit) { limit = juce::jlimit(1, capacity, newLimit); }
+    int getLimit() const { return limit; }
+
+    int getNumActive() const { return numActive; }
+    int getActiveSlot(int activeIndex) const { return activeSlots[static_cast<size_t>(activeIndex)]; }
+
+    // running totals since prepare(), for telemetry. a stolen grain counts as spawned too
+    uint32_t getNumSpawned() const { return numSpawned; }
+    uint32_t getNumStolen() const { return numStolen; }
+    uint32_t getNumRejected() const { return numRejected; }
+
+    // per-grain state, indexed by slot
+    std::vector<int> startPosition;
+    std::vector<int> position;
+    std::vector<int> length;
+    std::vector<float> increment;
+    std::vector<float> amplitude;
+    std::vector<int> channel;
+    std::vector<int> level;     // mip level the grain reads, 0 is the full rate delay line
+    std::vector<int> releaseEnd; // position a stolen grain is silent at, noRelease while it plays on
+
+    static constexpr int noRelease = std::numeric_limits<int>::max();
+
+private:
+    int capacity { 0 };
+    int limit { 0 };
+    int releaseLength { 0 };
+    int numReleasing { 0 };
+
+    WindowLookup windowLookup { nullptr };
+    const void* windowContext { nullptr };
+
+    std::vector<int> activeSlots;
+    int numActive { 0 };
+
+    std::vector<int> freeSlots;
+    int numFree { 0 };
+
+    uint32_t numSpawned { 0 };
+    uint32_t numStolen { 0 };
+    uint32_t numRejected { 0 };
+
+    int findVictim(StealPolicy policy) const;
+    int findShortestRelease() const;
+    float getCurrentGain(size_t slot) const;
+};
+
+#endif //GRAINPOOL_H
@@ -5,194 +5,555 @@
 #include "grainProcessor.h"
 
 grainProcessor::grainProcessor()
-    : sampleRate(44100.0), numChannels(2), delayBufferSize(0),
+    : sampleRate(44100.0), numChannels(2), delayBufferSize(0), delayMask(0), historySize(0), positionMask(0),
       grainTriggerCounter(0.0f), samplesPerGrain(0.0f),
-      randomEngine(std::random_device{}()), randomDist(0.0f, 1.0f),
       grainSizeMs(100.0f), grainDensityHz(10.0f), grainPitchRatio(1.0f),
       grainSpreadMs(50.0f)
 {
-    grains.resize(MAX_GRAINS);
 }
 
-grainProcessor::~grainProcessor() {}
-
-void grainProcessor::prepare (double sampleRate, int numChannels, float maxDelaySeconds)
+grainProcessor::~grainProcessor()
 {
-    delayBufferSize = static_cast<int>(sampleRate * maxDelaySeconds);
+    // a late job may still be writing into the buffers below
+    workerPool.stop();
+}
 
-    // reset all grains
-    for (auto& grain : grains)
-    {
-        grain.isActive = false;
-    }
+void grainProcessor::prepare (double sampleRate, int numChannels, int maxBlockSize, int delayBufferSize, int historyCapacity)
+{
+    this->sampleRate = sampleRate;
+    this->numChannels = numChannels;
+    this->delayBufferSize = delayBufferSize;
+    this->maxBlockSize = maxBlockSize;
+    jassert(juce::isPowerOfTwo(delayBufferSize));
+    jassert(historyCapacity == 0 || (juce::isPowerOfTwo(historyCapacity) && historyCapacity > delayBufferSize));
+    delayMask = delayBufferSize - 1;
+    positionMask = juce::jmax(delayBufferSize, historyCapacity) - 1;
+    historySize = delayBufferSize;
+
+    grainBuffer.setSize(numChannels, maxBlockSize);
+
+    // the threads only start once parallel rendering is asked for, see startWorkers().
+    // a job given up on in the last block has to be out of the buffers first
+    finishAbandonedJobs();
+    numPartitions = getNumWorkersToStart() + 1;
+    partialBuffers.setSize(numPartitions * numChannels, maxBlockSize);
+    lateBuffer.setSize(numChannels, maxBlockSize);
+    fallbackBlocksLeft = 0;
+
+    // the most source one block of the fastest grain can touch, plus the interpolation taps.
+    // one set for the audio thread and one per partition
+    stagingSize = static_cast<int>(std::ceil(maxBlockSize * maxGrainPitch)) + 3;
+    envelopeScratch.assign(static_cast<size_t>((numPartitions + 1) * maxBlockSize), 0.0f);
+    stagingScratch.assign(static_cast<size_t>((numPartitions + 1) * stagingSize), 0.0f);
+
+    // at most one onset per sample
+    grainOnsets.assign(static_cast<size_t>(maxBlockSize), 0);
+    grainRandoms.assign(static_cast<size_t>(maxBlockSize * numChannels * randomsPerGrain), 0.0f);
+
+    // enough slots for the densest, longest setting on every channel, plus one onset of slack
+    // and room for the grains still fading out after being stolen
+    auto releaseSamples = static_cast<int>(std::ceil(stealReleaseMs / 1000.0f * sampleRate));
+    auto grainsPerChannel = static_cast<int>(std::ceil(maxGrainDensityHz * maxGrainSizeMs / 1000.0f)) + 2
+                            + static_cast<int>(std::ceil(maxGrainDensityHz * stealReleaseMs / 1000.0f));
+    grains.prepare(grainsPerChannel * numChannels);
+    grains.setReleaseLength(releaseSamples);
+    grains.setWindowLookup(getWindowValue, this);
+    jobGrains.prepare(grains.getCapacity());
 
     grainTriggerCounter = 0.0f;
-    samplesPerGrain = static_cast<float>(sampleRate / grainDensityHz);
+    grainTimingStale = true;
+    updateGrainTiming();
+    random.setSeed(seed);
 }
 
-void grainProcessor::process (juce::AudioBuffer<float>& buffer,
-    const juce::AudioBuffer<float>& delayBuffer,
-    int writePosition, float grainSize, float grainDensity, float grainPitch,
-    float grainSpread, float wetDry)
+template <typename SampleType>
+void grainProcessor::process (juce::AudioBuffer<SampleType>& buffer,
+    const delayLine& delayBuffer, const historyStore& history, const delayMipmap& mipmap,
+    int historySamples, float grainSize, float grainDensity, float grainPitch,
+    float grainSpread, float wetDry, const float* wetDryRamp)
 {
-    grainSizeMs = grainSize;
-    grainDensityHz = grainDensity;
-    grainPitchRatio = grainPitch;
-    grainSpreadMs = grainSpread;
-
-    samplesPerGrain = static_cast<float>(sampleRate / grainDensityHz);
+    jassert(delayBuffer.getCapacity() == delayBufferSize);
+    jassert(buffer.getNumSamples() <= grainBuffer.getNumSamples());
+    jassert(history.isEnabled() == (positionMask != delayMask));
+
+    // without a history store grains can reach back as far as the delay line holds
+    int maxHistory = history.isEnabled() ? history.getMaxHistorySamples() : delayBufferSize;
+    historySize = juce::jlimit(1, maxHistory, historySamples);
+    setGrainParameters(grainSize, grainDensity, grainPitch, grainSpread);
+    if (grainTimingStale)
+    {
+        updateGrainTiming();
+    }
 
     int bufferSize = buffer.getNumSamples();
+    int writePosition = history.isEnabled() ? history.getWritePosition() : delayBuffer.getWritePosition();
+    int numOutputChannels = juce::jmin(numChannels, buffer.getNumChannels());
 
-    // make a temporary buffer for grain output
-    juce::AudioBuffer<float> grainBuffer(numChannels, bufferSize);
-    grainBuffer.clear();
+    // clear only the part of the grain scratch this block uses
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        grainBuffer.clear(ch, 0, bufferSize);
+    }
+
+    // work out this block's onsets before any grain is rendered
+    int numOnsets = scheduleGrainOnsets(bufferSize);
+    random.fillFloats(grainRandoms.data(), numOnsets * numChannels * randomsPerGrain);
+
+    // the delay line already holds this block, so sample ages count back from its end
+    currentDelayLine = &delayBuffer;
+    currentHistory = &history;
+    currentMipmap = &mipmap;
+    blockEndPosition = (writePosition + bufferSize) & positionMask;
 
-    // process each sample
-    for (int sample = 0; sample < bufferSize; ++sample)
+    // grains carried over from earlier blocks render from the top of the block,
+    // finished ones are swapped out of the active list so i stays put
+    auto* grainChannels = grainBuffer.getArrayOfWritePointers();
+
+    if (parallelRendering && numPartitions > 1)
+    {
+        renderActiveGrainsInPartitions(bufferSize);
+    }
+    else
     {
-        // check if we should trigger new grains
-        grainTriggerCounter += 1.0f;
-        if (grainTriggerCounter >= samplesPerGrain)
+        for (int i = 0; i < grains.getNumActive();)
         {
-            grainTriggerCounter -= samplesPerGrain;
-
-            for (int ch = 0; ch < numChannels; ++ch)
+            if (processGrain(grains.getActiveSlot(i), grainChannels, 0, bufferSize))
             {
-                triggerGrain(ch, (writePosition + sample) % delayBufferSize);
+                ++i;
             }
-        }
-
-        // process active grains
-        for (auto& grain : grains)
-        {
-            if (grain.isActive)
+            else
             {
-                processGrain(grain, grainBuffer, delayBuffer, bufferSize);
+                grains.retire(i);
             }
         }
     }
 
-    // mix grain output with original buffer
-    for (int ch = 0; ch < numChannels; ++ch)
+    // new grains render once, from their onset to the end of the block. one that already
+    // finishes inside the block stays listed and is retired on the next pass
+    for (int i = 0; i < numOnsets; ++i)
     {
-        auto* channelData = buffer.getWritePointer(ch);
-        auto* grainData = grainBuffer.getReadPointer(ch);
+        int onset = grainOnsets[static_cast<size_t>(i)];
 
-        for (int sample = 0; sample < bufferSize; ++sample)
+        for (int ch = 0; ch < numChannels; ++ch)
         {
-            float drySignal = channelData[sample];
-            float wetSignal = grainData[sample];
-            channelData[sample] = drySignal * (1.0f - wetDry) + wetSignal * wetDry;
+            auto* randoms = grainRandoms.data() + (i * numChannels + ch) * randomsPerGrain;
+            int slot = triggerGrain(ch, (writePosition + onset) & positionMask, randoms);
+            if (slot >= 0)
+            {
+                processGrain(slot, grainChannels, onset, bufferSize - onset);
+            }
         }
     }
+
+    // mix grain output with original buffer. grains render in float, the dry signal
+    // stays at the buffer's precision. fully wet or dry blocks skip the blend
+    auto mix = mixKernels::getKernel<SampleType, float>(wetDryRamp != nullptr ? mixKernels::shape::smoothedRamps(false)
+        : mixKernels::shape::of(1.0f, 1.0f, wetDry, 0.0f, numOutputChannels, false));
+    mixRun<SampleType, float> run { buffer.getArrayOfWritePointers(), 0, grainBuffer.getArrayOfReadPointers(),
+        nullptr, nullptr, numOutputChannels, bufferSize, 1.0f, 0.0f, 0, wetDry, 0.0f, wetDryRamp };
+    mix(run);
+    wetMeter.add(run.wetPeak, run.wetSquares, bufferSize * numOutputChannels);
 }
 
+template void grainProcessor::process<float>(juce::AudioBuffer<float>&, const delayLine&, const historyStore&,
+    const delayMipmap&, int, float, float, float, float, float, const float*);
+template void grainProcessor::process<double>(juce::AudioBuffer<double>&, const delayLine&, const historyStore&,
+    const delayMipmap&, int, float, float, float, float, float, const float*);
+
 void grainProcessor::setGrainParameters (float size, float density, float pitch, float spread)
 {
+    spread = juce::jlimit(0.0f, maxGrainSpreadMs, spread);
+    if (size == grainSizeMs && density == grainDensityHz && pitch == grainPitchRatio && spread == grainSpreadMs)
+    {
+        return;
+    }
+
     grainSizeMs = size;
     grainDensityHz = density;
     grainPitchRatio = pitch;
     grainSpreadMs = spread;
+    grainTimingStale = true;
+}
 
-    samplesPerGrain = static_cast<float>(sampleRate / grainDensityHz);
+void grainProcessor::updateGrainTiming()
+{
+    samplesPerGrain = static_cast<float>(sampleRate / (grainDensityHz * densityScale));
+    grainLengthSamples = static_cast<int>((grainSizeMs / 1000.0f) * sampleRate);
+    grainSpreadSamples = static_cast<int>((grainSpreadMs / 1000.0f) * sampleRate);
+    grainIncrement = juce::jlimit(0.0f, maxGrainPitch, grainPitchRatio);
+
+    // at least one grain per channel so a new onset can always steal
+    grains.setLimit(juce::jmax(numChannels, static_cast<int>(static_cast<float>(grains.getCapacity()) * grainLimit)));
+    grainTimingStale = false;
 }
 
-void grainProcessor::reset()
+void grainProcessor::fillGrainSnapshot(delayVisualFeed::grainSnapshot& snapshot) const
 {
-    for (auto& grain : grains)
+    int numGrains = juce::jmin(grains.getNumActive(), delayVisualFeed::maxVisualGrains);
+
+    for (int i = 0; i < numGrains; ++i)
     {
-        grain.isActive = false;
+        auto index = static_cast<size_t>(grains.getActiveSlot(i));
+        auto startAge = static_cast<float>((blockEndPosition - grains.startPosition[index]) & positionMask);
+        auto& marker = snapshot.grains[i];
+
+        // grains read forwards, towards the write head
+        marker.startAge = startAge;
+        marker.readAge = startAge - static_cast<float>(grains.position[index]) * grains.increment[index];
+        marker.amplitude = grains.amplitude[index];
     }
+
+    snapshot.numGrains = numGrains;
+}
+
+void grainProcessor::reset()
+{
+    grains.clear();
     grainTriggerCounter = 0.0f;
+    random.setSeed(seed);
+}
+
+void grainProcessor::setSeed(uint32_t newSeed)
+{
+    if (newSeed != seed)
+    {
+        seed = newSeed;
+        random.setSeed(seed);
+    }
+}
+
+void grainProcessor::startWorkers()
+{
+    if (!workerPool.isStarted())
+    {
+        workerPool.start(getNumWorkersToStart());
+    }
+}
+
+void grainProcessor::finishAbandonedJobs()
+{
+    while (workerPool.isBusy())
+    {
+        juce::Thread::yield();
+    }
+}
+
+int grainProcessor::getNumWorkersToStart()
+{
+    return juce::jlimit(0, maxGrainWorkers, juce::SystemStats::getNumCpus() - 1);
+}
+
+void grainProcessor::renderActiveGrainsInPartitions (int numSamples)
+{
+    // a job given up on in an earlier block is out by now, delayProcessor waited for it
+    // with finishAbandonedJobs() before this block's audio went into the delay line
+    jassert(!workerPool.isBusy());
+    bool denseEnough = grains.getNumActive() * numSamples >= numPartitions * minGrainSamplesPerPartition;
+    bool useWorkers = denseEnough && fallbackBlocksLeft == 0 && workerPool.isStarted();
+    fallbackBlocksLeft = juce::jmax(0, fallbackBlocksLeft - 1);
+
+    uint32_t finished = 0;
+    grainSource source { &grains, grainShape, grainTaper };
+    if (useWorkers)
+    {
+        // the workers render from a copy of the active grains, so a late one never sees them move on
+        jobGrains.copyActiveFrom(grains);
+        jobSource = { &jobGrains, grainShape, grainTaper };
+        jobPartialChannels = partialBuffers.getArrayOfWritePointers();
+        jobBlockSize = numSamples;
+        jobsAbandoned.store(false, std::memory_order_relaxed);
+
+        auto deadline = parallelDeadlineFraction * numSamples / sampleRate;
+        if (!workerPool.run(renderPartitionJob, this, numPartitions, deadline))
+        {
+            fallbackBlocksLeft = static_cast<int>(sampleRate / numSamples) + 1;
+        }
+        finished = workerPool.getFinishedJobs();
+        if (finished != (1u << numPartitions) - 1)
+        {
+            jobsAbandoned.store(true, std::memory_order_relaxed);
+        }
+        source = jobSource;
+    }
+
+    // fixed reduction order keeps the sums, and so the output, deterministic. a partition
+    // no worker finished is rendered here from the same grains, into the audio thread's
+    // own buffer, so it comes out the same either way
+    auto* lateChannels = lateBuffer.getArrayOfWritePointers();
+    for (int partition = 0; partition < numPartitions; ++partition)
+    {
+        int firstChannel = partition * numChannels;
+        const juce::AudioBuffer<float>* partial = &partialBuffers;
+        if (((finished >> partition) & 1u) == 0)
+        {
+            renderPartition(source, partition, lateChannels, numSamples, audioThreadScratch);
+            partial = &lateBuffer;
+            firstChannel = 0;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            grainBuffer.addFrom(ch, 0, *partial, firstChannel + ch, 0, numSamples);
+        }
+    }
+
+    // the partitions only read the grains, they move on here
+    for (int i = 0; i < grains.getNumActive();)
+    {
+        auto index = static_cast<size_t>(grains.getActiveSlot(i));
+        int grainEnd = juce::jmin(grains.length[index], grains.releaseEnd[index]);
+        grains.position[index] = juce::jmin(grainEnd, grains.position[index] + numSamples);
+
+        if (grains.channel[index] < numChannels && grains.position[index] < grainEnd)
+        {
+            ++i;
+        }
+        else
+        {
+            grains.retire(i);
+        }
+    }
 }
 
-void grainProcessor::triggerGrain (int channel, int delayBufferWritePos)
+void grainProcessor::renderPartition (const grainSource& source, int partition, float* const* outputChannels,
+    int numSamples, int scratchIndex)
 {
-    // find an inactive grain
-    for (auto& grain : grains)
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        juce::FloatVectorOperations::clear(outputChannels[ch], numSamples);
+    }
+
+    int numActive = source.pool->getNumActive();
+    int begin = partition * numActive / numPartitions;
+    int end = (partition + 1) * numActive / numPartitions;
+
+    for (int i = begin; i < end; ++i)
     {
-        if (!grain.isActive)
+        // given up on, the audio thread renders this partition itself
+        if (scratchIndex != audioThreadScratch && jobsAbandoned.load(std::memory_order_relaxed))
         {
-            grain.isActive = true;
-            grain.channel = channel;
-            grain.grainSize = static_cast<int>((grainSizeMs / 1000.0f) * sampleRate);
-            // set random amplitude variation
-            grain.amplitude = 0.5f + (randomDist(randomEngine) * 0.5f);
-
-            // set start position with random spread
-            int spreadSamples = static_cast<int>((grainSpreadMs / 1000.0f) * sampleRate);
-            int randomOffset = static_cast<int>((randomDist(randomEngine) - 0.5f) * 2.0f * spreadSamples);
-            grain.startPosition = getRandomDelayPosition(delayBufferWritePos + randomOffset);
-            grain.currentPosition = 0;
-
-            break; // only trigger one grain per call
+            return;
         }
+        renderGrain(source, source.pool->getActiveSlot(i), outputChannels, 0, numSamples, scratchIndex);
     }
 }
 
-float grainProcessor::getGrainEnvelope (const Grain& grain) const
+void grainProcessor::renderPartitionJob (void* context, int partition)
 {
-    if (grain.grainSize <= 0)
-        return 0.0f;
+    // runs on a worker or the audio thread, touches only this partition's partial and scratch
+    auto* processor = static_cast<grainProcessor*>(context);
+    processor->renderPartition(processor->jobSource, partition,
+        processor->jobPartialChannels + partition * processor->numChannels, processor->jobBlockSize, partition + 1);
+}
 
-    float progress = static_cast<float>(grain.currentPosition) / static_cast<float>(grain.grainSize);
+float grainProcessor::getWindowValue (const void* context, float phase)
+{
+    auto* processor = static_cast<const grainProcessor*>(context);
+    return processor->windows->getValue(processor->grainShape, phase, processor->grainTaper);
+}
 
-    // Hann window envelope
-    if (progress >= 1.0f)
+int grainProcessor::scheduleGrainOnsets (int numSamples)
+{
+    // closed form of "counter += 1 every sample, fire when it reaches samplesPerGrain",
+    // jumping straight from one onset to the next
+    int numOnsets = 0;
+    int position = 0;
+
+    while (true)
     {
-        return 0.0f;
+        int steps = juce::jmax(1, static_cast<int>(std::ceil(samplesPerGrain - grainTriggerCounter)));
+
+        if (position + steps > numSamples)
+        {
+            grainTriggerCounter += static_cast<float>(numSamples - position);
+            break;
+        }
+
+        position += steps;
+        grainTriggerCounter += static_cast<float>(steps) - samplesPerGrain;
+        grainOnsets[static_cast<size_t>(numOnsets++)] = position - 1;
     }
 
-    return 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * progress));
+    return numOnsets;
 }
 
-int grainProcessor::getRandomDelayPosition (int writePosition)
+int grainProcessor::triggerGrain (int channel, int delayBufferWritePos, const float* randoms)
 {
-    int pos = writePosition - static_cast<int>((randomDist(randomEngine) * 0.8f + 0.1f) * delayBufferSize);
-    if (pos < 0)
+    int slot = grains.spawn(stealPolicy);
+    if (slot < 0)
     {
-        pos += delayBufferSize;
+        return -1;
     }
-    return pos % delayBufferSize;
+
+    auto index = static_cast<size_t>(slot);
+    grains.channel[index] = channel;
+    grains.length[index] = grainLengthSamples;
+    grains.increment[index] = grainIncrement;
+    // set random amplitude variation
+    grains.amplitude[index] = 0.5f + (randoms[0] * 0.5f);
+
+    // set start position with random spread
+    int randomOffset = static_cast<int>((randoms[1] - 0.5f) * 2.0f * grainSpreadSamples);
+    grains.startPosition[index] = getRandomDelayPosition(delayBufferWritePos + randomOffset, randoms[2]);
+    grains.position[index] = 0;
+    grains.level[index] = getMipLevel(grains.startPosition[index], grains.length[index], grains.increment[index]);
+
+    return slot;
 }
 
-void grainProcessor::processGrain (Grain& grain, juce::AudioBuffer<float>& outputBuffer,
-    const juce::AudioBuffer<float>& delayBuffer, int bufferSize)
+int grainProcessor::getRandomDelayPosition (int writePosition, float randomValue)
 {
-    if (!grain.isActive || grain.channel >= numChannels)
+    int pos = writePosition - static_cast<int>((randomValue * 0.8f + 0.1f) * historySize);
+    return pos & positionMask;
+}
+
+int grainProcessor::getMipLevel (int startPosition, int length, float increment) const
+{
+    int level = delayMipmap::getLevelForIncrement(increment);
+    if (level == 0)
     {
-        return;
+        return 0;
     }
 
-    auto* outputData = outputBuffer.getWritePointer(grain.channel);
-    auto* delayData = delayBuffer.getReadPointer(grain.channel);
+    // pitched up, the grain catches up with the write position as it plays, so its newest
+    // read is at the end. allow a block for the one not appended yet and one for the onset
+    int age = (blockEndPosition - startPosition) & positionMask;
+    int ageAtEnd = age - static_cast<int>(std::ceil(static_cast<float>(length) * (increment - 1.0f)));
+    bool filledInTime = ageAtEnd > currentMipmap->getLatency(level) + 2 * maxBlockSize;
+    bool insideLevels = age < delayBufferSize - maxBlockSize;
 
-    for (int sample = 0; sample < bufferSize && grain.isActive; ++sample)
+    return filledInTime && insideLevels ? level : 0;
+}
+
+bool grainProcessor::processGrain (int slot, float* const* outputChannels, int startSample, int numSamples)
+{
+    auto index = static_cast<size_t>(slot);
+    int samplesRendered = renderGrain({ &grains, grainShape, grainTaper }, slot, outputChannels, startSample,
+        numSamples, audioThreadScratch);
+    grains.position[index] += samplesRendered;
+
+    return samplesRendered > 0 && grains.position[index] < juce::jmin(grains.length[index], grains.releaseEnd[index]);
+}
+
+int grainProcessor::renderGrain (const grainSource& source, int slot, float* const* outputChannels,
+    int startSample, int numSamples, int scratchIndex)
+{
+    const auto& pool = *source.pool;
+    auto index = static_cast<size_t>(slot);
+    int grainChannel = pool.channel[index];
+    if (grainChannel >= numChannels)
     {
-        if (grain.currentPosition >= grain.grainSize)
+        return 0;
+    }
+
+    auto* outputData = outputChannels[grainChannel] + startSample;
+
+    int startPosition = pool.startPosition[index];
+    int grainLength = pool.length[index];
+    float increment = pool.increment[index];
+    float amplitude = pool.amplitude[index];
+
+    // one contiguous span, up to the end of the block or of the grain, or of its release
+    int releaseEnd = pool.releaseEnd[index];
+    int grainEnd = juce::jmin(grainLength, releaseEnd);
+    int samplesToRender = juce::jmin(numSamples, grainEnd - pool.position[index]);
+    if (samplesToRender <= 0)
+    {
+        return 0;
+    }
+
+    // the span's envelope comes from the shared tables, no transcendentals per sample
+    auto* envelope = envelopeScratch.data() + scratchIndex * grainBuffer.getNumSamples();
+    float phaseIncrement = 1.0f / static_cast<float>(grainLength);
+    windows->fillEnvelope(envelope, samplesToRender, static_cast<float>(pool.position[index]) * phaseIncrement,
+        phaseIncrement, source.shape, source.taper);
+
+    // stolen, it ramps down to nothing over the rest of its release
+    if (releaseEnd != grainPool::noRelease)
+    {
+        float releaseStep = 1.0f / static_cast<float>(pool.getReleaseLength());
+        float releaseGain = static_cast<float>(releaseEnd - pool.position[index]) * releaseStep;
+        for (int i = 0; i < samplesToRender; ++i)
         {
-            grain.isActive = false;
-            break;
+            envelope[i] *= releaseGain - static_cast<float>(i) * releaseStep;
         }
+    }
+
+    // read position relative to the grain start, in double so the fraction keeps its
+    // precision however far into a long grain we are
+    double startOffset = static_cast<double>(pool.position[index]) * increment;
+    int wholeOffset = static_cast<int>(startOffset);
+    int firstIndex = (startPosition + wholeOffset) & positionMask;
+    auto fraction = static_cast<float>(startOffset - wholeOffset);
+
+    grainSpan span;
+    span.envelope = envelope;
+    span.output = outputData;
+    span.amplitude = amplitude;
+    span.numSamples = samplesToRender;
+
+    // mip level samples sit at every (1 << level)th full rate position, so the read
+    // position and the increment scale down with the rate
+    int level = pool.level[index];
+    int step = 1 << level;
+    span.readOffset = (static_cast<float>(firstIndex & (step - 1)) + fraction) / static_cast<float>(step);
+    span.increment = increment / static_cast<float>(step);
+
+    // source samples the span touches, including the tap after the last one and one
+    // more in case a vector kernel rounds the last position up
+    int sourceLength = static_cast<int>(span.readOffset + static_cast<float>(samplesToRender - 1) * span.increment) + 3;
+    span.source = level > 0 ? getMipSpan(level, grainChannel, firstIndex >> level, sourceLength, scratchIndex)
+                            : getSourceSpan(grainChannel, firstIndex, sourceLength, scratchIndex);
+
+    renderSpan(span);
+    return samplesToRender;
+}
+
+const float* grainProcessor::getSourceSpan (int channel, int position, int numSamples, int scratchIndex)
+{
+    jassert(numSamples <= stagingSize);
+    auto* staging = stagingScratch.data() + scratchIndex * stagingSize;
+
+    // samples older than the delay line holds come from the history store, the
+    // span runs forward in time so those are always at its start
+    int age = (blockEndPosition - position) & positionMask;
+    int numOld = juce::jlimit(0, numSamples, age - delayBufferSize);
+    if (numOld > 0)
+    {
+        currentHistory->readSpan(channel, position, numOld, staging);
+    }
 
-        // calculate read position with pitch shifting
-        float readPos = grain.startPosition + (grain.currentPosition * grainPitchRatio);
-        int readIndex = static_cast<int>(readPos) % delayBufferSize;
+    int ringIndex = (position + numOld) & delayMask;
+    int numRecent = numSamples - numOld;
 
-        // linear interpolation for fractional positions
-        float fraction = readPos - static_cast<int>(readPos);
-        int nextIndex = (readIndex + 1) % delayBufferSize;
+    if (numOld == 0 && ringIndex + numRecent <= delayBufferSize
+        && currentDelayLine->getStorage() == delayLine::Storage::float32)
+    {
+        return currentDelayLine->getReadPointer(channel) + ringIndex;
+    }
 
-        float sample1 = delayData[readIndex];
-        float sample2 = delayData[nextIndex];
-        float interpolatedSample = sample1 + fraction * (sample2 - sample1);
+    // crossing from the store into the ring, around the end of the ring, or
+    // converting from a 16-bit delay line
+    currentDelayLine->readSpan(channel, ringIndex, numRecent, staging + numOld);
+    return staging;
+}
 
-        // apply grain envelope and amplitude
-        float envelope = getGrainEnvelope(grain);
-        float grainSample = interpolatedSample * envelope * grain.amplitude;
+const float* grainProcessor::getMipSpan (int level, int channel, int index, int numSamples, int scratchIndex)
+{
+    jassert(numSamples <= stagingSize);
+    auto* levelData = currentMipmap->getReadPointer(level, channel);
+    int capacity = currentMipmap->getCapacity(level);
+    index &= currentMipmap->getMask(level);
 
-        outputData[sample] += grainSample;
-        grain.currentPosition++;
+    if (index + numSamples <= capacity)
+    {
+        return levelData + index;
     }
-}
\ No newline at end of file
+
+    // around the end of the ring
+    auto* staging = stagingScratch.data() + scratchIndex * stagingSize;
+    int firstPart = capacity - index;
+    std::copy(levelData + index, levelData + capacity, staging);
+    std::copy(levelData, levelData + (numSamples - firstPart), staging + firstPart);
+    return staging;
+}
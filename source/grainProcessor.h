@@ -3,71 +3,240 @@
 //
 
 #pragma once
+#include "delayLine.h"
+#include "delayMipmap.h"
+#include "delayVisualFeed.h"
+#include "engineTelemetry.h"
+#include "fastRandom.h"
+#include "grainKernels.h"
+#include "grainPool.h"
+#include "grainWorkerPool.h"
+#include "historyStore.h"
+#include "grainWindows.h"
+#include "mixKernels.h"
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <vector>
-#include <random>
-
-using random_engine = std::mt19937;
 
 #ifndef GRAINPROCESSOR_H
 #define GRAINPROCESSOR_H
 
-// struct to hold the grains
-struct Grain
-{
-    int startPosition;
-    int currentPosition;
-    int grainSize;
-    float amplitude;
-    bool isActive;
-    int channel;
-
-    Grain() : startPosition(0), currentPosition (0), grainSize(0),
-    amplitude(0.0f), isActive(false), channel(0) {}
-};
-
 class grainProcessor {
 public:
     grainProcessor();
     ~grainProcessor();
 
-    void prepare(double sampleRate, int numChannels, float maxDelaySeconds);
-    void process(juce::AudioBuffer<float>& buffer,
-        const juce::AudioBuffer<float>& delayBuffer,
-        int writePosition, float grainSize, float grainDensity,
-        float grainPitch, float grainSpread, float wetDry);
+    // delayBufferSize is the (power of two) capacity of the delay line handed to process(),
+    // historyCapacity that of the history store, 0 when there is none
+    void prepare(double sampleRate, int numChannels, int maxBlockSize, int delayBufferSize, int historyCapacity = 0);
 
+    // historySamples limits how far back grains may start. grains read recent audio from
+    // the delay line (or its mipmap when pitched up) and anything older from the history
+    // store, when it's enabled. grains render in float and are mixed into either precision.
+    // wetDryRamp, when there is one, has the block's wetDry per sample
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer,
+        const delayLine& delayBuffer, const historyStore& history, const delayMipmap& mipmap,
+        int historySamples, float grainSize, float grainDensity,
+        float grainPitch, float grainSpread, float wetDry, const float* wetDryRamp = nullptr);
+
+    // the grain timing in samples is only worked out again when one of these changes
     void setGrainParameters(float size, float density,
         float pitch, float spread);
+    void setStealPolicy(grainPool::StealPolicy policy) { stealPolicy = policy; }
+    void setGrainShape(grainWindows::Shape shape, float taper)
+    {
+        grainShape = shape;
+        grainTaper = taper;
+    }
     void reset();
 
+    // grains are placed from a seeded generator, the same seed and input give the same output.
+    // the generator restarts from the seed on prepare() and reset()
+    void setSeed(uint32_t newSeed);
+
+    // splits the grains carried over between blocks across a worker pool. the
+    // split is fixed, so the output is the same whether the workers keep up or not.
+    // the partitions run on the audio thread alone until startWorkers() has been called
+    void setParallelRendering(bool shouldRenderInParallel) { parallelRendering = shouldRenderInParallel; }
+
+    // starts the worker threads the first time it's called, never call it on the audio thread.
+    // instances that never render in parallel never start any
+    void startWorkers();
+    int getNumWorkers() const { return workerPool.getNumWorkers(); }
+
+    // a job the workers were given up on may still be reading the delay line, the history store
+    // and the mipmap, so call this before writing any of them. the job checks before every
+    // grain, so it waits for one grain's span at most
+    void finishAbandonedJobs();
+
+    // load shedding: densityScale thins out the onsets, grainLimit caps the share of
+    // the pool that may be active at once. both are 1 at full quality
+    void setGrainBudget(float newDensityScale, float newGrainLimit)
+    {
+        newDensityScale = juce::jlimit(0.01f, 1.0f, newDensityScale);
+        newGrainLimit = juce::jlimit(0.0f, 1.0f, newGrainLimit);
+        grainTimingStale = grainTimingStale || newDensityScale != densityScale || newGrainLimit != grainLimit;
+        densityScale = newDensityScale;
+        grainLimit = newGrainLimit;
+    }
+
+    // for telemetry: grain counts, and the level of the grain output, accumulated until the caller clears it
+    const grainPool& getGrainPool() const { return grains; }
+    signalMeter& getWetMeter() { return wetMeter; }
+
+    // where the active grains started and are reading now, relative to the end of the last block
+    void fillGrainSnapshot(delayVisualFeed::grainSnapshot& snapshot) const;
+
+    // parameter ranges the pool is sized for, the densest, longest clouds run to about
+    // a thousand grains at once
+    static constexpr float maxGrainDensityHz = 1000.0f;
+    static constexpr float maxGrainSizeMs = 500.0f;
+    static constexpr float maxGrainPitch = 4.0f;
+    static constexpr float maxGrainSpreadMs = 200.0f;
+
+    // worker threads on top of the audio thread, when the machine has the cores
+    static constexpr int maxGrainWorkers = 3;
+
+    // how long a stolen grain takes to fade out
+    static constexpr float stealReleaseMs = 2.0f;
+
 private:
-    static constexpr int MAX_GRAINS = 1000;
-    std::vector<Grain> grains;
+    grainPool grains;
+    grainPool::StealPolicy stealPolicy { grainPool::StealPolicy::oldest };
 
     double sampleRate;
     int numChannels;
     int delayBufferSize;
+    int delayMask;
+    int historySize;
+
+    // grain positions are in the history store's index space when there is one,
+    // the delay line's otherwise
+    int positionMask;
+
+    // grain output, sized in prepare()
+    juce::AudioBuffer<float> grainBuffer;
+    signalMeter wetMeter;
+
+    // scratch for the audio thread at index 0, then one per partition: envelopes, and
+    // contiguous copies of grain sources that wrap around the delay line
+    static constexpr int audioThreadScratch = 0;
+    std::vector<float> envelopeScratch;
+    std::vector<float> stagingScratch;
+    int stagingSize { 0 };
+
+    // simd inner loop, picked once for this cpu
+    grainKernels::Kernel renderSpan { grainKernels::getBestKernel() };
+
+    // window tables are shared by every instance in the process
+    juce::SharedResourcePointer<grainWindows> windows;
+    grainWindows::Shape grainShape { grainWindows::Shape::hann };
+    float grainTaper { 0.5f };
 
     // grain scheduling
     float grainTriggerCounter;
     float samplesPerGrain;
 
-    random_engine randomEngine;
-    std::uniform_real_distribution<float> randomDist;
+    // sample offsets of the grain onsets in the current block, sized in prepare()
+    std::vector<int> grainOnsets;
+
+    // amplitude, spread and history position
+    static constexpr int randomsPerGrain = 3;
+
+    fastRandom random;
+    uint32_t seed { 0 };
+
+    // every random the block's grains use, drawn in one go after scheduling, sized in prepare()
+    std::vector<float> grainRandoms;
 
     // parameters
     float grainSizeMs;
     float grainDensityHz;
     float grainPitchRatio;
     float grainSpreadMs;
+    float densityScale { 1.0f };
+    float grainLimit { 1.0f };
+
+    // what the parameters come to in samples, the same for every grain until one of
+    // them changes. updateGrainTiming() works them out at the next block
+    int grainLengthSamples { 0 };
+    int grainSpreadSamples { 0 };
+    float grainIncrement { 1.0f };
+    bool grainTimingStale { true };
+    void updateGrainTiming();
+
+    // what a grain is rendered from: the live pool, or the copy the workers get
+    struct grainSource
+    {
+        const grainPool* pool;
+        grainWindows::Shape shape;
+        float taper;
+    };
+
+    // parallel rendering: partition k sums its share of the active list into its own
+    // channels of partialBuffers, the partials are then added up in partition order.
+    // a partition a worker doesn't finish by the deadline is rendered again into
+    // lateBuffer on the audio thread, and the worker's result is thrown away
+    grainWorkerPool workerPool;
+    bool parallelRendering { false };
+    int numPartitions { 1 };
+    juce::AudioBuffer<float> partialBuffers;
+    juce::AudioBuffer<float> lateBuffer;
+    grainPool jobGrains;
+    grainSource jobSource { &jobGrains, grainWindows::Shape::hann, 0.5f };
+    std::atomic<bool> jobsAbandoned { false };
+
+    // this block's sources, set on the audio thread before any grain renders
+    const delayLine* currentDelayLine { nullptr };
+    const historyStore* currentHistory { nullptr };
+    const delayMipmap* currentMipmap { nullptr };
+    int blockEndPosition { 0 };
+    int maxBlockSize { 0 };
+
+    // set up on the audio thread before the jobs run, the jobs only read them
+    float* const* jobPartialChannels { nullptr };
+    int jobBlockSize { 0 };
+
+    // a block the workers didn't finish in time runs the partitions inline for about a second
+    static constexpr double parallelDeadlineFraction = 0.5;
+    // grain samples a block needs per partition before waking the workers pays for itself,
+    // sparser clouds run the partitions on the audio thread
+    static constexpr int minGrainSamplesPerPartition = 8192;
+    int fallbackBlocksLeft { 0 };
+
+    static int getNumWorkersToStart();
+    void renderActiveGrainsInPartitions(int numSamples);
+    void renderPartition(const grainSource& source, int partition, float* const* outputChannels, int numSamples,
+        int scratchIndex);
+    static void renderPartitionJob(void* context, int partition);
+
+    // the pool's quietest steal looks at the window through this
+    static float getWindowValue(const void* context, float phase);
 
     // helper methods
-    void triggerGrain(int channel, int delayBufferWritePos);
-    float getGrainEnvelope(const Grain& grain) const;
-    int getRandomDelayPosition(int writePosition);
-    void processGrain(Grain& grain, juce::AudioBuffer<float>& outputBuffer,
-        const juce::AudioBuffer<float>& delayBuffer, int bufferSize);
+    int scheduleGrainOnsets(int numSamples);
+    int triggerGrain(int channel, int delayBufferWritePos, const float* randoms);
+    int getRandomDelayPosition(int writePosition, float randomValue);
+
+    // the mip level a new grain reads for its whole life, full rate unless every
+    // position it will reach is inside the levels and already filled
+    int getMipLevel(int startPosition, int length, float increment) const;
+
+    // renders the grain in slot from startSample until the block or the grain ends and
+    // moves it on, returns false once the grain has finished
+    bool processGrain(int slot, float* const* outputChannels, int startSample, int numSamples);
+
+    // the rendering alone, returns the samples rendered. it only reads the grains, so
+    // workers can render from a copy. scratchIndex picks the thread's scratch
+    int renderGrain(const grainSource& source, int slot, float* const* outputChannels, int startSample,
+        int numSamples, int scratchIndex);
+
+    // numSamples of contiguous source from position, straight out of the delay line when
+    // possible, otherwise gathered into the partition's staging scratch
+    const float* getSourceSpan(int channel, int position, int numSamples, int scratchIndex);
+
+    // the same from a mip level, index is in that level's samples
+    const float* getMipSpan(int level, int channel, int index, int numSamples, int scratchIndex);
 };
 
 #endif //GRAINPROCESSOR_H
@@ -0,0 +1,119 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "grainWindows.h"
+
+grainWindows::grainWindows()
+{
+    constexpr float twoPi = juce::MathConstants<float>::twoPi;
+
+    // gaussian and exponential are offset and rescaled so they still land on zero at the edges
+    constexpr float gaussianSigma = 1.0f / 6.0f;
+    const float gaussianEdge = std::exp(-0.5f * juce::square(0.5f / gaussianSigma));
+
+    // short hann attack, then roughly -60 dB of decay over the rest of the grain
+    constexpr float attack = 0.02f;
+    constexpr float decayRate = 6.9f;
+    const float decayEnd = std::exp(-decayRate);
+
+    for (int i = 0; i <= tableSize; ++i)
+    {
+        float phase = static_cast<float>(i) / static_cast<float>(tableSize);
+        auto index = static_cast<size_t>(i);
+
+        hann[index] = 0.5f * (1.0f - std::cos(twoPi * phase));
+
+        float gaussianValue = std::exp(-0.5f * juce::square((phase - 0.5f) / gaussianSigma));
+        gaussian[index] = (gaussianValue - gaussianEdge) / (1.0f - gaussianEdge);
+
+        triangle[index] = 1.0f - std::abs(2.0f * phase - 1.0f);
+
+        if (phase < attack)
+        {
+            exponential[index] = 0.5f * (1.0f - std::cos(juce::MathConstants<float>::pi * phase / attack));
+        }
+        else
+        {
+            float decayValue = std::exp(-decayRate * (phase - attack) / (1.0f - attack));
+            exponential[index] = (decayValue - decayEnd) / (1.0f - decayEnd);
+        }
+    }
+}
+
+const grainWindows::Table& grainWindows::getTable(Shape shape) const
+{
+    switch (shape)
+    {
+        case Shape::gaussian:
+            return gaussian;
+        case Shape::trapezoid:
+            return triangle;
+        case Shape::exponential:
+            return exponential;
+        case Shape::hann:
+        case Shape::tukey:
+        default:
+            return hann;
+    }
+}
+
+float grainWindows::lookup(const Table& table, float phase)
+{
+    float position = juce::jlimit(0.0f, 1.0f, phase) * static_cast<float>(tableSize);
+    int index = juce::jmin(static_cast<int>(position), tableSize - 1);
+    float fraction = position - static_cast<float>(index);
+
+    float value1 = table[static_cast<size_t>(index)];
+    float value2 = table[static_cast<size_t>(index + 1)];
+    return value1 + fraction * (value2 - value1);
+}
+
+float grainWindows::remapForTaper(float phase, float taper)
+{
+    // rising half of the table over the first taper/2, falling half over the last,
+    // and the peak in between
+    float halfTaper = 0.5f * taper;
+
+    if (phase < halfTaper)
+    {
+        return phase / taper;
+    }
+    if (phase > 1.0f - halfTaper)
+    {
+        return 1.0f - (1.0f - phase) / taper;
+    }
+    return 0.5f;
+}
+
+void grainWindows::fillEnvelope(float* destination, int numSamples, float phase, float phaseIncrement,
+    Shape shape, float taper) const
+{
+    const auto& table = getTable(shape);
+
+    if (shape == Shape::tukey || shape == Shape::trapezoid)
+    {
+        taper = juce::jlimit(0.001f, 1.0f, taper);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            destination[i] = lookup(table, remapForTaper(phase + static_cast<float>(i) * phaseIncrement, taper));
+        }
+        return;
+    }
+
+    // phase is recomputed from i rather than accumulated, long grains would drift otherwise
+    for (int i = 0; i < numSamples; ++i)
+    {
+        destination[i] = lookup(table, phase + static_cast<float>(i) * phaseIncrement);
+    }
+}
+
+float grainWindows::getValue(Shape shape, float phase, float taper) const
+{
+    if (shape == Shape::tukey || shape == Shape::trapezoid)
+    {
+        return lookup(getTable(shape), remapForTaper(phase, juce::jlimit(0.001f, 1.0f, taper)));
+    }
+    return lookup(getTable(shape), phase);
+}
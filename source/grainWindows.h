@@ -0,0 +1,57 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+
+#ifndef GRAINWINDOWS_H
+#define GRAINWINDOWS_H
+
+// precomputed grain envelopes. the tables are built once and never written again,
+// hold one through juce::SharedResourcePointer<grainWindows> so every plugin
+// instance in the process shares the same copy
+class grainWindows {
+public:
+    // order matches the "grainShape" parameter
+    enum class Shape
+    {
+        hann,
+        tukey,
+        gaussian,
+        trapezoid,
+        exponential
+    };
+
+    static constexpr int tableSize = 2048;
+
+    grainWindows();
+
+    // writes the envelope for numSamples starting at phase (0..1 over the grain),
+    // taper is the fraction of the grain spent fading for tukey and trapezoid
+    void fillEnvelope(float* destination, int numSamples, float phase, float phaseIncrement,
+        Shape shape, float taper) const;
+
+    // single interpolated lookup, phase in 0..1
+    float getValue(Shape shape, float phase, float taper) const;
+
+private:
+    // one guard point past the end so the interpolation never wraps
+    using Table = std::array<float, tableSize + 1>;
+
+    Table hann;
+    Table gaussian;
+    Table triangle;
+    Table exponential;
+
+    const Table& getTable(Shape shape) const;
+    static float lookup(const Table& table, float phase);
+
+    // tukey and trapezoid are the hann and triangle tables stretched over the taper
+    static float remapForTaper(float phase, float taper);
+
+    JUCE_DECLARE_NON_COPYABLE(grainWindows)
+};
+
+#endif //GRAINWINDOWS_H
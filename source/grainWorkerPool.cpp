@@ -0,0 +1,157 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "grainWorkerPool.h"
+
+class grainWorkerPool::worker : public juce::Thread {
+public:
+    // the count is taken here, before the thread runs, so a run() straight after start() still wakes it
+    explicit worker(grainWorkerPool& pool)
+        : juce::Thread("grain worker"), pool(pool), seen(pool.wakeCount.load(std::memory_order_acquire))
+    {
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            // futex backed, waking costs the audio thread no lock
+            pool.wakeCount.wait(seen, std::memory_order_acquire);
+            seen = pool.wakeCount.load(std::memory_order_acquire);
+
+            if (!threadShouldExit())
+            {
+                pool.helpWithJobs();
+            }
+        }
+    }
+
+private:
+    grainWorkerPool& pool;
+    uint32_t seen;
+};
+
+grainWorkerPool::grainWorkerPool(){}
+
+grainWorkerPool::~grainWorkerPool()
+{
+    stop();
+}
+
+void grainWorkerPool::start(int numWorkers)
+{
+    stop();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back(std::make_unique<worker>(*this));
+        workers.back()->startThread(juce::Thread::Priority::highest);
+    }
+    started.store(true, std::memory_order_release);
+}
+
+void grainWorkerPool::stop()
+{
+    started.store(false, std::memory_order_release);
+
+    for (auto& thread : workers)
+    {
+        thread->signalThreadShouldExit();
+    }
+
+    wakeCount.fetch_add(1, std::memory_order_release);
+    wakeCount.notify_all();
+
+    for (auto& thread : workers)
+    {
+        thread->stopThread(1000);
+    }
+    workers.clear();
+}
+
+bool grainWorkerPool::run(JobFunction function, void* context, int numJobsToRun, double deadlineSeconds)
+{
+    jassert(numJobsToRun <= maxJobs);
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    auto deadlineTicks = startTicks + static_cast<juce::int64>(deadlineSeconds * static_cast<double>(juce::Time::getHighResolutionTicksPerSecond()));
+
+    // close the current generation before touching the job description, a worker
+    // still holding the old state can then no longer claim anything
+    auto generation = ((claimState.load(std::memory_order_relaxed) >> 32) + 1) & closedIndex;
+    claimState.store((generation << 32) | closedIndex, std::memory_order_release);
+
+    jobFunction.store(function, std::memory_order_relaxed);
+    jobContext.store(context, std::memory_order_relaxed);
+    numJobs.store(numJobsToRun, std::memory_order_relaxed);
+    doneState.store(generation << 32, std::memory_order_relaxed);
+
+    claimState.store(generation << 32, std::memory_order_release);
+
+    if (!workers.empty())
+    {
+        wakeCount.fetch_add(1, std::memory_order_release);
+        wakeCount.notify_all();
+    }
+
+    helpWithJobs();
+
+    // everything is claimed by now, only jobs a worker is still running are left. each
+    // is at most one partition of one block, so spin for them, but not past the deadline
+    auto allJobs = static_cast<uint32_t>((uint64_t { 1 } << numJobsToRun) - 1);
+    bool inTime = true;
+    while (true)
+    {
+        finishedJobs = static_cast<uint32_t>(doneState.load(std::memory_order_acquire)) & allJobs;
+        inTime = juce::Time::getHighResolutionTicks() <= deadlineTicks;
+        if (finishedJobs == allJobs || !inTime)
+        {
+            break;
+        }
+    }
+
+    // the late ones can no longer be finished as far as this generation goes
+    claimState.store((generation << 32) | closedIndex, std::memory_order_release);
+    return inTime;
+}
+
+void grainWorkerPool::helpWithJobs()
+{
+    auto state = claimState.load(std::memory_order_acquire);
+
+    while (true)
+    {
+        auto index = state & closedIndex;
+        if (index == closedIndex || index >= static_cast<uint64_t>(numJobs.load(std::memory_order_relaxed)))
+        {
+            return;
+        }
+
+        // counted before the claim, so isBusy() never misses a job that has been claimed
+        jobsRunning.fetch_add(1, std::memory_order_acq_rel);
+
+        // a successful claim means the generation (and with it the job description) is still current
+        if (claimState.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            auto function = jobFunction.load(std::memory_order_relaxed);
+            function(jobContext.load(std::memory_order_relaxed), static_cast<int>(index));
+            finishJob(state >> 32, index);
+            jobsRunning.fetch_sub(1, std::memory_order_release);
+            state = claimState.load(std::memory_order_acquire);
+        }
+        else
+        {
+            jobsRunning.fetch_sub(1, std::memory_order_release);
+        }
+    }
+}
+
+void grainWorkerPool::finishJob(uint64_t generation, uint64_t index)
+{
+    auto state = doneState.load(std::memory_order_relaxed);
+    while ((state >> 32) == generation
+           && !doneState.compare_exchange_weak(state, state | (uint64_t { 1 } << index),
+               std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
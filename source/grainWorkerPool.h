@@ -0,0 +1,79 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifndef GRAINWORKERPOOL_H
+#define GRAINWORKERPOOL_H
+
+// threads for rendering grain partitions in parallel. they are started in
+// start() (never on the audio thread) and sleep on an atomic between blocks.
+//
+// run() hands out jobs through one atomic claim counter. the calling thread
+// claims jobs too, so a job no worker has picked up yet is simply done by the
+// caller, and run() never waits on a worker that hasn't started. the caller
+// only waits for jobs a worker is already in the middle of, and only until the
+// deadline: a worker the os has preempted can't hold the audio thread up
+class grainWorkerPool {
+public:
+    using JobFunction = void (*)(void* context, int jobIndex);
+
+    // the finished jobs are kept as a bit mask
+    static constexpr int maxJobs = 32;
+
+    grainWorkerPool();
+    ~grainWorkerPool();
+
+    void start(int numWorkers);
+    void stop();
+    int getNumWorkers() const { return static_cast<int>(workers.size()); }
+
+    // true once start() has the threads running, safe to ask from any thread
+    bool isStarted() const { return started.load(std::memory_order_acquire); }
+
+    // runs jobs 0..numJobs-1 and returns once all have finished, or once deadlineSeconds
+    // have passed. returns false if the deadline came first. the jobs getFinishedJobs()
+    // leaves out are still running on a worker: their results are stale, the caller
+    // redoes them, and nothing they read or write may change hands until isBusy() is false
+    bool run(JobFunction function, void* context, int numJobs, double deadlineSeconds);
+    uint32_t getFinishedJobs() const { return finishedJobs; }
+
+    // a worker is still inside a job, possibly one an earlier run() gave up on
+    bool isBusy() const { return jobsRunning.load(std::memory_order_acquire) > 0; }
+
+private:
+    class worker;
+    std::vector<std::unique_ptr<worker>> workers;
+    std::atomic<bool> started { false };
+
+    // generation in the high 32 bits, next job index in the low 32.
+    // a closed generation has the index at closedIndex so nothing can be claimed
+    // while the job description is being swapped
+    std::atomic<uint64_t> claimState { 0 };
+    static constexpr uint64_t closedIndex = 0xffffffffull;
+
+    std::atomic<JobFunction> jobFunction { nullptr };
+    std::atomic<void*> jobContext { nullptr };
+    std::atomic<int> numJobs { 0 };
+
+    // generation in the high 32 bits, a bit per finished job in the low 32. a job
+    // from an older generation finishing late can't mark anything
+    std::atomic<uint64_t> doneState { 0 };
+    std::atomic<int> jobsRunning { 0 };
+    uint32_t finishedJobs { 0 };
+
+    // bumped once per run() to wake the workers
+    std::atomic<uint32_t> wakeCount { 0 };
+
+    // claims and runs jobs until none are left in the current generation
+    void helpWithJobs();
+    void finishJob(uint64_t generation, uint64_t index);
+};
+
+#endif //GRAINWORKERPOOL_H
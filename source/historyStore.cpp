@@ -0,0 +1,127 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "historyStore.h"
+
+historyStore::historyStore(){}
+
+void historyStore::prepare(int numChannels, int historySamples, int extraSamples)
+{
+    this->numChannels = numChannels;
+    maxHistorySamples = historySamples;
+
+    // room for the history, the reads on top of it and the chunk being filled
+    capacity = historySamples > 0 ? juce::nextPowerOfTwo(historySamples + extraSamples + 2 * chunkSize) : 0;
+    mask = juce::jmax(0, capacity - 1);
+    numChunks = capacity / chunkSize;
+
+    mantissas.assign(static_cast<size_t>(numChannels * capacity), 0);
+    exponents.assign(static_cast<size_t>(numChannels * numChunks), silentChunk);
+    pendingChunk.assign(static_cast<size_t>(numChannels * chunkSize), 0.0f);
+    writePosition = 0;
+}
+
+void historyStore::reset()
+{
+    std::fill(exponents.begin(), exponents.end(), silentChunk);
+    std::fill(pendingChunk.begin(), pendingChunk.end(), 0.0f);
+    writePosition = 0;
+}
+
+void historyStore::append(const delayLine& source, int numSamples)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    jassert((writePosition & source.getMask()) == source.getWritePosition());
+
+    for (int done = 0; done < numSamples;)
+    {
+        // up to the end of the chunk being filled
+        int offsetInChunk = (writePosition + done) & (chunkSize - 1);
+        int count = juce::jmin(numSamples - done, chunkSize - offsetInChunk);
+
+        for (int channel = 0; channel < juce::jmin(numChannels, source.getNumChannels()); ++channel)
+        {
+            auto* pending = pendingChunk.data() + channel * chunkSize;
+            source.readSpan(channel, source.getWritePosition() + done, count, pending + offsetInChunk);
+
+            if (offsetInChunk + count == chunkSize)
+            {
+                packChunk(channel, ((writePosition + done) & mask) / chunkSize);
+            }
+        }
+
+        done += count;
+    }
+
+    writePosition = (writePosition + numSamples) & mask;
+}
+
+void historyStore::packChunk(int channel, int chunk)
+{
+    auto* pending = pendingChunk.data() + channel * chunkSize;
+    auto& exponent = exponents[static_cast<size_t>(channel * numChunks + chunk)];
+
+    float peak = 0.0f;
+    for (int i = 0; i < chunkSize; ++i)
+    {
+        peak = juce::jmax(peak, std::abs(pending[i]));
+    }
+
+    if (peak == 0.0f)
+    {
+        exponent = silentChunk;
+        return;
+    }
+
+    // peak < 2^chunkExponent, so the mantissas use the full 16 bits without clipping
+    int chunkExponent = 0;
+    std::frexp(peak, &chunkExponent);
+    chunkExponent = juce::jlimit(-100, 100, chunkExponent);
+    exponent = static_cast<int8_t>(chunkExponent);
+
+    float scale = std::ldexp(1.0f, 15 - chunkExponent);
+    auto* packed = mantissas.data() + channel * capacity + chunk * chunkSize;
+
+    for (int i = 0; i < chunkSize; ++i)
+    {
+        float value = juce::jlimit(-32767.0f, 32767.0f, std::round(pending[i] * scale));
+        packed[i] = static_cast<int16_t>(value);
+    }
+}
+
+void historyStore::readSpan(int channel, int position, int numSamples, float* destination) const
+{
+    jassert(isEnabled());
+
+    // chunk by chunk, each with its own scale
+    for (int done = 0; done < numSamples;)
+    {
+        int index = (position + done) & mask;
+        int chunk = index / chunkSize;
+        int offsetInChunk = index & (chunkSize - 1);
+        int count = juce::jmin(numSamples - done, chunkSize - offsetInChunk);
+
+        auto exponent = exponents[static_cast<size_t>(channel * numChunks + chunk)];
+        if (exponent == silentChunk)
+        {
+            juce::FloatVectorOperations::clear(destination + done, count);
+        }
+        else
+        {
+            float scale = std::ldexp(1.0f, exponent - 15);
+            auto* packed = mantissas.data() + channel * capacity + index;
+
+            for (int i = 0; i < count; ++i)
+            {
+                destination[done + i] = static_cast<float>(packed[i]) * scale;
+            }
+        }
+
+        done += count;
+    }
+}
@@ -0,0 +1,67 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "delayLine.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+// long grain history behind the float delay line. everything the delay line
+// writes is copied here and packed into chunks of 16-bit mantissas with one
+// power-of-two exponent per chunk (block floating point), half the size of
+// float and still ~90 dB below each chunk's peak.
+//
+// positions run in lockstep with the delay line: the capacity is a larger
+// power of two, so (position & delay line mask) is the same sample in both.
+// the newest samples (the chunk being filled) only exist in the delay line,
+// grains read those from there and older ones through readSpan()
+class historyStore {
+public:
+    static constexpr int chunkSize = 4096;
+
+    historyStore();
+
+    // allocates the whole store. historySamples is the furthest back grains may reach,
+    // extraSamples covers what reads can add on top (block, spread, grain length)
+    void prepare(int numChannels, int historySamples, int extraSamples);
+
+    // forgets everything by marking each chunk silent, without touching the mantissas
+    void reset();
+
+    bool isEnabled() const { return capacity > 0; }
+
+    // picks up the numSamples source has just written at its write position and
+    // advances. call once per block, before source.advance()
+    void append(const delayLine& source, int numSamples);
+
+    // decodes numSamples starting at position (masked), which must be old enough to be packed
+    void readSpan(int channel, int position, int numSamples, float* destination) const;
+
+    int getCapacity() const { return capacity; }
+    int getMask() const { return mask; }
+    int getWritePosition() const { return writePosition; }
+    int getMaxHistorySamples() const { return maxHistorySamples; }
+
+private:
+    // exponent of a chunk that holds nothing but zeros
+    static constexpr int8_t silentChunk = -128;
+
+    int numChannels { 0 };
+    int capacity { 0 };
+    int mask { 0 };
+    int numChunks { 0 };
+    int writePosition { 0 };
+    int maxHistorySamples { 0 };
+
+    std::vector<int16_t> mantissas;     // numChannels * capacity
+    std::vector<int8_t> exponents;      // numChannels * numChunks
+    std::vector<float> pendingChunk;    // numChannels * chunkSize, the chunk being filled
+
+    void packChunk(int channel, int chunk);
+};
+
+#endif //HISTORYSTORE_H
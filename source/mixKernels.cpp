@@ -0,0 +1,161 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "mixKernels.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+
+namespace mixKernels
+{
+    shape shape::of(float gainBegin, float gainEnd, float wetDry, float feedback, int numChannels, bool hasLoop)
+    {
+        shape blockShape;
+        blockShape.rampedGain = gainBegin != gainEnd;
+        blockShape.mix = wetDry == 0.0f ? Mix::dry : (wetDry == 1.0f ? Mix::wet : Mix::blend);
+        blockShape.loop = !hasLoop ? Loop::none : (feedback == 0.0f ? Loop::dry : Loop::feedback);
+        blockShape.numChannels = numChannels == 1 || numChannels == 2 ? numChannels : 0;
+        return blockShape;
+    }
+
+    shape shape::generic(bool hasLoop)
+    {
+        shape blockShape;
+        blockShape.loop = hasLoop ? Loop::feedback : Loop::none;
+        return blockShape;
+    }
+
+    shape shape::smoothedRamps(bool hasLoop)
+    {
+        shape blockShape = generic(hasLoop);
+        blockShape.smoothed = true;
+        return blockShape;
+    }
+
+    // every variant does the same arithmetic in the same order as the generic one, the
+    // special cases only leave out what multiplies by 0 or adds 0. a flat ramp computes
+    // the same gain, so outputs match bit for bit as long as the signal is finite. the
+    // smoothed one only swaps the scalars for the ramps' values. a fully dry one never
+    // works out the wet signal, nothing of it is heard, so its meters stay at 0
+    template <typename SampleType, typename WetType, bool RampedGain, Mix MixType, Loop LoopType, int Channels,
+        bool Smoothed = false>
+    static void render(mixRun<SampleType, WetType>& run)
+    {
+        const int numChannels = Channels > 0 ? Channels : run.numChannels;
+        const int numSamples = run.numSamples;
+        const float gainBegin = run.gainBegin;
+        const float gainStep = run.gainStep;
+        const float wetDry = run.wetDry;
+        const float feedback = run.feedback;
+        float wetPeak = run.wetPeak;
+        float wetSquares = run.wetSquares;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            SampleType* output = run.output[channel] + run.outputOffset;
+            const WetType* wet = MixType != Mix::dry ? run.wet[channel] : nullptr;
+            const SampleType* loop = LoopType == Loop::feedback ? run.loop[channel] : nullptr;
+            SampleType* written = LoopType != Loop::none ? run.written[channel] : nullptr;
+            const float* wetDryRamp = Smoothed ? run.wetDryRamp + run.rampPosition : nullptr;
+            const float* feedbackRamp = Smoothed && LoopType == Loop::feedback ? run.feedbackRamp + run.rampPosition : nullptr;
+
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                float gain = RampedGain ? gainBegin + gainStep * static_cast<float>(run.rampPosition + sample) : gainBegin;
+                float sampleWetDry = Smoothed ? wetDryRamp[sample] : wetDry;
+                float sampleFeedback = Smoothed && LoopType == Loop::feedback ? feedbackRamp[sample] : feedback;
+                SampleType drySignal = output[sample];
+
+                if constexpr (MixType != Mix::dry)
+                {
+                    SampleType wetSignal = static_cast<SampleType>(wet[sample]) * gain;
+                    if constexpr (MixType == Mix::blend)
+                    {
+                        output[sample] = drySignal * (1.0f - sampleWetDry) + wetSignal * sampleWetDry;
+                    }
+                    else
+                    {
+                        output[sample] = wetSignal;
+                    }
+
+                    wetPeak = juce::jmax(wetPeak, static_cast<float>(std::abs(wetSignal)));
+                    wetSquares += static_cast<float>(wetSignal * wetSignal);
+                }
+
+                if constexpr (LoopType == Loop::feedback)
+                {
+                    written[sample] = drySignal + loop[sample] * gain * sampleFeedback;
+                }
+                else if constexpr (LoopType == Loop::dry)
+                {
+                    written[sample] = drySignal;
+                }
+            }
+        }
+
+        run.wetPeak = wetPeak;
+        run.wetSquares = wetSquares;
+    }
+
+    // picked one property at a time, down to the channel count
+    template <typename SampleType, typename WetType, bool RampedGain, Mix MixType, Loop LoopType>
+    static Kernel<SampleType, WetType> selectChannels(int numChannels)
+    {
+        switch (numChannels)
+        {
+            case 1:
+                return render<SampleType, WetType, RampedGain, MixType, LoopType, 1>;
+            case 2:
+                return render<SampleType, WetType, RampedGain, MixType, LoopType, 2>;
+            default:
+                return render<SampleType, WetType, RampedGain, MixType, LoopType, 0>;
+        }
+    }
+
+    template <typename SampleType, typename WetType, bool RampedGain, Mix MixType>
+    static Kernel<SampleType, WetType> selectLoop(const shape& blockShape)
+    {
+        switch (blockShape.loop)
+        {
+            case Loop::none:
+                return selectChannels<SampleType, WetType, RampedGain, MixType, Loop::none>(blockShape.numChannels);
+            case Loop::dry:
+                return selectChannels<SampleType, WetType, RampedGain, MixType, Loop::dry>(blockShape.numChannels);
+            case Loop::feedback:
+            default:
+                return selectChannels<SampleType, WetType, RampedGain, MixType, Loop::feedback>(blockShape.numChannels);
+        }
+    }
+
+    template <typename SampleType, typename WetType, bool RampedGain>
+    static Kernel<SampleType, WetType> selectMix(const shape& blockShape)
+    {
+        switch (blockShape.mix)
+        {
+            case Mix::dry:
+                return selectLoop<SampleType, WetType, RampedGain, Mix::dry>(blockShape);
+            case Mix::wet:
+                return selectLoop<SampleType, WetType, RampedGain, Mix::wet>(blockShape);
+            case Mix::blend:
+            default:
+                return selectLoop<SampleType, WetType, RampedGain, Mix::blend>(blockShape);
+        }
+    }
+
+    template <typename SampleType, typename WetType>
+    Kernel<SampleType, WetType> getKernel(const shape& blockShape)
+    {
+        // settles within a few blocks, not worth a variant per shape
+        if (blockShape.smoothed)
+        {
+            return blockShape.loop == Loop::none ? render<SampleType, WetType, true, Mix::blend, Loop::none, 0, true>
+                                                 : render<SampleType, WetType, true, Mix::blend, Loop::feedback, 0, true>;
+        }
+
+        return blockShape.rampedGain ? selectMix<SampleType, WetType, true>(blockShape)
+                                     : selectMix<SampleType, WetType, false>(blockShape);
+    }
+
+    template Kernel<float, float> getKernel<float, float>(const shape&);
+    template Kernel<double, double> getKernel<double, double>(const shape&);
+    template Kernel<double, float> getKernel<double, float>(const shape&);
+}
@@ -0,0 +1,91 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+
+#ifndef MIXKERNELS_H
+#define MIXKERNELS_H
+
+// the per sample end of every delay path, for one run of samples on each channel:
+//
+//     wet     = wet * gain
+//     output  = output * (1 - wetDry) + wet * wetDry
+//     written = output before the mix + loop * gain * feedback
+//
+// the gain ramps linearly over the host block. while wetDry and feedback glide to a new
+// value they come per sample from their ramps instead. the standard delay's loop is its
+// wet signal, the multi-tap delay's is the delayed signal under the taps, grains have
+// none. wet and loop are the caller's scratch and start at 0, output starts at outputOffset.
+// the meters take the wet signal, except on a fully dry block where none of it is heard
+template <typename SampleType, typename WetType>
+struct mixRun
+{
+    SampleType* const* output;
+    int outputOffset;
+    const WetType* const* wet;
+    const SampleType* const* loop;
+    SampleType* const* written;
+    int numChannels;
+    int numSamples;
+
+    float gainBegin;    // gain at the start of the host block
+    float gainStep;     // per sample
+    int rampPosition;   // where in the host block the run starts
+    float wetDry;
+    float feedback;
+
+    // per sample from the start of the block, only read by the smoothed kernel
+    const float* wetDryRamp { nullptr };
+    const float* feedbackRamp { nullptr };
+
+    // accumulated over the run's wet samples on every channel
+    float wetPeak { 0.0f };
+    float wetSquares { 0.0f };
+};
+
+namespace mixKernels
+{
+    enum class Mix
+    {
+        blend,
+        dry,    // wetDry 0, output is left alone
+        wet     // wetDry 1, output is the wet signal
+    };
+
+    enum class Loop
+    {
+        none,       // nothing is written
+        dry,        // feedback 0, written is the dry signal
+        feedback
+    };
+
+    // what is constant over a host block. a kernel is built for every combination, so
+    // the ones that skip work never test for it per sample
+    struct shape
+    {
+        bool rampedGain { true };
+        Mix mix { Mix::blend };
+        Loop loop { Loop::feedback };
+        int numChannels { 0 };  // 1 and 2 are unrolled, 0 is any count
+        bool smoothed { false };    // wetDry and feedback from their ramps
+
+        static shape of(float gainBegin, float gainEnd, float wetDry, float feedback, int numChannels, bool hasLoop = true);
+
+        // the kernel that makes no assumptions, what every block ran before
+        static shape generic(bool hasLoop = true);
+
+        // the generic kernel reading wetDry and feedback per sample, for the few blocks
+        // a change takes to settle
+        static shape smoothedRamps(bool hasLoop = true);
+    };
+
+    template <typename SampleType, typename WetType>
+    using Kernel = void (*)(mixRun<SampleType, WetType>&);
+
+    // for float blocks, double blocks, and double blocks with a float wet signal
+    template <typename SampleType, typename WetType>
+    Kernel<SampleType, WetType> getKernel(const shape& blockShape);
+}
+
+#endif //MIXKERNELS_H
@@ -0,0 +1,258 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "multiTapDelay.h"
+#include "fastRandom.h"
+
+static constexpr float goldenRatio = 1.6180339887f;
+
+// shortest tap, a thousandth of the delay size
+static constexpr float minTapTime = 0.001f;
+
+multiTapDelay::multiTapDelay() {}
+
+void multiTapDelay::prepare(double newSampleRate, int numChannels, int maxBlockSize, double glideSeconds)
+{
+    sampleRate = newSampleRate;
+
+    for (size_t k = 0; k < maxTaps; ++k)
+    {
+        timeSmoothed[k].reset(sampleRate, glideSeconds);
+        leftGainSmoothed[k].reset(sampleRate, glideSeconds);
+        rightGainSmoothed[k].reset(sampleRate, glideSeconds);
+        updateTargets(k);
+    }
+
+    tapDelays.setSize(maxTaps, maxBlockSize);
+    tapBlock.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    toneState.assign(static_cast<size_t>(maxTaps * numChannels), 0.0f);
+    reset();
+}
+
+void multiTapDelay::reset()
+{
+    for (size_t k = 0; k < maxTaps; ++k)
+    {
+        timeSmoothed[k].setCurrentAndTargetValue(timeSmoothed[k].getTargetValue());
+        leftGainSmoothed[k].setCurrentAndTargetValue(leftGainSmoothed[k].getTargetValue());
+        rightGainSmoothed[k].setCurrentAndTargetValue(rightGainSmoothed[k].getTargetValue());
+    }
+    std::fill(toneState.begin(), toneState.end(), 0.0f);
+}
+
+void multiTapDelay::setPattern(Pattern pattern, int newNumTaps, uint32_t seed)
+{
+    newNumTaps = juce::jlimit(1, maxTaps, newNumTaps);
+    if (pattern == lastPattern && newNumTaps == lastPatternTaps && (pattern != Pattern::random || seed == lastPatternSeed))
+    {
+        return;
+    }
+    lastPattern = pattern;
+    lastPatternTaps = newNumTaps;
+    lastPatternSeed = seed;
+
+    // gaps between taps first, the times are their running sum scaled so the last tap lands on the delay size
+    std::array<float, maxTaps> gaps {};
+    fastRandom random(seed);
+
+    for (int k = 0; k < newNumTaps; ++k)
+    {
+        auto& target = taps[static_cast<size_t>(k)];
+        auto position = static_cast<float>(k) / static_cast<float>(newNumTaps);
+        target.toneHz = 0.0f;
+
+        switch (pattern)
+        {
+            case Pattern::goldenRatio:
+                gaps[static_cast<size_t>(k)] = std::pow(goldenRatio, -static_cast<float>(k));
+                target.gain = std::pow(goldenRatio, -0.5f * static_cast<float>(k));
+                // golden angle steps, so neighbouring bounces never sit on the same side
+                target.pan = 0.7f * std::sin(2.39996f * static_cast<float>(k + 1));
+                target.toneHz = 12000.0f * std::pow(goldenRatio, -0.25f * static_cast<float>(k));
+                break;
+            case Pattern::dotted:
+                gaps[static_cast<size_t>(k)] = k % 2 == 0 ? 3.0f : 1.0f;
+                target.gain = (k % 2 == 0 ? 1.0f : 0.6f) * (1.0f - 0.5f * position);
+                target.pan = k % 2 == 0 ? -0.4f : 0.4f;
+                break;
+            case Pattern::random:
+                gaps[static_cast<size_t>(k)] = 0.2f + random.nextFloat();
+                target.gain = 0.3f + 0.7f * random.nextFloat();
+                target.pan = 2.0f * random.nextFloat() - 1.0f;
+                target.toneHz = random.nextFloat() < 0.5f ? 1000.0f + 7000.0f * random.nextFloat() : 0.0f;
+                break;
+            case Pattern::even:
+            default:
+                gaps[static_cast<size_t>(k)] = 1.0f;
+                target.gain = 1.0f - 0.6f * position;
+                target.pan = k % 2 == 0 ? -0.5f : 0.5f;
+                break;
+        }
+    }
+
+    // the taps sum on sustained input, keep their combined power at most that of one tap
+    float total = 0.0f;
+    float power = 0.0f;
+    for (int k = 0; k < newNumTaps; ++k)
+    {
+        total += gaps[static_cast<size_t>(k)];
+        power += juce::square(taps[static_cast<size_t>(k)].gain);
+    }
+    float gainScale = 1.0f / juce::jmax(1.0f, std::sqrt(power));
+
+    float time = 0.0f;
+    for (int k = 0; k < newNumTaps; ++k)
+    {
+        time += gaps[static_cast<size_t>(k)] / total;
+        taps[static_cast<size_t>(k)].time = k == newNumTaps - 1 ? 1.0f : juce::jmin(1.0f, time);
+        taps[static_cast<size_t>(k)].gain *= gainScale;
+    }
+
+    numTaps = newNumTaps;
+    for (size_t k = 0; k < maxTaps; ++k)
+    {
+        updateTargets(k);
+    }
+}
+
+void multiTapDelay::setTap(int index, const tap& newTap)
+{
+    jassert(index >= 0 && index < maxTaps);
+    taps[static_cast<size_t>(index)] = newTap;
+    lastPatternTaps = -1;
+    updateTargets(static_cast<size_t>(index));
+}
+
+void multiTapDelay::setNumTaps(int newNumTaps)
+{
+    numTaps = juce::jlimit(0, maxTaps, newNumTaps);
+    lastPatternTaps = -1;
+    for (size_t k = 0; k < maxTaps; ++k)
+    {
+        updateTargets(k);
+    }
+}
+
+bool multiTapDelay::isAudible(size_t k) const
+{
+    return leftGainSmoothed[k].getCurrentValue() != 0.0f || leftGainSmoothed[k].getTargetValue() != 0.0f
+        || rightGainSmoothed[k].getCurrentValue() != 0.0f || rightGainSmoothed[k].getTargetValue() != 0.0f;
+}
+
+void multiTapDelay::updateTargets(size_t k)
+{
+    const auto& target = taps[k];
+    bool active = static_cast<int>(k) < numTaps;
+
+    // a silent tap starts where it is meant to be instead of gliding in from its old time
+    auto time = juce::jlimit(minTapTime, 1.0f, target.time);
+    if (!isAudible(k))
+    {
+        timeSmoothed[k].setCurrentAndTargetValue(time);
+    }
+    else
+    {
+        timeSmoothed[k].setTargetValue(time);
+    }
+
+    // balance rather than constant power, a centred tap keeps its gain on both sides
+    auto pan = juce::jlimit(-1.0f, 1.0f, target.pan);
+    auto gain = active ? target.gain : 0.0f;
+    leftGainSmoothed[k].setTargetValue(gain * juce::jmin(1.0f, 1.0f - pan));
+    rightGainSmoothed[k].setTargetValue(gain * juce::jmin(1.0f, 1.0f + pan));
+
+    auto cutoff = juce::jmin(target.toneHz, 0.45f * static_cast<float>(sampleRate));
+    toneCoefficients[k] = cutoff > 0.0f
+        ? 1.0f - std::exp(-juce::MathConstants<float>::twoPi * cutoff / static_cast<float>(sampleRate))
+        : 1.0f;
+}
+
+float multiTapDelay::getShortestDelay(const float* delayTimes, int numSamples) const
+{
+    // both glides are linear, so the smallest fraction times the smallest delay size bounds every product
+    float shortestSize = juce::jmin(delayTimes[0], delayTimes[numSamples - 1]);
+    float shortest = shortestSize;
+    for (size_t k = 0; k < maxTaps; ++k)
+    {
+        if (isAudible(k))
+        {
+            auto fraction = juce::jmin(timeSmoothed[k].getCurrentValue(), timeSmoothed[k].getTargetValue());
+            shortest = juce::jmin(shortest, fraction * shortestSize);
+        }
+    }
+    return juce::jmax(2.0f, shortest);
+}
+
+void multiTapDelay::process(delayLine& line, int offset, const float* delayTimes, int numSamples,
+    delayLine::Interpolation interpolation, float* const* wet, int numChannels)
+{
+    // each tap's delays and gain ramps for the run, worked out once for every channel
+    std::array<size_t, maxTaps> active {};
+    std::array<float, maxTaps> leftStart {}, leftStep {}, rightStart {}, rightStep {};
+    size_t numActive = 0;
+    auto maxDelay = static_cast<float>(line.getMaxDelaySamples());
+
+    for (size_t k = 0; k < maxTaps; ++k)
+    {
+        if (!isAudible(k))
+        {
+            continue;
+        }
+
+        auto timeStart = timeSmoothed[k].getCurrentValue();
+        auto timeStep = (timeSmoothed[k].skip(numSamples) - timeStart) / static_cast<float>(numSamples);
+        auto* delays = tapDelays.getWritePointer(static_cast<int>(k));
+        for (int i = 0; i < numSamples; ++i)
+        {
+            delays[i] = juce::jlimit(2.0f, maxDelay, (timeStart + timeStep * static_cast<float>(i)) * delayTimes[i]);
+        }
+
+        leftStart[numActive] = leftGainSmoothed[k].getCurrentValue();
+        leftStep[numActive] = (leftGainSmoothed[k].skip(numSamples) - leftStart[numActive]) / static_cast<float>(numSamples);
+        rightStart[numActive] = rightGainSmoothed[k].getCurrentValue();
+        rightStep[numActive] = (rightGainSmoothed[k].skip(numSamples) - rightStart[numActive]) / static_cast<float>(numSamples);
+        active[numActive++] = k;
+    }
+
+    // channel by channel, so every tap reads from the same recently touched stretch of the ring
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* output = wet[channel];
+        for (size_t a = 0; a < numActive; ++a)
+        {
+            auto k = active[a];
+            line.readBlock(channel, offset, tapDelays.getReadPointer(static_cast<int>(k)), numSamples, interpolation, tapBlock.data());
+
+            if (toneCoefficients[k] < 1.0f)
+            {
+                auto& state = toneState[static_cast<size_t>(channel) * maxTaps + k];
+                const float coefficient = toneCoefficients[k];
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    state += coefficient * (tapBlock[static_cast<size_t>(i)] - state);
+                    tapBlock[static_cast<size_t>(i)] = state;
+                }
+            }
+
+            // a mono line hears both sides of the balance
+            float gainStart, gainStep;
+            if (numChannels == 1)
+            {
+                gainStart = 0.5f * (leftStart[a] + rightStart[a]);
+                gainStep = 0.5f * (leftStep[a] + rightStep[a]);
+            }
+            else
+            {
+                gainStart = channel == 0 ? leftStart[a] : rightStart[a];
+                gainStep = channel == 0 ? leftStep[a] : rightStep[a];
+            }
+
+            const float* source = tapBlock.data();
+            for (int i = 0; i < numSamples; ++i)
+            {
+                output[i] += source[i] * (gainStart + gainStep * static_cast<float>(i));
+            }
+        }
+    }
+}
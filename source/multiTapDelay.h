@@ -0,0 +1,93 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "delayLine.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <vector>
+
+#ifndef MULTITAPDELAY_H
+#define MULTITAPDELAY_H
+
+// up to maxTaps read heads on the standard delay's line. tap times are fractions
+// of the delay size, so a pattern stretches with it and repeats once per feedback
+// round. every tap reads one channel's block before the next channel is touched,
+// so the part of the ring the taps share is still in cache for the next tap.
+// everything is fixed size, changing the pattern or the tap times only moves
+// smoothing targets
+class multiTapDelay {
+public:
+    static constexpr int maxTaps = 16;
+
+    // order matches the "tapPattern" parameter
+    enum class Pattern
+    {
+        even,           // evenly spaced, fading out
+        goldenRatio,    // each gap 1/phi of the one before, like a bouncing ball
+        dotted,         // dotted eighth and sixteenth gaps in turn
+        random          // from the seed
+    };
+
+    struct tap
+    {
+        float time { 1.0f };    // fraction of the delay size, (0, 1]
+        float gain { 0.0f };
+        float pan { 0.0f };     // -1 left to 1 right, a balance control on stereo lines
+        float toneHz { 0.0f };  // one-pole lowpass cutoff, 0 leaves the tap unfiltered
+    };
+
+    multiTapDelay();
+
+    // glideSeconds is how long time, gain and pan changes take to settle
+    void prepare(double sampleRate, int numChannels, int maxBlockSize, double glideSeconds);
+
+    // filters cleared and every tap jumped to its target
+    void reset();
+
+    // fills the taps from a preset, seed is only used by the random pattern
+    void setPattern(Pattern pattern, int numTaps, uint32_t seed = 0);
+
+    // taps past the count fade out
+    void setTap(int index, const tap& newTap);
+    void setNumTaps(int newNumTaps);
+    const tap& getTap(int index) const { return taps[static_cast<size_t>(index)]; }
+    int getNumTaps() const { return numTaps; }
+
+    // lower bound on every tap's delay over the next numSamples, the first and last
+    // delayTimes of a block bound the glide in between
+    float getShortestDelay(const float* delayTimes, int numSamples) const;
+
+    // adds the taps for numSamples from offset on to wet[channel][0...], delayTimes
+    // are the delay size per sample. every tap must be longer than numSamples, see
+    // getShortestDelay()
+    void process(delayLine& line, int offset, const float* delayTimes, int numSamples,
+        delayLine::Interpolation interpolation, float* const* wet, int numChannels);
+
+private:
+    double sampleRate { 44100.0 };
+    std::array<tap, maxTaps> taps {};
+    int numTaps { 0 };
+
+    // smoothed per tap: time fraction and the left and right gains
+    std::array<juce::SmoothedValue<float>, maxTaps> timeSmoothed;
+    std::array<juce::SmoothedValue<float>, maxTaps> leftGainSmoothed;
+    std::array<juce::SmoothedValue<float>, maxTaps> rightGainSmoothed;
+    std::array<float, maxTaps> toneCoefficients {};
+    std::vector<float> toneState;   // maxTaps per channel
+
+    // each tap's per-sample delay for the current run, and one channel of tap output
+    juce::AudioBuffer<float> tapDelays;
+    std::vector<float> tapBlock;
+
+    // the preset the taps were last filled from, so a pattern set every block is only built once
+    Pattern lastPattern { Pattern::even };
+    int lastPatternTaps { -1 };
+    uint32_t lastPatternSeed { 0 };
+
+    bool isAudible(size_t k) const;
+    void updateTargets(size_t k);
+};
+
+#endif //MULTITAPDELAY_H
@@ -0,0 +1,80 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "parameterRamp.h"
+#include <algorithm>
+#include <cmath>
+
+void parameterRamp::reset(double sampleRate, double rampSeconds)
+{
+    rampLength = static_cast<int>(std::floor(rampSeconds * sampleRate));
+    setCurrentAndTargetValue(target);
+}
+
+void parameterRamp::setCurrentAndTargetValue(float newValue)
+{
+    target = newValue;
+    rampStart = newValue;
+    step = 0.0f;
+    stepsDone = 0;
+    countdown = 0;
+}
+
+void parameterRamp::setTargetValue(float newTarget)
+{
+    if (newTarget == target)
+    {
+        return;
+    }
+    if (rampLength <= 0)
+    {
+        setCurrentAndTargetValue(newTarget);
+        return;
+    }
+
+    // a new ramp starts from wherever the old one had got to
+    rampStart = getCurrentValue();
+    target = newTarget;
+    step = (target - rampStart) / static_cast<float>(rampLength);
+    stepsDone = 0;
+    countdown = rampLength;
+}
+
+float parameterRamp::getCurrentValue() const
+{
+    return countdown > 0 ? rampStart + step * static_cast<float>(stepsDone) : target;
+}
+
+void parameterRamp::fill(float* destination, int numSamples)
+{
+    int numRamped = std::min(numSamples, countdown);
+    if (numRamped > 0)
+    {
+        // counted from the start of the ramp, an integer is exact in a float this far
+        auto base = static_cast<float>(stepsDone + 1);
+        for (int sample = 0; sample < numRamped; ++sample)
+        {
+            destination[sample] = rampStart + step * (base + static_cast<float>(sample));
+        }
+
+        if (numRamped == countdown)
+        {
+            destination[numRamped - 1] = target;
+        }
+        skip(numRamped);
+    }
+    std::fill(destination + numRamped, destination + numSamples, target);
+}
+
+float parameterRamp::skip(int numSamples)
+{
+    if (numSamples >= countdown)
+    {
+        countdown = 0;
+        return target;
+    }
+    stepsDone += numSamples;
+    countdown -= numSamples;
+    return getCurrentValue();
+}
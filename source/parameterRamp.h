@@ -0,0 +1,41 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+
+#ifndef PARAMETERRAMP_H
+#define PARAMETERRAMP_H
+
+// a linear smoother like juce::SmoothedValue, but a block at a time: fill() writes a
+// block's values in one loop the compiler can vectorise, and a value that isn't moving
+// is a plain fill. every value is worked out from where the ramp started, so it is the
+// same however the ramp is split into blocks
+class parameterRamp {
+public:
+    // the ramp length for later target changes, a ramp in progress jumps to its target
+    void reset(double sampleRate, double rampSeconds);
+
+    void setCurrentAndTargetValue(float newValue);
+    void setTargetValue(float newTarget);
+
+    float getCurrentValue() const;
+    float getTargetValue() const { return target; }
+    bool isSmoothing() const { return countdown > 0; }
+
+    // the next numSamples values, the last one of a ramp is exactly the target
+    void fill(float* destination, int numSamples);
+
+    // moves on by numSamples without writing them, returns the value reached
+    float skip(int numSamples);
+
+private:
+    float target { 0.0f };
+    float rampStart { 0.0f };
+    float step { 0.0f };
+    int stepsDone { 0 };
+    int countdown { 0 };
+    int rampLength { 0 };
+};
+
+#endif //PARAMETERRAMP_H
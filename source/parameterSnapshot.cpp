@@ -0,0 +1,38 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "parameterSnapshot.h"
+#include <juce_core/juce_core.h>
+
+void parameterSnapshot::bind(int slot, const std::atomic<float>* source)
+{
+    jassert(slot >= 0 && slot < maxParameters);
+    jassert(source != nullptr);
+    sources[static_cast<size_t>(slot)] = source;
+    numSlots = juce::jmax(numSlots, slot + 1);
+    everythingChanged = true;
+}
+
+void parameterSnapshot::capture()
+{
+    changedSlots = 0;
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        auto* source = sources[static_cast<size_t>(slot)];
+        if (source == nullptr)
+        {
+            continue;
+        }
+
+        // one relaxed load each, the host may move them again while the block runs
+        float value = source->load(std::memory_order_relaxed);
+        auto& held = values[static_cast<size_t>(slot)];
+        if (value != held || everythingChanged)
+        {
+            changedSlots |= uint64_t { 1 } << slot;
+        }
+        held = value;
+    }
+    everythingChanged = false;
+}
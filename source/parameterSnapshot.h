@@ -0,0 +1,43 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#ifndef PARAMETERSNAPSHOT_H
+#define PARAMETERSNAPSHOT_H
+
+// the parameters the audio thread reads, loaded from the host's atomics once per block.
+// it keeps track of which ones moved since the last block, so the work that follows
+// from them (filter coefficients, tap patterns, grain timing) only runs when it has to
+class parameterSnapshot {
+public:
+    static constexpr int maxParameters = 64;
+
+    // slots are the caller's indices, below maxParameters
+    void bind(int slot, const std::atomic<float>* source);
+
+    // loads every bound parameter. the first capture, and the first after invalidate(),
+    // counts all of them as changed
+    void capture();
+    void invalidate() { everythingChanged = true; }
+
+    float get(int slot) const { return values[static_cast<size_t>(slot)]; }
+
+    bool changed(int slot) const { return (changedSlots >> slot) & 1u; }
+    template <typename... Slots>
+    bool changed(int slot, Slots... slots) const { return changed(slot) || changed(slots...); }
+    bool anyChanged() const { return changedSlots != 0; }
+
+private:
+    std::array<const std::atomic<float>*, maxParameters> sources {};
+    std::array<float, maxParameters> values {};
+    int numSlots { 0 };
+    uint64_t changedSlots { 0 };
+    bool everythingChanged { true };
+};
+
+#endif //PARAMETERSNAPSHOT_H
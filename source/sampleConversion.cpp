@@ -0,0 +1,160 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "sampleConversion.h"
+
+// same per-function target approach as the grain kernels
+#if defined(__x86_64__) || defined(_M_X64)
+    #define ECHOES_X86_CONVERSION 1
+    #include <immintrin.h>
+    #if defined(__GNUC__)
+        #define ECHOES_TARGET(isa) __attribute__((target(isa)))
+    #else
+        #define ECHOES_TARGET(isa)
+    #endif
+#else
+    #define ECHOES_X86_CONVERSION 0
+#endif
+
+namespace sampleConversion
+{
+    static void toHalfScalar(const float* source, uint16_t* destination, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            destination[i] = toHalf(source[i]);
+        }
+    }
+
+    static void fromHalfScalar(const uint16_t* source, float* destination, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            destination[i] = fromHalf(source[i]);
+        }
+    }
+
+#if ECHOES_X86_CONVERSION
+    // sse2 is part of the x86-64 baseline, so the int16 versions need no runtime check
+    void toInt16(const float* source, int16_t* destination, int numSamples)
+    {
+        const __m128 scale = _mm_set1_ps(int16Scale);
+        const __m128 upper = _mm_set1_ps(32767.0f);
+        const __m128 lower = _mm_set1_ps(-32767.0f);
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            __m128 low = _mm_min_ps(upper, _mm_max_ps(lower, _mm_mul_ps(_mm_loadu_ps(source + i), scale)));
+            __m128 high = _mm_min_ps(upper, _mm_max_ps(lower, _mm_mul_ps(_mm_loadu_ps(source + i + 4), scale)));
+            __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), packed);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            destination[i] = toInt16(source[i]);
+        }
+    }
+
+    void fromInt16(const int16_t* source, float* destination, int numSamples)
+    {
+        const __m128 scale = _mm_set1_ps(1.0f / int16Scale);
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            // sign extend by unpacking into the top half of each lane and shifting back down
+            __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+            __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+            _mm_storeu_ps(destination + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+            _mm_storeu_ps(destination + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            destination[i] = fromInt16(source[i]);
+        }
+    }
+
+    // f16c came in with ivy bridge and piledriver, every avx2 cpu has it
+    ECHOES_TARGET("avx2,f16c")
+    static void toHalfF16c(const float* source, uint16_t* destination, int numSamples)
+    {
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            __m128i packed = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), packed);
+        }
+        toHalfScalar(source + i, destination + i, numSamples - i);
+    }
+
+    ECHOES_TARGET("avx2,f16c")
+    static void fromHalfF16c(const uint16_t* source, float* destination, int numSamples)
+    {
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            _mm256_storeu_ps(destination + i, _mm256_cvtph_ps(packed));
+        }
+        fromHalfScalar(source + i, destination + i, numSamples - i);
+    }
+
+    static bool hasF16c()
+    {
+        static const bool available = juce::SystemStats::hasAVX2();
+        return available;
+    }
+
+    void toHalf(const float* source, uint16_t* destination, int numSamples)
+    {
+        if (hasF16c())
+        {
+            toHalfF16c(source, destination, numSamples);
+            return;
+        }
+        toHalfScalar(source, destination, numSamples);
+    }
+
+    void fromHalf(const uint16_t* source, float* destination, int numSamples)
+    {
+        if (hasF16c())
+        {
+            fromHalfF16c(source, destination, numSamples);
+            return;
+        }
+        fromHalfScalar(source, destination, numSamples);
+    }
+#else
+    // plain loops the compiler can vectorise for the target
+    void toInt16(const float* source, int16_t* destination, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            destination[i] = toInt16(source[i]);
+        }
+    }
+
+    void fromInt16(const int16_t* source, float* destination, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            destination[i] = fromInt16(source[i]);
+        }
+    }
+
+    void toHalf(const float* source, uint16_t* destination, int numSamples)
+    {
+        toHalfScalar(source, destination, numSamples);
+    }
+
+    void fromHalf(const uint16_t* source, float* destination, int numSamples)
+    {
+        fromHalfScalar(source, destination, numSamples);
+    }
+#endif
+}
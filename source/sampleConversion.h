@@ -0,0 +1,90 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <bit>
+#include <cstdint>
+
+#ifndef SAMPLECONVERSION_H
+#define SAMPLECONVERSION_H
+
+// 16-bit sample formats for the reduced precision delay line. the single sample
+// versions are inline for the per-sample read and write paths, the block versions
+// are vectorised and used wherever a whole span is converted at once
+namespace sampleConversion
+{
+    // int16 covers +-int16FullScale, the delay line runs above 0 dBFS with feedback.
+    // that puts the step at -78 dBFS
+    constexpr float int16FullScale = 8.0f;
+    constexpr float int16Scale = 32767.0f / int16FullScale;
+
+    inline int16_t toInt16(float sample)
+    {
+        return static_cast<int16_t>(std::lrint(juce::jlimit(-32767.0f, 32767.0f, sample * int16Scale)));
+    }
+
+    inline float fromInt16(int16_t sample)
+    {
+        return static_cast<float>(sample) * (1.0f / int16Scale);
+    }
+
+    // ieee half, round to nearest even. 11 significant bits (about -66 dB relative
+    // to the sample) over a range up to 65504
+    inline uint16_t toHalf(float sample)
+    {
+        auto bits = std::bit_cast<uint32_t>(sample);
+        auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+        bits &= 0x7fffffffu;
+
+        uint16_t half;
+        if (bits >= 0x47800000u)
+        {
+            // too big for half, or inf / nan
+            half = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;
+        }
+        else if (bits < 0x38800000u)
+        {
+            // below the smallest normal half. adding 0.5 lines the half denormal up
+            // with the bottom of the float mantissa and lets the fpu do the rounding
+            constexpr uint32_t half32 = 0x3f000000u;
+            float shifted = std::bit_cast<float>(bits) + std::bit_cast<float>(half32);
+            half = static_cast<uint16_t>(std::bit_cast<uint32_t>(shifted) - half32);
+        }
+        else
+        {
+            // rebias the exponent and round the 13 dropped mantissa bits
+            uint32_t odd = (bits >> 13) & 1u;
+            bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + odd;
+            half = static_cast<uint16_t>(bits >> 13);
+        }
+        return static_cast<uint16_t>(half | sign);
+    }
+
+    inline float fromHalf(uint16_t half)
+    {
+        uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+        uint32_t exponent = (half >> 10) & 0x1fu;
+        uint32_t mantissa = half & 0x3ffu;
+
+        if (exponent == 0)
+        {
+            // zero or denormal, mantissa * 2^-24
+            float magnitude = static_cast<float>(mantissa) * 5.9604645e-8f;
+            return sign != 0 ? -magnitude : magnitude;
+        }
+
+        uint32_t bits = exponent == 31 ? (0x7f800000u | (mantissa << 13))
+                                       : (((exponent + 127 - 15) << 23) | (mantissa << 13));
+        return std::bit_cast<float>(sign | bits);
+    }
+
+    // vectorised where the cpu allows, the same results as the single sample versions
+    void toInt16(const float* source, int16_t* destination, int numSamples);
+    void fromInt16(const int16_t* source, float* destination, int numSamples);
+    void toHalf(const float* source, uint16_t* destination, int numSamples);
+    void fromHalf(const uint16_t* source, float* destination, int numSamples);
+}
+
+#endif //SAMPLECONVERSION_H
@@ -0,0 +1,273 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "spectralProcessor.h"
+
+// hann analysis and synthesis windows at a quarter frame hop overlap to this
+static constexpr float overlapGain = 1.5f;
+
+// a bin below this is silence: a -100 dB sine through the hann window
+static constexpr float silentMagnitude = 1.0e-5f * static_cast<float>(spectralProcessor::frameSize) / 4.0f;
+
+static float wrapPhase(float phase)
+{
+    return phase - juce::MathConstants<float>::twoPi * std::round(phase / juce::MathConstants<float>::twoPi);
+}
+
+spectralProcessor::spectralProcessor() {}
+
+void spectralProcessor::prepare(double newSampleRate, int newNumChannels, int maxBlockSize, float maxDelaySeconds)
+{
+    juce::ignoreUnused(maxBlockSize);
+    sampleRate = newSampleRate;
+    numChannels = newNumChannels;
+
+    // periodic hann, so the overlapped windows sum flat
+    window.resize(frameSize);
+    for (int i = 0; i < frameSize; ++i)
+    {
+        window[static_cast<size_t>(i)] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * static_cast<float>(i) / static_cast<float>(frameSize));
+    }
+
+    // the rings are worked in samples, never blocks, so they only need to cover a frame
+    // and the hop it is worked on over
+    int ringSize = juce::nextPowerOfTwo(frameSize + 2 * hopSize);
+    ringMask = ringSize - 1;
+    inputRing.setSize(numChannels, ringSize);
+    outputRing.setSize(numChannels, ringSize);
+
+    fftBuffers.setSize(numChannels, 2 * frameSize);
+    lastPhase.setSize(numChannels, numBins);
+    phaseAdvance.setSize(numChannels, numBins);
+    synthesisPhase.setSize(numChannels, numBins);
+    smearState.setSize(numChannels, numBins);
+    frozenMagnitude.setSize(numChannels, numBins);
+    frozenAdvance.setSize(numChannels, numBins);
+
+    numFrames = static_cast<int>(std::ceil(maxDelaySeconds * sampleRate / hopSize)) + 2;
+    loopFrames.assign(static_cast<size_t>(numChannels) * static_cast<size_t>(numFrames) * numBins, 0.0f);
+
+    reset();
+}
+
+void spectralProcessor::reset()
+{
+    inputRing.clear();
+    outputRing.clear();
+    fftBuffers.clear();
+    lastPhase.clear();
+    for (int channel = 0; channel < phaseAdvance.getNumChannels(); ++channel)
+    {
+        auto* advance = phaseAdvance.getWritePointer(channel);
+        for (int k = 0; k < numBins; ++k)
+        {
+            advance[k] = wrapPhase(juce::MathConstants<float>::twoPi * static_cast<float>(k * hopSize) / static_cast<float>(frameSize));
+        }
+    }
+    synthesisPhase.clear();
+    smearState.clear();
+    frozenMagnitude.clear();
+    frozenAdvance.clear();
+    std::fill(loopFrames.begin(), loopFrames.end(), 0.0f);
+
+    position = 0;
+    frameIndex = 0;
+    frameEnd = 0;
+    framePending = false;
+    unitsDone = 0;
+    samplesIntoHop = 0;
+    frozen = false;
+    freezeStarting = false;
+    frameAudible = false;
+    framesSinceAudible = numFrames;
+    smear = smearRequested;
+}
+
+bool spectralProcessor::isRinging() const
+{
+    return frozen || freezeRequested
+           || framesSinceAudible <= delayFrames + getLatencySamples() / hopSize + 1;
+}
+
+template <typename SampleType>
+void spectralProcessor::process(juce::AudioBuffer<SampleType>& buffer, float delaySeconds, float feedback, float wetDry,
+    float gainBegin, float gainEnd)
+{
+    int numSamples = buffer.getNumSamples();
+    int numChannelsToProcess = juce::jmin(buffer.getNumChannels(), numChannels);
+    auto dryGain = static_cast<SampleType>(1.0f - wetDry);
+    float gainStep = (gainEnd - gainBegin) / static_cast<float>(numSamples);
+    float wetPeak = 0.0f;
+    float wetSquares = 0.0f;
+
+    for (int start = 0; start < numSamples;)
+    {
+        int count = juce::jmin(numSamples - start, hopSize - samplesIntoHop);
+
+        for (int channel = 0; channel < numChannelsToProcess; ++channel)
+        {
+            auto* data = buffer.getWritePointer(channel, start);
+            auto* input = inputRing.getWritePointer(channel);
+            auto* output = outputRing.getWritePointer(channel);
+            for (int i = 0; i < count; ++i)
+            {
+                int now = (position + i) & ringMask;
+                input[now] = static_cast<double>(data[i]);
+                float wet = output[now] * (gainBegin + gainStep * static_cast<float>(start + i));
+                output[now] = 0.0f;
+                data[i] = static_cast<SampleType>(input[(now - getLatencySamples()) & ringMask]) * dryGain
+                          + static_cast<SampleType>(wet * wetDry);
+                wetPeak = juce::jmax(wetPeak, std::abs(wet));
+                wetSquares += wet * wet;
+            }
+        }
+        position = (position + count) & ringMask;
+        samplesIntoHop += count;
+        start += count;
+
+        // the pending frame's units are done in step with how far into the hop we are,
+        // the last of them by the time the next frame is captured
+        if (framePending)
+        {
+            int due = (getNumUnits() * samplesIntoHop + hopSize - 1) / hopSize;
+            while (unitsDone < due)
+            {
+                runUnit(unitsDone++);
+            }
+        }
+
+        if (samplesIntoHop == hopSize)
+        {
+            startFrame(delaySeconds, feedback);
+        }
+    }
+    wetMeter.add(wetPeak, wetSquares, numSamples * numChannelsToProcess);
+}
+
+template void spectralProcessor::process<float>(juce::AudioBuffer<float>&, float, float, float, float, float);
+template void spectralProcessor::process<double>(juce::AudioBuffer<double>&, float, float, float, float, float);
+
+void spectralProcessor::startFrame(float delaySeconds, float feedback)
+{
+    if (framePending)
+    {
+        framesSinceAudible = frameAudible ? 0 : juce::jmin(framesSinceAudible + 1, numFrames);
+    }
+
+    frameEnd = position;
+    framePending = true;
+    unitsDone = 0;
+    samplesIntoHop = 0;
+    frameAudible = false;
+    frameIndex = (frameIndex + 1) % numFrames;
+
+    delayFrames = juce::jlimit(1, numFrames - 1, static_cast<int>(std::round(delaySeconds * sampleRate / hopSize)));
+    frameFeedback = juce::jlimit(0.0f, 1.0f, feedback);
+    smear = smearRequested;
+    freezeStarting = freezeRequested && !frozen;
+    frozen = freezeRequested;
+}
+
+void spectralProcessor::runUnit(int unit)
+{
+    int channel = unit % numChannels;
+    switch (unit / numChannels)
+    {
+        case 0:
+            analyse(channel);
+            break;
+        case 1:
+            transformSpectrum(channel);
+            break;
+        default:
+            synthesise(channel);
+            break;
+    }
+}
+
+void spectralProcessor::analyse(int channel)
+{
+    auto* data = fftBuffers.getWritePointer(channel);
+    const auto* input = inputRing.getReadPointer(channel);
+    int first = frameEnd - frameSize;
+    for (int i = 0; i < frameSize; ++i)
+    {
+        data[i] = static_cast<float>(input[(first + i) & ringMask]) * window[static_cast<size_t>(i)];
+    }
+    fft.performRealOnlyForwardTransform(data, true);
+}
+
+void spectralProcessor::transformSpectrum(int channel)
+{
+    auto* data = fftBuffers.getWritePointer(channel);
+    auto* previousPhase = lastPhase.getWritePointer(channel);
+    auto* advance = phaseAdvance.getWritePointer(channel);
+    auto* phase = synthesisPhase.getWritePointer(channel);
+    auto* smeared = smearState.getWritePointer(channel);
+    auto* heldMagnitude = frozenMagnitude.getWritePointer(channel);
+    auto* heldAdvance = frozenAdvance.getWritePointer(channel);
+    auto* written = getLoopFrame(channel, frameIndex);
+    const auto* echo = getLoopFrame(channel, (frameIndex - delayFrames + numFrames) % numFrames);
+
+    float loudest = 0.0f;
+    for (int k = 0; k < numBins; ++k)
+    {
+        float re = data[2 * k];
+        float im = data[2 * k + 1];
+        float magnitude = std::sqrt(re * re + im * im);
+        float inputPhase = std::atan2(im, re);
+
+        // how far the bin's phase moved over the hop, around what its centre frequency would.
+        // a silent bin has no phase to follow and keeps the last frequency it had
+        if (magnitude > silentMagnitude)
+        {
+            float expected = juce::MathConstants<float>::twoPi * static_cast<float>(k * hopSize) / static_cast<float>(frameSize);
+            advance[k] = expected + wrapPhase(inputPhase - previousPhase[k] - expected);
+        }
+        previousPhase[k] = inputPhase;
+
+        // the loop: this frame plus the echo, smeared over time
+        smeared[k] = smear * smeared[k] + (1.0f - smear) * (magnitude + frameFeedback * echo[k]);
+        written[k] = smeared[k];
+
+        if (freezeStarting)
+        {
+            heldMagnitude[k] = smeared[k];
+            heldAdvance[k] = advance[k];
+        }
+
+        float outMagnitude = frozen ? heldMagnitude[k] : echo[k];
+        phase[k] = wrapPhase(phase[k] + (frozen ? heldAdvance[k] : advance[k]));
+        data[2 * k] = outMagnitude * std::cos(phase[k]);
+        data[2 * k + 1] = outMagnitude * std::sin(phase[k]);
+
+        loudest = juce::jmax(loudest, smeared[k], outMagnitude);
+    }
+
+    // dc and nyquist stay real, and the negative frequencies mirror the positive ones
+    data[1] = 0.0f;
+    data[frameSize + 1] = 0.0f;
+    for (int k = numBins; k < frameSize; ++k)
+    {
+        data[2 * k] = data[2 * (frameSize - k)];
+        data[2 * k + 1] = -data[2 * (frameSize - k) + 1];
+    }
+
+    frameAudible = frameAudible || loudest > silentMagnitude;
+}
+
+void spectralProcessor::synthesise(int channel)
+{
+    auto* data = fftBuffers.getWritePointer(channel);
+    fft.performRealOnlyInverseTransform(data);
+
+    // the frame covered [frameEnd - frameSize, frameEnd) of the input, it comes out
+    // getLatencySamples() later
+    auto* output = outputRing.getWritePointer(channel);
+    int first = frameEnd + hopSize;
+    for (int i = 0; i < frameSize; ++i)
+    {
+        output[(first + i) & ringMask] += data[i] * window[static_cast<size_t>(i)] / overlapGain;
+    }
+}
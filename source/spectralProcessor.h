@@ -0,0 +1,114 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "engineTelemetry.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+#ifndef SPECTRALPROCESSOR_H
+#define SPECTRALPROCESSOR_H
+
+// the third delay mode: an overlap-add STFT where the delay line holds magnitude
+// frames instead of samples. every frame the input's magnitudes plus the fed back
+// ones are smeared over time and stored, the echo is the frame from the delay size
+// ago, and the phases run on from the input's so only the magnitudes repeat. freeze
+// holds the spectrum going into the loop and keeps resynthesising it.
+//
+// a frame's work (analysis, the spectral part, resynthesis, per channel) is spread
+// evenly over the hop after it was captured, so a block costs about the same whether
+// a hop boundary falls in it or not. that hop is added to the latency
+class spectralProcessor {
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int frameSize = 1 << fftOrder;
+    static constexpr int hopSize = frameSize / 4;
+    static constexpr int numBins = frameSize / 2 + 1;
+
+    spectralProcessor();
+
+    // the fft, windows, rings and magnitude frames for maxDelaySeconds are all allocated here
+    void prepare(double sampleRate, int numChannels, int maxBlockSize, float maxDelaySeconds);
+    void reset();
+
+    // takes hold at the next hop boundary
+    void setFreeze(bool shouldFreeze) { freezeRequested = shouldFreeze; }
+    bool isFrozen() const { return freezeRequested; }
+
+    // 0 leaves frames alone, towards 1 each frame's magnitudes linger over many hops
+    void setSmear(float amount) { smearRequested = juce::jlimit(0.0f, maxSmear, amount); }
+    float getSmear() const { return smearRequested; }
+    static constexpr float maxSmear = 0.98f;
+
+    // the wet signal is this late, the dry signal is delayed to match
+    static constexpr int getLatencySamples() { return frameSize + hopSize; }
+
+    // in place, the gain ramps over the wet signal. delay and feedback are picked up at
+    // each hop boundary. frames are float either way, the dry path keeps double exact
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, float delaySeconds, float feedback, float wetDry,
+        float gainBegin = 1.0f, float gainEnd = 1.0f);
+
+    // false once nothing above the silence threshold is left in the loop or on its way out
+    bool isRinging() const;
+
+    signalMeter& getWetMeter() { return wetMeter; }
+
+private:
+    juce::dsp::FFT fft { fftOrder };
+    std::vector<float> window;
+    double sampleRate { 44100.0 };
+    int numChannels { 0 };
+
+    // input and overlap-add output, indexed by the same masked sample position. the input
+    // is kept in double so the delayed dry signal comes out exactly as it went in
+    juce::AudioBuffer<double> inputRing;
+    juce::AudioBuffer<float> outputRing;
+    int ringMask { 0 };
+    int position { 0 };
+
+    // per channel: the fft working buffer (2 * frameSize), and per bin state
+    juce::AudioBuffer<float> fftBuffers;
+    juce::AudioBuffer<float> lastPhase;
+    juce::AudioBuffer<float> phaseAdvance;
+    juce::AudioBuffer<float> synthesisPhase;
+    juce::AudioBuffer<float> smearState;
+    juce::AudioBuffer<float> frozenMagnitude;
+    juce::AudioBuffer<float> frozenAdvance;
+
+    // the loop: numFrames magnitude frames per channel
+    std::vector<float> loopFrames;
+    int numFrames { 0 };
+    int frameIndex { 0 };
+
+    // the frame being worked on: where it ends in the rings, how much of it is done,
+    // and the parameters it was captured with
+    int frameEnd { 0 };
+    bool framePending { false };
+    int unitsDone { 0 };
+    int samplesIntoHop { 0 };
+    int delayFrames { 1 };
+    float frameFeedback { 0.0f };
+    float smear { 0.0f };
+    float smearRequested { 0.0f };
+    bool frozen { false };
+    bool freezeRequested { false };
+    bool freezeStarting { false };
+    bool frameAudible { false };
+    int framesSinceAudible { 0 };
+
+    signalMeter wetMeter;
+
+    int getNumUnits() const { return 3 * numChannels; }
+    float* getLoopFrame(int channel, int frame) { return loopFrames.data() + (static_cast<size_t>(channel) * static_cast<size_t>(numFrames) + static_cast<size_t>(frame)) * numBins; }
+
+    void startFrame(float delaySeconds, float feedback);
+    void runUnit(int unit);
+    void analyse(int channel);
+    void transformSpectrum(int channel);
+    void synthesise(int channel);
+};
+
+#endif //SPECTRALPROCESSOR_H
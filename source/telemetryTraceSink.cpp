@@ -0,0 +1,103 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#include "telemetryTraceSink.h"
+#include <cstring>
+
+static constexpr char traceMagic[4] = { 'E', 'C', 'H', 'T' };
+
+telemetryTraceSink::telemetryTraceSink(const engineTelemetry& source)
+    : juce::Thread("echoes telemetry trace"), telemetry(source)
+{
+}
+
+telemetryTraceSink::~telemetryTraceSink()
+{
+    stop();
+}
+
+bool telemetryTraceSink::start(const juce::File& file)
+{
+    stop();
+
+    file.deleteFile();
+    auto newStream = std::make_unique<juce::FileOutputStream>(file);
+    if (!newStream->openedOk())
+    {
+        return false;
+    }
+
+    newStream->write(traceMagic, sizeof(traceMagic));
+    newStream->writeInt(static_cast<int>(formatVersion));
+    newStream->writeInt(static_cast<int>(sizeof(telemetryFrame)));
+
+    stream = std::move(newStream);
+    position.next = telemetry.getNumPushed();
+    position.missed = 0;
+    missedFrames = 0;
+    batch.resize(static_cast<size_t>(engineTelemetry::capacity / 4));
+
+    startThread();
+    return true;
+}
+
+void telemetryTraceSink::stop()
+{
+    if (stream == nullptr)
+    {
+        return;
+    }
+
+    stopThread(1000);
+    drain();
+    stream->flush();
+    stream.reset();
+}
+
+void telemetryTraceSink::run()
+{
+    while (!threadShouldExit())
+    {
+        drain();
+        wait(pollIntervalMs);
+    }
+}
+
+void telemetryTraceSink::drain()
+{
+    for (;;)
+    {
+        int numRead = telemetry.read(position, batch.data(), static_cast<int>(batch.size()));
+        if (numRead == 0)
+        {
+            break;
+        }
+        stream->write(batch.data(), static_cast<size_t>(numRead) * sizeof(telemetryFrame));
+    }
+    missedFrames = position.missed;
+}
+
+bool telemetryTraceSink::readTrace(const juce::File& file, std::vector<telemetryFrame>& frames)
+{
+    juce::FileInputStream input(file);
+    if (!input.openedOk())
+    {
+        return false;
+    }
+
+    char magic[4] {};
+    input.read(magic, sizeof(magic));
+    auto version = static_cast<uint32_t>(input.readInt());
+    auto frameSize = static_cast<uint32_t>(input.readInt());
+    if (std::memcmp(magic, traceMagic, sizeof(magic)) != 0 || version != formatVersion
+        || frameSize != sizeof(telemetryFrame))
+    {
+        return false;
+    }
+
+    auto numFrames = static_cast<size_t>(input.getNumBytesRemaining()) / sizeof(telemetryFrame);
+    frames.resize(numFrames);
+    input.read(frames.data(), static_cast<int>(numFrames * sizeof(telemetryFrame)));
+    return true;
+}
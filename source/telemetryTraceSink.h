@@ -0,0 +1,51 @@
+//
+// Created by smoke on 10/17/2026.
+//
+
+#pragma once
+#include "engineTelemetry.h"
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+#ifndef TELEMETRYTRACESINK_H
+#define TELEMETRYTRACESINK_H
+
+// follows an engineTelemetry channel on a background thread and appends every
+// frame to a binary file: the 4 bytes "ECHT", a uint32 format version and a
+// uint32 frame size, then the frames as telemetryFrame in the machine's byte order
+class telemetryTraceSink : private juce::Thread {
+public:
+    static constexpr uint32_t formatVersion = 1;
+
+    explicit telemetryTraceSink(const engineTelemetry& source);
+    ~telemetryTraceSink() override;
+
+    // starts with the next frame pushed, false if the file can't be written
+    bool start(const juce::File& file);
+
+    // writes whatever is still in the channel and closes the file
+    void stop();
+
+    bool isTracing() const { return isThreadRunning(); }
+
+    // frames the channel overwrote before the sink could write them
+    uint64_t getMissedFrames() const { return missedFrames.load(); }
+
+    // reads a trace back, false if the file isn't one
+    static bool readTrace(const juce::File& file, std::vector<telemetryFrame>& frames);
+
+private:
+    const engineTelemetry& telemetry;
+    engineTelemetry::reader position;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    std::vector<telemetryFrame> batch;
+    std::atomic<uint64_t> missedFrames { 0 };
+
+    // a small part of what the channel holds, even at tiny block sizes
+    static constexpr int pollIntervalMs = 50;
+
+    void run() override;
+    void drain();
+};
+
+#endif //TELEMETRYTRACESINK_H
@@ -0,0 +1,74 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cpuGovernor.h>
+
+TEST_CASE ("cpu governor", "[governor]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 480;
+    cpuGovernor governor;
+    governor.prepare (sampleRate);
+
+    auto runSeconds = [&] (double seconds, double load) {
+        for (int i = 0; i < static_cast<int> (seconds * sampleRate) / blockSize; ++i)
+            governor.update (load, blockSize);
+    };
+
+    SECTION ("stays at full quality under budget")
+    {
+        runSeconds (5.0, 0.5);
+        CHECK (governor.getLevel() == 0);
+    }
+
+    SECTION ("steps up one level per settle time while over budget")
+    {
+        governor.update (0.9, blockSize);
+        CHECK (governor.getLevel() == 1);
+
+        runSeconds (cpuGovernor::settleSeconds * 0.5, 0.9);
+        CHECK (governor.getLevel() == 1);
+
+        runSeconds (10.0, 0.9);
+        CHECK (governor.getLevel() == cpuGovernor::numLevels - 1);
+    }
+
+    SECTION ("recovers only after a sustained stretch well under budget")
+    {
+        runSeconds (0.3, 0.9);
+        REQUIRE (governor.getLevel() == 2);
+
+        // just under budget is inside the hysteresis band and holds the level
+        runSeconds (10.0, 0.65);
+        CHECK (governor.getLevel() == 2);
+
+        // one spike restarts the recovery wait
+        runSeconds (cpuGovernor::recoverSeconds * 0.9, 0.2);
+        governor.update (0.5, blockSize);
+        runSeconds (cpuGovernor::recoverSeconds * 0.9, 0.2);
+        CHECK (governor.getLevel() == 2);
+
+        runSeconds (cpuGovernor::recoverSeconds * 0.2, 0.2);
+        CHECK (governor.getLevel() == 1);
+
+        runSeconds (cpuGovernor::recoverSeconds * 1.1, 0.2);
+        CHECK (governor.getLevel() == 0);
+    }
+
+    SECTION ("the budget is configurable")
+    {
+        governor.setBudget (0.95f);
+        runSeconds (1.0, 0.9);
+        CHECK (governor.getLevel() == 0);
+    }
+
+    SECTION ("higher levels never ask for more work")
+    {
+        for (int level = 1; level < cpuGovernor::numLevels; ++level)
+        {
+            auto previous = cpuGovernor::getSettings (level - 1);
+            auto current = cpuGovernor::getSettings (level);
+            CHECK (current.densityScale <= previous.densityScale);
+            CHECK (current.grainLimit < previous.grainLimit);
+        }
+        CHECK (cpuGovernor::getSettings (0).interpolation == delayLine::Interpolation::lagrange3);
+    }
+}
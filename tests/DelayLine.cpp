@@ -0,0 +1,156 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <delayLine.h>
+#include <vector>
+
+TEST_CASE ("delay line", "[delay]")
+{
+    delayLine line;
+    line.prepare (1, 1000, 64);
+
+    SECTION ("capacity is a power of two that fits the longest delay and a block")
+    {
+        CHECK (juce::isPowerOfTwo (line.getCapacity()));
+        CHECK (line.getCapacity() >= 1000 + 64);
+        CHECK (line.getMask() == line.getCapacity() - 1);
+    }
+
+    SECTION ("fractional reads are exact on a ramp")
+    {
+        // write a ramp across several wraps of the buffer, sample n holds n
+        const int numSamples = line.getCapacity() * 3 + 17;
+        for (int n = 0; n < numSamples; ++n)
+        {
+            line.write (0, 0, static_cast<float> (n));
+            line.advance (1);
+        }
+
+        const auto next = static_cast<float> (numSamples);
+        for (auto delay : { 2.0f, 2.5f, 3.75f, 100.125f, 999.0f })
+        {
+            CHECK (line.read (0, 0, delay, delayLine::Interpolation::linear) == Catch::Approx (next - delay));
+            CHECK (line.read (0, 0, delay, delayLine::Interpolation::lagrange3) == Catch::Approx (next - delay));
+        }
+    }
+}
+
+TEST_CASE ("float64 delay line storage keeps double samples", "[delay]")
+{
+    delayLine line;
+    line.prepare (1, 1000, 64, delayLine::Storage::float64);
+
+    // every sample needs more than float's 24 bits of mantissa
+    auto sampleAt = [] (int n) { return 0.1 + 1.0e-12 * static_cast<double> (n); };
+    for (int n = 0; n < 3000; ++n)
+    {
+        line.write (0, 0, sampleAt (n));
+        line.advance (1);
+    }
+
+    double block[64];
+    float delays[64];
+    std::fill (std::begin (delays), std::end (delays), 500.0f);
+    line.readBlock (0, 0, delays, 64, delayLine::Interpolation::linear, block);
+
+    for (int i = 0; i < 64; ++i)
+    {
+        CHECK (block[i] == sampleAt (3000 - 500 + i));
+        CHECK (line.read<double> (0, i, 500.0f, delayLine::Interpolation::linear) == block[i]);
+    }
+}
+
+TEST_CASE ("16-bit delay line storage noise floor", "[delay]")
+{
+    // a -6 dBFS sine through each format at a fractional delay, compared with float32.
+    // the error is reported in dB, relative to full scale
+    auto measureNoiseFloor = [] (delayLine::Storage storage, float level) {
+        delayLine reference;
+        delayLine reduced;
+        reference.prepare (1, 4096, 64);
+        reduced.prepare (1, 4096, 64, storage);
+
+        double errorPower = 0.0;
+        const int numBlocks = 200;
+        float block[64];
+        float delays[64];
+        float expected[64];
+        float actual[64];
+        std::fill (std::begin (delays), std::end (delays), 1000.37f);
+
+        for (int n = 0; n < numBlocks; ++n)
+        {
+            for (int i = 0; i < 64; ++i)
+                block[i] = level * std::sin (0.0371f * static_cast<float> (n * 64 + i));
+
+            reference.readBlock (0, 0, delays, 64, delayLine::Interpolation::lagrange3, expected);
+            reduced.readBlock (0, 0, delays, 64, delayLine::Interpolation::lagrange3, actual);
+
+            for (int i = 0; i < 64; ++i)
+            {
+                // the per sample path converts the same way, fast math may contract differently
+                CHECK (std::abs (reduced.read (0, i, delays[i], delayLine::Interpolation::lagrange3) - actual[i]) < 1.0e-6f);
+                if (n * 64 > 1100)
+                    errorPower += juce::square (static_cast<double> (actual[i] - expected[i]));
+            }
+
+            reference.writeBlock (0, 0, block, 64);
+            reduced.writeBlock (0, 0, block, 64);
+            reference.advance (64);
+            reduced.advance (64);
+        }
+
+        auto rms = std::sqrt (errorPower / (numBlocks * 64 - 1100));
+        return juce::Decibels::gainToDecibels (static_cast<float> (rms), -200.0f);
+    };
+
+    auto halfScale = juce::Decibels::decibelsToGain (-6.0f);
+
+    CHECK (measureNoiseFloor (delayLine::Storage::float32, halfScale) == -200.0f);
+
+    // the int16 step is fixed, so quiet signals get the same absolute floor
+    CHECK (measureNoiseFloor (delayLine::Storage::int16, halfScale) < -80.0f);
+    CHECK (measureNoiseFloor (delayLine::Storage::int16, halfScale * 0.01f) < -80.0f);
+
+    // half follows the signal down, roughly 80 dB below it
+    CHECK (measureNoiseFloor (delayLine::Storage::float16, halfScale) < -78.0f);
+    CHECK (measureNoiseFloor (delayLine::Storage::float16, halfScale * 0.01f) < -118.0f);
+}
+
+TEST_CASE ("block writes store what single writes do", "[delay]")
+{
+    auto storage = GENERATE (delayLine::Storage::float32, delayLine::Storage::int16,
+        delayLine::Storage::float16, delayLine::Storage::float64);
+
+    delayLine single, block;
+    single.prepare (2, 1000, 300, storage);
+    block.prepare (2, 1000, 300, storage);
+
+    // runs at an offset from the write position, long enough to wrap, from float and double
+    std::vector<float> floats (300);
+    std::vector<double> doubles (300);
+    for (int n = 0; n < 20; ++n)
+    {
+        for (int i = 0; i < 300; ++i)
+        {
+            floats[static_cast<size_t> (i)] = 0.9f * std::sin (0.013f * static_cast<float> (n * 300 + i));
+            doubles[static_cast<size_t> (i)] = 0.7 * std::cos (0.021 * (n * 300 + i));
+        }
+
+        for (int i = 0; i < 300; ++i)
+        {
+            single.write (0, i, floats[static_cast<size_t> (i)]);
+            single.write (1, i, doubles[static_cast<size_t> (i)]);
+        }
+        block.writeBlock (0, 0, floats.data(), 100);
+        block.writeBlock (0, 100, floats.data() + 100, 200);
+        block.writeBlock (1, 0, doubles.data(), 300);
+        single.advance (300);
+        block.advance (300);
+    }
+
+    for (int channel = 0; channel < 2; ++channel)
+        for (int delay = 2; delay < 1000; ++delay)
+            CHECK (block.read<double> (channel, 0, static_cast<float> (delay), delayLine::Interpolation::linear)
+                   == single.read<double> (channel, 0, static_cast<float> (delay), delayLine::Interpolation::linear));
+}
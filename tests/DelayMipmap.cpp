@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <delayMipmap.h>
+
+TEST_CASE ("delay mipmap", "[delay][grains]")
+{
+    constexpr int blockSize = 100;
+    delayLine line;
+    line.prepare (1, 8000, blockSize);
+    delayMipmap mipmap;
+    mipmap.prepare (1, line.getCapacity(), blockSize);
+
+    // writes frequency (as a fraction of the sample rate) for numSamples, in blocks
+    auto writeSine = [&] (float frequency, int numSamples) {
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            for (int i = 0; i < blockSize; ++i)
+                line.write (0, i, std::sin (juce::MathConstants<float>::twoPi * frequency * static_cast<float> (start + i)));
+            mipmap.append (line, blockSize);
+            line.advance (blockSize);
+        }
+    };
+
+    // the loudest sample of a level, between its oldest filled sample and the newest one
+    auto getLevelPeak = [&] (int level, int numSamples) {
+        auto* data = mipmap.getReadPointer (level, 0);
+        float peak = 0.0f;
+        for (int position = 1000; position < numSamples - mipmap.getLatency (level); position += 1 << level)
+            peak = juce::jmax (peak, std::abs (data[(position >> level) & mipmap.getMask (level)]));
+        return peak;
+    };
+
+    SECTION ("levels line up with the full rate samples they stand for")
+    {
+        constexpr float frequency = 0.005f;
+        writeSine (frequency, 6000);
+
+        for (int level = 1; level <= delayMipmap::numLevels; ++level)
+        {
+            auto* data = mipmap.getReadPointer (level, 0);
+            float maxError = 0.0f;
+            for (int position = 1000; position < 6000 - mipmap.getLatency (level); position += 1 << level)
+            {
+                auto expected = std::sin (juce::MathConstants<float>::twoPi * frequency * static_cast<float> (position));
+                maxError = juce::jmax (maxError, std::abs (data[(position >> level) & mipmap.getMask (level)] - expected));
+            }
+            CHECK (maxError < 1.0e-3f);
+        }
+    }
+
+    SECTION ("anything above a level's nyquist is filtered out")
+    {
+        // above a quarter of the rate only level 1 and 2 reject it, above an eighth only level 2
+        writeSine (0.35f, 6000);
+        CHECK (getLevelPeak (1, 6000) < 1.0e-3f);
+        CHECK (getLevelPeak (2, 6000) < 1.0e-3f);
+
+        mipmap.reset();
+        line.reset();
+        writeSine (0.17f, 6000);
+        CHECK (getLevelPeak (1, 6000) > 0.9f);
+        CHECK (getLevelPeak (2, 6000) < 1.0e-3f);
+    }
+
+    SECTION ("levels for each pitch range")
+    {
+        CHECK (delayMipmap::getLevelForIncrement (0.5f) == 0);
+        CHECK (delayMipmap::getLevelForIncrement (1.0f) == 0);
+        CHECK (delayMipmap::getLevelForIncrement (1.5f) == 1);
+        CHECK (delayMipmap::getLevelForIncrement (2.0f) == 1);
+        CHECK (delayMipmap::getLevelForIncrement (4.0f) == 2);
+    }
+}
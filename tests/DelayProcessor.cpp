@@ -0,0 +1,567 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <delayProcessor.h>
+
+static float getPeak (const juce::AudioBuffer<float>& buffer)
+{
+    float peak = 0.0f;
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        peak = juce::jmax (peak, buffer.getMagnitude (ch, 0, buffer.getNumSamples()));
+    return peak;
+}
+
+TEST_CASE ("silence bypass", "[delay]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    delayProcessor delay;
+    delay.prepare (sampleRate, 2, blockSize, 10.0f);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    const bool granularMode = GENERATE (false, true);
+
+    auto runBlock = [&] (float inputLevel) {
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (ch, i, i % 32 == 0 ? inputLevel : 0.0f);
+        delay.process (buffer, 0.1f, 0.5f, 0.5f, 1.0f, 1.0f, sampleRate, granularMode);
+    };
+
+    SECTION ("starts bypassed on silence")
+    {
+        runBlock (0.0f);
+        CHECK (delay.isBypassed());
+    }
+
+    SECTION ("keeps ringing after the input stops, then bypasses")
+    {
+        runBlock (1.0f);
+        CHECK_FALSE (delay.isBypassed());
+
+        // the echoes are still audible a little later
+        bool heardTail = false;
+        for (int block = 0; block < 40; ++block)
+        {
+            runBlock (0.0f);
+            heardTail = heardTail || getPeak (buffer) > delayProcessor::silenceThreshold;
+        }
+        CHECK (heardTail);
+
+        // 0.5 feedback at 0.1 s is well below -100 dB after a few seconds
+        for (int block = 0; block < 1000 && !delay.isBypassed(); ++block)
+            runBlock (0.0f);
+        CHECK (delay.isBypassed());
+        CHECK (getPeak (buffer) == 0.0f);
+
+        // and comes straight back with the input
+        runBlock (1.0f);
+        CHECK_FALSE (delay.isBypassed());
+        CHECK (getPeak (buffer) > 0.0f);
+    }
+}
+
+TEST_CASE ("tail length follows feedback and delay time", "[delay]")
+{
+    delayProcessor delay;
+    delay.prepare (48000.0, 2, 512, 10.0f);
+
+    auto noFeedback = delay.getTailLengthSeconds (1.0f, 0.0f, false, 100.0f);
+    auto halfFeedback = delay.getTailLengthSeconds (1.0f, 0.5f, false, 100.0f);
+
+    CHECK (noFeedback == 1.0);
+    // 0.5^17 is the first power below -100 dB
+    CHECK (halfFeedback == 18.0);
+    CHECK (delay.getTailLengthSeconds (0.5f, 0.5f, false, 100.0f) == 9.0);
+    // not std::isinf, release builds use fast math which assumes there are no infinities
+    CHECK (delay.getTailLengthSeconds (1.0f, 1.0f, false, 100.0f) > 1.0e9);
+    CHECK (delay.getTailLengthSeconds (1.0f, 0.0f, true, 100.0f) > 1.0);
+    // grain history only counts when a store was prepared for it
+    CHECK (delay.getTailLengthSeconds (1.0f, 0.0f, true, 100.0f, 30.0f) == delay.getTailLengthSeconds (1.0f, 0.0f, true, 100.0f));
+}
+
+TEST_CASE ("grains reach past the delay line into the history store", "[delay][grains]")
+{
+    constexpr double sampleRate = 8000.0;
+    constexpr int blockSize = 256;
+    juce::AudioBuffer<float> buffer (2, blockSize);
+
+    // a short burst, then silence for well over the 1 s the delay line holds.
+    // returns the loudest output from 3 s on
+    auto getLatePeak = [&] (float preparedHistorySeconds, float grainHistorySeconds) {
+        delayProcessor delay;
+        delay.prepare (sampleRate, 2, blockSize, 1.0f, preparedHistorySeconds);
+        juce::Random random (7);
+
+        float latePeak = 0.0f;
+        for (int block = 0; block < 6 * 8000 / blockSize; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (ch, i, block < 6 ? random.nextFloat() - 0.5f : 0.0f);
+
+            delay.process (buffer, 0.5f, 0.0f, 1.0f, 1.0f, 1.0f, sampleRate, true,
+                100.0f, 50.0f, 1.0f, 20.0f, grainHistorySeconds);
+
+            if (block * blockSize >= 3 * 8000)
+                latePeak = juce::jmax (latePeak, getPeak (buffer));
+        }
+        return latePeak;
+    };
+
+    CHECK (getLatePeak (0.0f, 0.0f) == 0.0f);
+    CHECK (getLatePeak (5.0f, 5.0f) > 0.01f);
+
+    // the store only exists for what was prepared, asking for more later is clamped
+    CHECK (getLatePeak (0.0f, 5.0f) == 0.0f);
+}
+
+TEST_CASE ("grain history within the delay line renders the same as without a store", "[delay][grains]")
+{
+    constexpr int blockSize = 256;
+    auto render = [] (float preparedHistorySeconds) {
+        delayProcessor delay;
+        delay.prepare (48000.0, 2, blockSize, 1.0f, preparedHistorySeconds);
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::Random random (3);
+        std::vector<float> output;
+
+        for (int block = 0; block < 200; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (ch, i, random.nextFloat() - 0.5f);
+
+            delay.process (buffer, 0.5f, 0.3f, 0.7f, 1.0f, 1.0f, 48000.0, true, 80.0f, 30.0f, 1.5f, 50.0f);
+            output.insert (output.end(), buffer.getReadPointer (0), buffer.getReadPointer (0) + blockSize);
+        }
+        return output;
+    };
+
+    CHECK (render (0.0f) == render (30.0f));
+}
+
+TEST_CASE ("16-bit delay storage renders close to float", "[delay]")
+{
+    constexpr int blockSize = 256;
+    const bool granularMode = GENERATE (false, true);
+
+    auto render = [granularMode] (delayLine::Storage storage) {
+        delayProcessor delay;
+        delay.setDelayStorage (storage);
+        delay.prepare (48000.0, 2, blockSize, 1.0f);
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        std::vector<float> output;
+
+        for (int block = 0; block < 300; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (ch, i, 0.5f * std::sin (0.01f * static_cast<float> (block * blockSize + i)));
+
+            // the delay time moves halfway through, so the glide and the short delay paths run too
+            auto delaySeconds = block < 150 ? 0.3f : 0.004f;
+            delay.process (buffer, delaySeconds, 0.6f, 0.5f, 1.0f, 1.0f, 48000.0, granularMode, 80.0f, 20.0f, 1.5f, 50.0f);
+            output.insert (output.end(), buffer.getReadPointer (1), buffer.getReadPointer (1) + blockSize);
+        }
+        return output;
+    };
+
+    auto reference = render (delayLine::Storage::float32);
+    for (auto storage : { delayLine::Storage::int16, delayLine::Storage::float16 })
+    {
+        auto reduced = render (storage);
+        float maxError = 0.0f;
+        for (size_t i = 0; i < reference.size(); ++i)
+            maxError = juce::jmax (maxError, std::abs (reduced[i] - reference[i]));
+
+        // the rounding, a little amplified by the feedback loop and the grain overlap
+        CHECK (maxError < 1.0e-3f);
+    }
+}
+
+TEST_CASE ("double blocks render like float ones", "[delay]")
+{
+    constexpr int blockSize = 256;
+    enum class Mode { standard, multiTap, granular, spectral };
+    const auto mode = GENERATE (Mode::standard, Mode::multiTap, Mode::granular, Mode::spectral);
+
+    auto render = [mode] (auto sample, float wetDry) {
+        using SampleType = decltype (sample);
+        delayProcessor delay;
+        delay.setDoublePrecision (std::is_same_v<SampleType, double>);
+        delay.setDelayStorage (std::is_same_v<SampleType, double> ? delayLine::Storage::float64 : delayLine::Storage::float32);
+        delay.setFeedbackShape (100.0f, 8000.0f, 0.5f);
+        delay.prepare (48000.0, 2, blockSize, 1.0f);
+        delay.setMultiTap (mode == Mode::multiTap, multiTapDelay::Pattern::even, 3, 1);
+        delay.setSpectral (mode == Mode::spectral, false, 0.3f);
+        juce::AudioBuffer<SampleType> buffer (2, blockSize);
+        std::vector<SampleType> input, output;
+
+        for (int block = 0; block < 200; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (ch, i, static_cast<SampleType> (0.5 * std::sin (0.01 * (block * blockSize + i))));
+
+            input.insert (input.end(), buffer.getReadPointer (1), buffer.getReadPointer (1) + blockSize);
+            delay.process (buffer, 0.1f, 0.6f, wetDry, 1.0f, 1.0f, 48000.0, mode == Mode::granular, 80.0f, 20.0f, 1.0f, 50.0f);
+            output.insert (output.end(), buffer.getReadPointer (1), buffer.getReadPointer (1) + blockSize);
+        }
+        return std::make_pair (input, output);
+    };
+
+    SECTION ("within float's rounding, a little amplified by the loop")
+    {
+        auto reference = render (0.0f, 0.5f).second;
+        auto wide = render (0.0, 0.5f).second;
+        double maxError = 0.0;
+        for (size_t i = 0; i < reference.size(); ++i)
+            maxError = juce::jmax (maxError, std::abs (wide[i] - static_cast<double> (reference[i])));
+        CHECK (maxError < 1.0e-4);
+    }
+
+    SECTION ("the dry signal comes through untouched")
+    {
+        auto [input, output] = render (0.0, 0.0f);
+        size_t latency = mode == Mode::spectral ? spectralProcessor::getLatencySamples() : 0;
+        for (size_t i = latency; i < output.size(); ++i)
+            REQUIRE (output[i] == input[i - latency]);
+    }
+}
+
+TEST_CASE ("pitched up grains don't alias", "[delay][grains]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+
+    // rms of the wet output at four times the pitch, once the grains play from a full history
+    auto getPitchedUpLevel = [] (double frequency) {
+        delayProcessor delay;
+        delay.prepare (sampleRate, 1, blockSize, 10.0f);
+        juce::AudioBuffer<float> buffer (1, blockSize);
+
+        double power = 0.0;
+        int numMeasured = 0;
+        for (int block = 0; block < 7 * 48000 / blockSize; ++block)
+        {
+            // the phase in double, float would smear a pure tone over the whole spectrum this far in
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (0, i, static_cast<float> (std::sin (juce::MathConstants<double>::twoPi * frequency * (block * blockSize + i))));
+
+            delay.process (buffer, 5.0f, 0.0f, 1.0f, 1.0f, 1.0f, sampleRate, true, 50.0f, 20.0f, 4.0f, 0.0f);
+
+            if (block * blockSize > 6 * 48000)
+            {
+                for (int i = 0; i < blockSize; ++i)
+                    power += juce::square (static_cast<double> (buffer.getSample (0, i)));
+                numMeasured += blockSize;
+            }
+        }
+        return juce::Decibels::gainToDecibels (static_cast<float> (std::sqrt (power / numMeasured)), -200.0f);
+    };
+
+    // 960 Hz comes out at 3840 Hz, 16.8 kHz would fold back down from 67.2 kHz
+    auto passed = getPitchedUpLevel (0.02);
+    auto folded = getPitchedUpLevel (0.35);
+    CHECK (passed > -20.0f);
+    CHECK (folded < passed - 60.0f);
+}
+
+TEST_CASE ("telemetry reports grains and path levels", "[delay][telemetry]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    delayProcessor delay;
+    delay.prepare (sampleRate, 2, blockSize, 10.0f);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    const bool granularMode = GENERATE (false, true);
+
+    telemetryFrame frame {};
+    for (int block = 0; block < 100; ++block)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (ch, i, 0.5f * std::sin (0.05f * static_cast<float> (block * blockSize + i)));
+        delay.process (buffer, 0.1f, 0.5f, 0.5f, 1.0f, 1.0f, sampleRate, granularMode, 100.0f, 50.0f);
+
+        frame = {};
+        delay.collectTelemetry (frame);
+    }
+
+    CHECK (frame.wetPeak > 0.1f);
+    CHECK (frame.wetRms > 0.0f);
+    CHECK (frame.wetRms <= frame.wetPeak);
+    CHECK (frame.feedbackPeak >= 0.5f * 0.99f);
+    CHECK ((frame.flags & telemetryFlags::nonFinite) == 0);
+
+    if (granularMode)
+    {
+        CHECK (frame.activeGrains > 0);
+        CHECK (frame.grainsSpawned >= frame.activeGrains);
+    }
+    else
+    {
+        CHECK (frame.grainsSpawned == 0);
+    }
+}
+
+TEST_CASE ("reverb rings on after the echoes", "[delay][reverb]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    delayProcessor delay;
+    delay.prepare (sampleRate, 2, blockSize, 10.0f);
+
+    const bool granularMode = GENERATE (false, true);
+    const auto position = GENERATE (fdnReverb::Position::postGrains, fdnReverb::Position::feedbackLoop);
+    delay.setReverb (position, 0.5f, 1.0f, 0.5f);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    buffer.clear();
+    buffer.setSample (0, 0, 1.0f);
+    buffer.setSample (1, 0, 1.0f);
+
+    // no feedback, so without the reverb nothing is left after the one echo at 0.1 s
+    delay.process (buffer, 0.1f, 0.0f, 0.5f, 1.0f, 1.0f, sampleRate, granularMode);
+
+    // in the loop only the echoes are diffused, the dry signal passes untouched
+    if (position == fdnReverb::Position::feedbackLoop && !granularMode)
+        CHECK (buffer.getSample (0, 0) == 0.5f);
+
+    float laterPeak = 0.0f;
+    for (int block = 1; block < 100; ++block)
+    {
+        buffer.clear();
+        delay.process (buffer, 0.1f, 0.0f, 0.5f, 1.0f, 1.0f, sampleRate, granularMode);
+        if (block * blockSize > sampleRate * 0.4)
+            laterPeak = juce::jmax (laterPeak, getPeak (buffer));
+    }
+    CHECK (laterPeak > 1.0e-4f);
+    CHECK_FALSE (delay.isBypassed());
+
+    // a 1 s decay is far below the threshold after 10 s
+    for (int block = 0; block < 2000 && !delay.isBypassed(); ++block)
+    {
+        buffer.clear();
+        delay.process (buffer, 0.1f, 0.0f, 0.5f, 1.0f, 1.0f, sampleRate, granularMode);
+    }
+    CHECK (delay.isBypassed());
+}
+
+TEST_CASE ("multi-tap output doesn't depend on the block size", "[delay][multitap]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int length = 4800;
+
+    // 10 ms delay size, so the first taps are much shorter than a block
+    auto render = [&] (int blockSize) {
+        delayProcessor delay;
+        delay.prepare (sampleRate, 2, blockSize, 10.0f);
+        delay.setMultiTap (true, multiTapDelay::Pattern::dotted, 16, 0);
+
+        juce::AudioBuffer<float> output (2, length);
+        output.clear();
+        output.setSample (0, 0, 1.0f);
+        output.setSample (1, 0, 1.0f);
+        for (int start = 0; start < length; start += blockSize)
+        {
+            juce::AudioBuffer<float> block (output.getArrayOfWritePointers(), 2, start, blockSize);
+            delay.process (block, 0.01f, 0.5f, 1.0f, 1.0f, 1.0f, sampleRate);
+        }
+        return output;
+    };
+
+    auto small = render (16);
+    auto large = render (960);
+
+    float difference = 0.0f;
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < length; ++i)
+            difference = juce::jmax (difference, std::abs (small.getSample (ch, i) - large.getSample (ch, i)));
+    CHECK (difference < 1.0e-6f);
+    CHECK (getPeak (large) > 0.1f);
+
+    // the loop repeats the pattern once per delay size
+    CHECK (std::abs (large.getSample (0, 960)) > 0.0f);
+}
+
+TEST_CASE ("sub-blocks render like whole host blocks", "[delay]")
+{
+    constexpr int hostBlockSize = 2048;
+    const bool multiTapMode = GENERATE (false, true);
+
+    // the gain ramps down over every host block, the sub-blocks have to pick it up where the
+    // last one left it. grains aren't in here, which ones get stolen depends on where blocks end
+    auto render = [multiTapMode] (int subBlockSize) {
+        delayProcessor delay;
+        delay.setSubBlockSize (subBlockSize);
+        delay.setFeedbackShape (100.0f, 8000.0f, 0.5f);
+        delay.prepare (48000.0, 2, hostBlockSize, 1.0f);
+        delay.setMultiTap (multiTapMode, multiTapDelay::Pattern::even, 3, 1);
+        juce::AudioBuffer<float> buffer (2, hostBlockSize);
+        std::vector<float> output;
+
+        for (int block = 0; block < 24; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < hostBlockSize; ++i)
+                    buffer.setSample (ch, i, static_cast<float> (0.5 * std::sin (0.01 * (block * hostBlockSize + i))));
+
+            delay.process (buffer, 0.1f, 0.6f, 0.5f, 1.0f, 0.5f, 48000.0);
+            output.insert (output.end(), buffer.getReadPointer (1), buffer.getReadPointer (1) + hostBlockSize);
+        }
+        return output;
+    };
+
+    auto whole = render (0);
+    auto subBlocks = render (GENERATE (32, 100));
+
+    float maxError = 0.0f;
+    for (size_t i = 0; i < whole.size(); ++i)
+        maxError = juce::jmax (maxError, std::abs (whole[i] - subBlocks[i]));
+    CHECK (maxError < 1.0e-4f);
+}
+
+TEST_CASE ("granular output gain covers the whole output", "[delay]")
+{
+    constexpr int blockSize = 256;
+    const float gainEnd = GENERATE (1.0f, 0.5f, 0.0f);
+
+    // fully dry, so what comes out is the input under the gain. flat at 0.5 or ramping down to 0
+    delayProcessor delay;
+    delay.prepare (48000.0, 1, blockSize, 1.0f);
+    juce::AudioBuffer<float> buffer (1, blockSize);
+    for (int block = 0; block < 20; ++block)
+    {
+        buffer.clear();
+        for (int i = 0; i < blockSize; ++i)
+            buffer.setSample (0, i, 0.5f);
+        auto gainBegin = gainEnd == 0.0f ? 1.0f : gainEnd;
+        delay.process (buffer, 0.1f, 0.0f, 0.0f, gainBegin, gainEnd, 48000.0, true);
+    }
+
+    for (int i : { 0, blockSize / 2, blockSize - 1 })
+    {
+        auto expected = gainEnd == 0.0f ? 0.5f * (1.0f - static_cast<float> (i) / blockSize) : 0.5f * gainEnd;
+        CHECK (std::abs (buffer.getSample (0, i) - expected) < 1.0e-6f);
+    }
+}
+
+TEST_CASE ("mix and feedback changes glide instead of stepping", "[delay]")
+{
+    constexpr int blockSize = 256;
+    const bool multiTapMode = GENERATE (false, true);
+
+    // a steady input and a delay longer than the test, so the output is the dry part of the mix.
+    // wetDry jumps from 0 to 1 between blocks, the output has to fade rather than drop
+    delayProcessor delay;
+    delay.prepare (48000.0, 1, blockSize, 2.0f);
+    delay.setMultiTap (multiTapMode, multiTapDelay::Pattern::even, 3, 1);
+    juce::AudioBuffer<float> buffer (1, blockSize);
+
+    float previous = 0.5f;
+    float largestStep = 0.0f;
+    int fadeLength = 0;
+    for (int block = 0; block < 40; ++block)
+    {
+        for (int i = 0; i < blockSize; ++i)
+            buffer.setSample (0, i, 0.5f);
+
+        auto wetDry = block < 4 ? 0.0f : 1.0f;
+        auto feedback = block < 4 ? 0.0f : 0.9f;
+        delay.process (buffer, 1.0f, feedback, wetDry, 1.0f, 1.0f, 48000.0);
+
+        for (int i = 0; i < blockSize; ++i)
+        {
+            largestStep = juce::jmax (largestStep, std::abs (buffer.getSample (0, i) - previous));
+            previous = buffer.getSample (0, i);
+            if (previous > 0.0f && previous < 0.5f)
+                ++fadeLength;
+        }
+    }
+
+    // 50 ms at 48 kHz, down from 0.5 in 2400 equal steps
+    CHECK (largestStep < 1.0e-3f);
+    CHECK (fadeLength == static_cast<int> (delayProcessor::mixGlideSeconds * 48000.0) - 1);
+    CHECK (previous == 0.0f);
+}
+
+TEST_CASE ("echoes land on time at every quality", "[delay][shaper]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    const auto quality = GENERATE (feedbackShaper::Quality::eco, feedbackShaper::Quality::normal, feedbackShaper::Quality::high);
+    const float drive = GENERATE (0.0f, 0.3f);
+
+    delayProcessor delay;
+    delay.setQuality (quality);
+    delay.setFeedbackShape (feedbackShaper::minLowCutHz, feedbackShaper::maxHighCutHz, drive);
+    delay.prepare (sampleRate, 2, blockSize, 10.0f);
+
+    // driven, the shaper's latency is taken off the read head
+    juce::AudioBuffer<float> output (2, 38 * blockSize);
+    output.clear();
+    output.setSample (0, 0, 1.0f);
+    output.setSample (1, 0, 1.0f);
+    for (int start = 0; start < output.getNumSamples(); start += blockSize)
+    {
+        juce::AudioBuffer<float> block (output.getArrayOfWritePointers(), 2, start, blockSize);
+        delay.process (block, 0.1f, 0.0f, 1.0f, 1.0f, 1.0f, sampleRate);
+    }
+
+    int loudest = 0;
+    for (int i = 1; i < output.getNumSamples(); ++i)
+        if (std::abs (output.getSample (0, i)) > std::abs (output.getSample (0, loudest)))
+            loudest = i;
+    CHECK (std::abs (loudest - 4800) <= 2);
+}
+
+TEST_CASE ("spectral mode is compensated, and bypasses once its loop is silent", "[delay][spectral]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    delayProcessor delay;
+    delay.prepare (sampleRate, 2, blockSize, 10.0f);
+    CHECK (delay.getLatencySamples() == 0);
+
+    delay.setSpectral (true, false, 0.0f);
+    REQUIRE (delay.getLatencySamples() == spectralProcessor::getLatencySamples());
+
+    // the dry impulse comes out exactly a latency late
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    int impulseAt = -1;
+    for (int block = 0; block < 20 && impulseAt < 0; ++block)
+    {
+        buffer.clear();
+        if (block == 0)
+        {
+            buffer.setSample (0, 0, 1.0f);
+            buffer.setSample (1, 0, 1.0f);
+        }
+        delay.process (buffer, 0.2f, 0.5f, 0.0f, 1.0f, 1.0f, sampleRate);
+        for (int i = 0; i < blockSize && impulseAt < 0; ++i)
+            if (buffer.getSample (0, i) == 1.0f)
+                impulseAt = block * blockSize + i;
+    }
+    CHECK (impulseAt == delay.getLatencySamples());
+
+    // frozen it rings on forever, let go the loop dies down and the path bypasses
+    delay.setSpectral (true, true, 0.5f);
+    CHECK (delay.getTailLengthSeconds (0.2f, 0.5f, false, 100.0f, 0.0f, true, true, 0.5f) > 1.0e9);
+    for (int block = 0; block < 100; ++block)
+    {
+        buffer.clear();
+        delay.process (buffer, 0.2f, 0.5f, 1.0f, 1.0f, 1.0f, sampleRate);
+    }
+    CHECK_FALSE (delay.isBypassed());
+
+    delay.setSpectral (true, false, 0.5f);
+    CHECK (delay.getTailLengthSeconds (0.2f, 0.5f, false, 100.0f, 0.0f, true, false, 0.5f) < 1.0e9);
+    for (int block = 0; block < 2000 && !delay.isBypassed(); ++block)
+    {
+        buffer.clear();
+        delay.process (buffer, 0.2f, 0.5f, 1.0f, 1.0f, 1.0f, sampleRate);
+    }
+    CHECK (delay.isBypassed());
+}
@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+#include <delayProcessor.h>
+#include <delayVisualFeed.h>
+
+TEST_CASE ("delay visual feed", "[visuals]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int spc = delayVisualFeed::samplesPerColumn;
+    delayVisualFeed feed;
+    feed.prepare (sampleRate, 1000);
+    std::vector<delayVisualFeed::column> columns (64);
+
+    SECTION ("columns hold the min and max of both channels across block boundaries")
+    {
+        // a ramp on the left, a negated one on the right, in odd sized blocks
+        std::vector<float> left (10 * spc), right (10 * spc);
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            left[i] = static_cast<float> (i) / static_cast<float> (left.size());
+            right[i] = -0.5f * left[i];
+        }
+
+        for (int start = 0; start < 10 * spc;)
+        {
+            int numSamples = juce::jmin (1000, 10 * spc - start) - (start == 0 ? 333 : 0);
+            feed.addChannel (left.data() + start, numSamples);
+            feed.addChannel (right.data() + start, numSamples);
+            feed.endBlock (numSamples);
+            start += numSamples;
+        }
+
+        REQUIRE (feed.popColumns (columns.data(), 64) == 10);
+        for (size_t c = 0; c < 10; ++c)
+        {
+            CHECK (columns[c].maximum == left[(c + 1) * spc - 1]);
+            CHECK (columns[c].minimum == juce::jmin (0.0f, right[(c + 1) * spc - 1]));
+        }
+        CHECK (feed.popColumns (columns.data(), 64) == 0);
+    }
+
+    SECTION ("grain snapshots come at the snapshot rate, the display gets the newest")
+    {
+        int numWanted = 0;
+        for (int i = 0; i < 480; ++i)
+            numWanted += feed.wantsGrainSnapshot (100) ? 1 : 0;
+        CHECK (numWanted == static_cast<int> (delayVisualFeed::snapshotRateHz));
+
+        delayVisualFeed::grainSnapshot snapshot {};
+        for (int i = 1; i <= 3; ++i)
+        {
+            snapshot.numGrains = i;
+            feed.pushGrains (snapshot);
+        }
+
+        delayVisualFeed::grainSnapshot received {};
+        REQUIRE (feed.popLatestGrains (received));
+        CHECK (received.numGrains == 3);
+        CHECK_FALSE (feed.popLatestGrains (received));
+    }
+}
+
+TEST_CASE ("delay processor feeds the display only while it's active", "[visuals][grains]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    delayProcessor delay;
+    delay.prepare (sampleRate, 2, blockSize, 10.0f);
+    auto& feed = delay.getVisualFeed();
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    auto runBlocks = [&] (int numBlocks) {
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (ch, i, 0.5f * std::sin (0.01f * static_cast<float> (block * blockSize + i)));
+            delay.process (buffer, 1.0f, 0.3f, 0.5f, 1.0f, 1.0f, sampleRate, true, 100.0f, 20.0f, 1.0f, 0.0f);
+        }
+    };
+
+    std::vector<delayVisualFeed::column> columns (2048);
+    delayVisualFeed::grainSnapshot snapshot {};
+
+    runBlocks (20);
+    CHECK (feed.popColumns (columns.data(), 2048) == 0);
+    CHECK_FALSE (feed.popLatestGrains (snapshot));
+
+    feed.setActive (true);
+    runBlocks (200);
+    CHECK (feed.popColumns (columns.data(), 2048) == 200 * blockSize / delayVisualFeed::samplesPerColumn);
+    REQUIRE (feed.popLatestGrains (snapshot));
+    REQUIRE (snapshot.numGrains > 0);
+
+    // grains sit inside the history they draw from and read towards the write head
+    auto maxAge = static_cast<float> (sampleRate * 1.1);
+    for (int i = 0; i < snapshot.numGrains; ++i)
+    {
+        CHECK (snapshot.grains[i].startAge <= maxAge);
+        CHECK (snapshot.grains[i].readAge <= snapshot.grains[i].startAge);
+        CHECK (snapshot.grains[i].readAge >= 0.0f);
+    }
+}
@@ -0,0 +1,169 @@
+#include <catch2/catch_test_macros.hpp>
+#include <engineTelemetry.h>
+#include <telemetryTraceSink.h>
+#include <cstring>
+#include <thread>
+
+static telemetryFrame makeFrame (uint64_t index)
+{
+    telemetryFrame frame {};
+    frame.blockIndex = index;
+    frame.numSamples = static_cast<uint32_t> (index % 512);
+    return frame;
+}
+
+static float fromBits (uint32_t bits)
+{
+    float value;
+    std::memcpy (&value, &bits, sizeof (value));
+    return value;
+}
+
+static double fromBits64 (uint64_t bits)
+{
+    double value;
+    std::memcpy (&value, &bits, sizeof (value));
+    return value;
+}
+
+TEST_CASE ("telemetry channel", "[telemetry]")
+{
+    engineTelemetry telemetry;
+    std::vector<telemetryFrame> frames (engineTelemetry::capacity);
+
+    SECTION ("readers see every frame in order, each with its own cursor")
+    {
+        engineTelemetry::reader first, second;
+        for (uint64_t i = 0; i < 100; ++i)
+            telemetry.push (makeFrame (i));
+
+        CHECK (telemetry.read (first, frames.data(), 60) == 60);
+        CHECK (frames[59].blockIndex == 59);
+        CHECK (telemetry.read (first, frames.data(), 60) == 40);
+        CHECK (frames[0].blockIndex == 60);
+
+        CHECK (telemetry.read (second, frames.data(), 1000) == 100);
+        CHECK (first.missed == 0);
+        CHECK (second.missed == 0);
+    }
+
+    SECTION ("a reader that falls behind skips what was overwritten and counts it")
+    {
+        engineTelemetry::reader reader;
+        for (uint64_t i = 0; i < engineTelemetry::capacity + 10; ++i)
+            telemetry.push (makeFrame (i));
+
+        CHECK (telemetry.read (reader, frames.data(), engineTelemetry::capacity) == engineTelemetry::capacity);
+        CHECK (reader.missed == 10);
+        CHECK (frames[0].blockIndex == 10);
+
+        telemetryFrame latest;
+        REQUIRE (telemetry.getLatest (latest));
+        CHECK (latest.blockIndex == engineTelemetry::capacity + 9);
+    }
+
+    SECTION ("frames stay whole while the writer runs on another thread")
+    {
+        constexpr uint64_t numFrames = 200000;
+        std::thread writer ([&] {
+            for (uint64_t i = 0; i < numFrames; ++i)
+            {
+                auto frame = makeFrame (i);
+                frame.grainsSpawned = static_cast<uint32_t> (i * 3);
+                telemetry.push (frame);
+            }
+        });
+
+        engineTelemetry::reader reader;
+        uint64_t numRead = 0, lastIndex = 0;
+        bool consistent = true, ordered = true;
+        while (reader.next < numFrames)
+        {
+            int count = telemetry.read (reader, frames.data(), 256);
+            for (int i = 0; i < count; ++i)
+            {
+                auto& frame = frames[static_cast<size_t> (i)];
+                consistent = consistent && frame.grainsSpawned == frame.blockIndex * 3
+                             && frame.numSamples == frame.blockIndex % 512;
+                ordered = ordered && (numRead == 0 || frame.blockIndex > lastIndex);
+                lastIndex = frame.blockIndex;
+                ++numRead;
+            }
+        }
+        writer.join();
+
+        CHECK (consistent);
+        CHECK (ordered);
+        CHECK (numRead + reader.missed == numFrames);
+    }
+}
+
+TEST_CASE ("telemetry scans", "[telemetry]")
+{
+    SECTION ("nan, inf and denormals are found without relying on std::isnan")
+    {
+        std::vector<float> samples (37, 0.25f);
+        CHECK (telemetryScan::classify (samples.data(), 37) == 0);
+
+        samples[20] = fromBits (0x7fc00000u);
+        CHECK (telemetryScan::classify (samples.data(), 37) == telemetryFlags::nonFinite);
+
+        samples[20] = fromBits (0xff800000u);
+        CHECK (telemetryScan::classify (samples.data(), 37) == telemetryFlags::nonFinite);
+
+        samples[20] = 0.0f;
+        samples[36] = fromBits (0x00000010u);
+        CHECK (telemetryScan::classify (samples.data(), 37) == telemetryFlags::denormal);
+    }
+
+    SECTION ("and in double blocks")
+    {
+        std::vector<double> samples (37, 0.25);
+        CHECK (telemetryScan::classify (samples.data(), 37) == 0);
+
+        samples[20] = fromBits64 (0x7ff8000000000000ull);
+        CHECK (telemetryScan::classify (samples.data(), 37) == telemetryFlags::nonFinite);
+
+        // a float denormal is a perfectly normal double
+        samples[20] = 1.0e-40;
+        CHECK (telemetryScan::classify (samples.data(), 37) == 0);
+
+        samples[36] = fromBits64 (0x0000000000000010ull);
+        CHECK (telemetryScan::classify (samples.data(), 37) == telemetryFlags::denormal);
+    }
+
+    SECTION ("meter peak and rms")
+    {
+        std::vector<float> samples (100, 0.5f);
+        samples[3] = -0.9f;
+        signalMeter meter;
+        meter.add (samples.data(), 50);
+        meter.add (samples.data() + 50, 50);
+        CHECK (meter.peak == 0.9f);
+        CHECK (std::abs (meter.getRms() - std::sqrt ((99.0f * 0.25f + 0.81f) / 100.0f)) < 1.0e-5f);
+        CHECK (meter.getFlags() == 0);
+    }
+}
+
+TEST_CASE ("telemetry trace file", "[telemetry]")
+{
+    engineTelemetry telemetry;
+    auto file = juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile ("echoes_trace_test.bin");
+
+    // frames from before the trace started aren't part of it
+    telemetry.push (makeFrame (1000));
+
+    telemetryTraceSink sink (telemetry);
+    REQUIRE (sink.start (file));
+    for (uint64_t i = 0; i < 3000; ++i)
+        telemetry.push (makeFrame (i));
+    sink.stop();
+
+    std::vector<telemetryFrame> frames;
+    REQUIRE (telemetryTraceSink::readTrace (file, frames));
+    REQUIRE (frames.size() + sink.getMissedFrames() == 3000);
+    CHECK (frames.front().blockIndex == 3000 - frames.size());
+    CHECK (frames.back().blockIndex == 2999);
+
+    file.deleteFile();
+}
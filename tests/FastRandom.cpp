@@ -0,0 +1,93 @@
+#include "helpers/test_helpers.h"
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+#include <fastRandom.h>
+
+TEST_CASE ("fast random", "[random]")
+{
+    SECTION ("same seed, same sequence")
+    {
+        fastRandom a (1234), b (1234), c (1235);
+        bool differs = false;
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto value = a.nextUInt32();
+            CHECK (value == b.nextUInt32());
+            differs = differs || value != c.nextUInt32();
+        }
+        CHECK (differs);
+    }
+
+    SECTION ("block fill matches single draws")
+    {
+        fastRandom single (7), block (7);
+        float values[257];
+        block.fillFloats (values, 257);
+        for (float value : values)
+            CHECK (value == single.nextFloat());
+    }
+
+    SECTION ("floats stay in [0, 1) and cover the range")
+    {
+        fastRandom random (99);
+        float lowest = 1.0f, highest = 0.0f;
+        for (int i = 0; i < 100000; ++i)
+        {
+            float value = random.nextFloat();
+            REQUIRE (value >= 0.0f);
+            REQUIRE (value < 1.0f);
+            lowest = juce::jmin (lowest, value);
+            highest = juce::jmax (highest, value);
+        }
+        CHECK (lowest < 0.001f);
+        CHECK (highest > 0.999f);
+    }
+}
+
+// renders a few seconds of granular output from a fresh instance
+static juce::AudioBuffer<float> renderGranular (int seed)
+{
+    PluginProcessor plugin;
+    setParameter (plugin, "granularMode", 1.0f);
+    setParameter (plugin, "grainDensity", 40.0f);
+    setParameter (plugin, "grainPitch", 1.5f);
+    setParameter (plugin, "seed", static_cast<float> (seed));
+    // offline, so the cpu governor can't thin the cloud when the machine is busy
+    plugin.setNonRealtime (true);
+    plugin.setRateAndBufferSizeDetails (48000.0, 256);
+    plugin.prepareToPlay (48000.0, 256);
+
+    juce::AudioBuffer<float> output (2, 256 * 400);
+    juce::AudioBuffer<float> block (2, 256);
+    juce::MidiBuffer midi;
+    juce::Random input (5);
+
+    for (int start = 0; start < output.getNumSamples(); start += 256)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < 256; ++i)
+                block.setSample (ch, i, input.nextFloat() * 2.0f - 1.0f);
+
+        plugin.processBlock (block, midi);
+
+        for (int ch = 0; ch < 2; ++ch)
+            output.copyFrom (ch, start, block, ch, 0, 256);
+    }
+
+    return output;
+}
+
+static bool identical (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+{
+    for (int ch = 0; ch < a.getNumChannels(); ++ch)
+        if (std::memcmp (a.getReadPointer (ch), b.getReadPointer (ch), sizeof (float) * static_cast<size_t> (a.getNumSamples())) != 0)
+            return false;
+    return true;
+}
+
+TEST_CASE ("granular output is repeatable for a seed", "[random][grains]")
+{
+    auto first = renderGranular (42);
+    CHECK (identical (first, renderGranular (42)));
+    CHECK_FALSE (identical (first, renderGranular (43)));
+}
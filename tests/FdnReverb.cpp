@@ -0,0 +1,107 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <fdnReverb.h>
+
+// rms of a stretch of a channel
+static float getRms (const juce::AudioBuffer<float>& buffer, int channel, int start, int numSamples)
+{
+    double sum = 0.0;
+    for (int i = start; i < start + numSamples; ++i)
+        sum += juce::square (static_cast<double> (buffer.getSample (channel, i)));
+    return static_cast<float> (std::sqrt (sum / numSamples));
+}
+
+// runs buffer through the reverb in blocks
+static void render (fdnReverb& reverb, juce::AudioBuffer<float>& buffer, int blockSize, float mix)
+{
+    for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+    {
+        int numSamples = juce::jmin (blockSize, buffer.getNumSamples() - start);
+        float* channels[2] = { buffer.getWritePointer (0, start), buffer.getWritePointer (1, start) };
+        reverb.process (channels, 2, numSamples, mix);
+    }
+}
+
+TEST_CASE ("fdn reverb", "[reverb]")
+{
+    constexpr double sampleRate = 48000.0;
+    const int blockSize = GENERATE (64, 4096);
+    fdnReverb reverb;
+    reverb.prepare (sampleRate, blockSize);
+
+    SECTION ("a dry mix leaves the signal alone")
+    {
+        juce::AudioBuffer<float> buffer (2, 10000);
+        juce::Random random (3);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, random.nextFloat() - 0.5f);
+        juce::AudioBuffer<float> original (buffer);
+
+        render (reverb, buffer, blockSize, 0.0f);
+        for (int i = 0; i < buffer.getNumSamples(); i += 97)
+            CHECK (buffer.getSample (1, i) == original.getSample (1, i));
+    }
+
+    SECTION ("an impulse decays by 60 dB over the decay time")
+    {
+        constexpr float decay = 1.0f;
+        reverb.setParameters (decay, 0.0f);
+
+        juce::AudioBuffer<float> buffer (2, static_cast<int> (sampleRate * 1.5));
+        buffer.clear();
+        buffer.setSample (0, 0, 1.0f);
+        render (reverb, buffer, blockSize, 1.0f);
+
+        // 100 ms windows from a quarter second in, past the build up
+        const int window = static_cast<int> (sampleRate * 0.1);
+        auto early = getRms (buffer, 0, static_cast<int> (sampleRate * 0.25), window);
+        auto late = getRms (buffer, 0, static_cast<int> (sampleRate * 1.25), window);
+        auto dropDb = juce::Decibels::gainToDecibels (late / early);
+        CHECK (dropDb < -50.0f);
+        CHECK (dropDb > -70.0f);
+
+        // both sides get a tail, and they aren't the same
+        CHECK (getRms (buffer, 1, static_cast<int> (sampleRate * 0.25), window) > 0.5f * early);
+        double correlation = 0.0;
+        for (int i = 0; i < static_cast<int> (sampleRate); ++i)
+            correlation += buffer.getSample (0, i) * buffer.getSample (1, i);
+        CHECK (std::abs (correlation) < 0.2 * std::pow (getRms (buffer, 0, 0, static_cast<int> (sampleRate)), 2) * sampleRate);
+    }
+
+    SECTION ("the wet level on noise stays close to the input whatever the decay")
+    {
+        auto decay = GENERATE (0.5f, 3.0f, 20.0f);
+        reverb.setParameters (decay, 0.3f);
+
+        juce::AudioBuffer<float> buffer (2, static_cast<int> (sampleRate * 4.0));
+        juce::Random random (5);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, random.nextFloat() - 0.5f);
+        auto inputRms = getRms (buffer, 0, 0, buffer.getNumSamples());
+
+        render (reverb, buffer, blockSize, 1.0f);
+        auto wetRms = getRms (buffer, 0, buffer.getNumSamples() / 2, buffer.getNumSamples() / 2);
+        CHECK (std::abs (juce::Decibels::gainToDecibels (wetRms / inputRms)) < 6.0f);
+    }
+
+    SECTION ("stops ringing once the tail is gone")
+    {
+        reverb.setParameters (0.5f, 0.5f);
+        CHECK_FALSE (reverb.isRinging());
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        buffer.clear();
+        buffer.setSample (0, 0, 1.0f);
+        render (reverb, buffer, blockSize, 1.0f);
+        CHECK (reverb.isRinging());
+
+        for (int block = 0; block < static_cast<int> (sampleRate * 2.0) / blockSize && reverb.isRinging(); ++block)
+        {
+            buffer.clear();
+            render (reverb, buffer, blockSize, 1.0f);
+        }
+        CHECK_FALSE (reverb.isRinging());
+    }
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <feedbackShaper.h>
+
+// peak of a sine after it has gone through the shaper, past the settling time
+static float getSinePeak (feedbackShaper& shaper, float frequency, float level, int blockSize)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int length = 24000;
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    float peak = 0.0f;
+
+    for (int start = 0; start < length; start += blockSize)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (ch, i, level * std::sin (juce::MathConstants<float>::twoPi * frequency * static_cast<float> ((start + i) / sampleRate)));
+
+        shaper.process (buffer.getArrayOfWritePointers(), 2, blockSize);
+        if (start > length / 2)
+            peak = juce::jmax (peak, buffer.getMagnitude (0, 0, blockSize));
+    }
+    return peak;
+}
+
+TEST_CASE ("feedback shaper", "[shaper]")
+{
+    const auto quality = GENERATE (feedbackShaper::Quality::eco, feedbackShaper::Quality::normal, feedbackShaper::Quality::high);
+    const int blockSize = GENERATE (37, 512);
+
+    feedbackShaper shaper;
+    shaper.prepare (48000.0, 2, 512);
+    shaper.setQuality (quality);
+
+    if (quality == feedbackShaper::Quality::eco)
+        CHECK (shaper.getLatencySamples() == 0);
+
+    SECTION ("flat and clean by default")
+    {
+        shaper.setParameters (feedbackShaper::minLowCutHz, feedbackShaper::maxHighCutHz, 0.0f);
+        shaper.reset();
+        auto peak = getSinePeak (shaper, 1000.0f, 0.5f, blockSize);
+        CHECK (std::abs (juce::Decibels::gainToDecibels (peak / 0.5f)) < 0.1f);
+    }
+
+    SECTION ("the high cut takes out the top")
+    {
+        shaper.setParameters (feedbackShaper::minLowCutHz, 1000.0f, 0.0f);
+        shaper.reset();
+        auto peak = getSinePeak (shaper, 8000.0f, 0.5f, blockSize);
+
+        // three octaves above the cutoff, 12 or 24 dB/oct
+        auto expected = quality == feedbackShaper::Quality::eco ? -30.0f : -60.0f;
+        CHECK (juce::Decibels::gainToDecibels (peak / 0.5f) < expected);
+    }
+
+    SECTION ("the low cut takes out the bottom")
+    {
+        shaper.setParameters (feedbackShaper::maxLowCutHz, feedbackShaper::maxHighCutHz, 0.0f);
+        shaper.reset();
+        auto peak = getSinePeak (shaper, 250.0f, 0.5f, blockSize);
+        CHECK (juce::Decibels::gainToDecibels (peak / 0.5f) < -30.0f);
+    }
+
+    SECTION ("the saturator squashes loud signals and never adds gain")
+    {
+        shaper.setParameters (feedbackShaper::minLowCutHz, feedbackShaper::maxHighCutHz, 1.0f);
+        shaper.reset();
+        auto loud = getSinePeak (shaper, 200.0f, 1.0f, blockSize);
+        auto quiet = getSinePeak (shaper, 200.0f, 0.01f, blockSize);
+
+        CHECK (loud < 0.6f);
+        CHECK (quiet <= 0.01f * 1.01f);
+    }
+
+    SECTION ("the oversampler is only in the loop while there is drive")
+    {
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        auto process = [&] (int numBlocks) {
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                buffer.clear();
+                shaper.process (buffer.getArrayOfWritePointers(), 2, blockSize);
+            }
+        };
+
+        // clean, an impulse comes straight through
+        shaper.setParameters (feedbackShaper::minLowCutHz, feedbackShaper::maxHighCutHz, 0.0f);
+        shaper.reset();
+        CHECK (shaper.getLatencySamples() == 0.0f);
+        buffer.clear();
+        buffer.setSample (0, 0, 1.0f);
+        shaper.process (buffer.getArrayOfWritePointers(), 2, blockSize);
+        CHECK (buffer.getSample (0, 0) > 0.99f);
+
+        // the latency switches with the pass, from the block the drive comes up in
+        shaper.setParameters (feedbackShaper::minLowCutHz, feedbackShaper::maxHighCutHz, 0.5f);
+        auto driven = shaper.getLatencySamples();
+        CHECK ((quality == feedbackShaper::Quality::eco ? driven == 0.0f : driven > 0.0f));
+        process (1);
+        CHECK (shaper.getLatencySamples() == driven);
+
+        // and goes once the drive has glided back down to 0
+        shaper.setParameters (feedbackShaper::minLowCutHz, feedbackShaper::maxHighCutHz, 0.0f);
+        process (1);
+        CHECK (shaper.getLatencySamples() == driven);
+        process (48000 / blockSize);
+        CHECK (shaper.getLatencySamples() == 0.0f);
+    }
+}
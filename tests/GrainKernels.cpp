@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <grainKernels.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+
+// renders the same span with the scalar reference and with isa, returns the largest difference
+static float compareWithScalar (grainKernels::Isa isa, float readOffset, float increment, int numSamples)
+{
+    juce::Random random (42);
+    std::vector<float> source (static_cast<size_t> (numSamples * 4 + 8));
+    std::vector<float> envelope (static_cast<size_t> (numSamples));
+    for (auto& s : source)
+        s = random.nextFloat() * 2.0f - 1.0f;
+    for (auto& e : envelope)
+        e = random.nextFloat();
+
+    std::vector<float> reference (static_cast<size_t> (numSamples), 0.25f);
+    std::vector<float> vectorised (reference);
+
+    grainSpan span { source.data(), envelope.data(), reference.data(), readOffset, increment, 0.8f, numSamples };
+    grainKernels::renderScalar (span);
+
+    span.output = vectorised.data();
+    grainKernels::getKernel (isa) (span);
+
+    float maxDifference = 0.0f;
+    for (size_t i = 0; i < reference.size(); ++i)
+        maxDifference = juce::jmax (maxDifference, std::abs (reference[i] - vectorised[i]));
+    return maxDifference;
+}
+
+TEST_CASE ("grain kernels match the scalar reference", "[grains][simd]")
+{
+    auto isa = GENERATE (grainKernels::Isa::sse2, grainKernels::Isa::avx2, grainKernels::Isa::avx512);
+    if (grainKernels::getKernel (isa) == nullptr)
+        SKIP (grainKernels::getIsaName (isa) << " not available on this machine");
+
+    // odd lengths exercise the scalar tails, the offsets cover unity and gathered reads
+    auto numSamples = GENERATE (1, 15, 64, 1001);
+
+    // fast math lets the compiler contract and reorder differently per kernel, so
+    // "identical" means within a few ulps of unit-scale audio. gathered reads may also
+    // round the read position differently, which moves the result by up to an ulp of
+    // the position times the slope of the (full scale noise) source
+    auto tolerance = [numSamples] (float increment) {
+        auto maxPosition = 4.0f + static_cast<float> (numSamples) * increment;
+        return 1.0e-6f + 4.0f * std::numeric_limits<float>::epsilon() * maxPosition;
+    };
+
+    SECTION ("unity pitch")
+    {
+        CHECK (compareWithScalar (isa, 0.0f, 1.0f, numSamples) <= 1.0e-6f);
+        CHECK (compareWithScalar (isa, 0.37f, 1.0f, numSamples) <= 1.0e-6f);
+    }
+
+    SECTION ("pitched")
+    {
+        CHECK (compareWithScalar (isa, 0.5f, 0.25f, numSamples) <= tolerance (0.25f));
+        CHECK (compareWithScalar (isa, 0.9f, 1.4983f, numSamples) <= tolerance (1.4983f));
+        CHECK (compareWithScalar (isa, 2.25f, 4.0f, numSamples) <= tolerance (4.0f));
+    }
+}
+
+TEST_CASE ("a grain at unity pitch is a scaled copy of its source", "[grains][simd]")
+{
+    std::vector<float> source (80);
+    std::vector<float> envelope (64);
+    for (size_t i = 0; i < source.size(); ++i)
+        source[i] = std::sin (0.3f * static_cast<float> (i));
+    for (size_t i = 0; i < envelope.size(); ++i)
+        envelope[i] = static_cast<float> (i) / 64.0f;
+
+    std::vector<float> output (64, 0.0f);
+    grainSpan span { source.data(), envelope.data(), output.data(), 0.0f, 1.0f, 0.5f, 64 };
+    grainKernels::getBestKernel() (span);
+
+    for (size_t i = 0; i < output.size(); ++i)
+        CHECK (std::abs (output[i] - source[i] * envelope[i] * 0.5f) <= 1.0e-7f);
+}
+
+TEST_CASE ("best grain kernel is available", "[grains][simd]")
+{
+    CHECK (grainKernels::getBestKernel() != nullptr);
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+#include <grainPool.h>
+
+TEST_CASE ("grain pool", "[grains]")
+{
+    grainPool pool;
+    pool.prepare (4);
+
+    SECTION ("spawn and retire keep the active list dense")
+    {
+        for (int i = 0; i < 4; ++i)
+            CHECK (pool.spawn (grainPool::StealPolicy::reject) >= 0);
+        CHECK (pool.getNumActive() == 4);
+
+        int retiredSlot = pool.getActiveSlot (1);
+        pool.retire (1);
+        CHECK (pool.getNumActive() == 3);
+
+        // the freed slot is handed out next
+        CHECK (pool.spawn (grainPool::StealPolicy::reject) == retiredSlot);
+    }
+
+    SECTION ("full pool applies the steal policy")
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            int slot = pool.spawn (grainPool::StealPolicy::reject);
+            pool.position[(size_t) slot] = 100 * (i + 1);
+            pool.amplitude[(size_t) slot] = 1.0f - 0.2f * (float) i;
+        }
+
+        CHECK (pool.spawn (grainPool::StealPolicy::reject) == -1);
+        CHECK (pool.spawn (grainPool::StealPolicy::oldest) == pool.getActiveSlot (3));
+        CHECK (pool.spawn (grainPool::StealPolicy::quietest) == pool.getActiveSlot (3));
+
+        pool.amplitude[(size_t) pool.getActiveSlot (0)] = 0.0f;
+        CHECK (pool.spawn (grainPool::StealPolicy::quietest) == pool.getActiveSlot (0));
+        CHECK (pool.getNumActive() == 4);
+    }
+
+    SECTION ("a lowered limit counts as full, active grains above it are kept")
+    {
+        for (int i = 0; i < 3; ++i)
+            pool.spawn (grainPool::StealPolicy::reject);
+
+        pool.setLimit (2);
+        CHECK (pool.getNumActive() == 3);
+        CHECK (pool.spawn (grainPool::StealPolicy::reject) == -1);
+        CHECK (pool.spawn (grainPool::StealPolicy::oldest) >= 0);
+        CHECK (pool.getNumActive() == 3);
+
+        pool.setLimit (4);
+        CHECK (pool.spawn (grainPool::StealPolicy::reject) >= 0);
+        CHECK (pool.getNumActive() == 4);
+    }
+
+    SECTION ("a stolen grain fades out in its slot while the new one takes another")
+    {
+        pool.setReleaseLength (32);
+        pool.setLimit (3);
+        int slots[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            slots[i] = pool.spawn (grainPool::StealPolicy::reject);
+            pool.position[(size_t) slots[i]] = 100 * (i + 1);
+        }
+
+        int fresh = pool.spawn (grainPool::StealPolicy::oldest);
+        CHECK (fresh != slots[2]);
+        CHECK (pool.releaseEnd[(size_t) slots[2]] == 332);
+        CHECK (pool.releaseEnd[(size_t) fresh] == grainPool::noRelease);
+        CHECK (pool.getNumActive() == 4);
+        CHECK (pool.getNumStolen() == 1);
+
+        // the fading grain isn't stolen again, and with no slot left the fade nearest its
+        // end is cut short for the next one
+        pool.position[(size_t) slots[2]] = 320;
+        CHECK (pool.spawn (grainPool::StealPolicy::oldest) == slots[2]);
+        CHECK (pool.releaseEnd[(size_t) slots[2]] == grainPool::noRelease);
+        CHECK (pool.releaseEnd[(size_t) slots[1]] == 232);
+        CHECK (pool.getNumActive() == 4);
+
+        // retired, a fading grain no longer counts
+        for (int i = 0; i < pool.getNumActive(); ++i)
+            if (pool.getActiveSlot (i) == slots[1])
+                pool.retire (i);
+        CHECK (pool.releaseEnd[(size_t) slots[1]] == grainPool::noRelease);
+        CHECK (pool.spawn (grainPool::StealPolicy::reject) == -1);
+    }
+
+    SECTION ("quietest goes by where each grain is in its window")
+    {
+        pool.setWindowLookup ([] (const void*, float phase) { return 1.0f - phase; }, nullptr);
+        for (int i = 0; i < 4; ++i)
+        {
+            int slot = pool.spawn (grainPool::StealPolicy::reject);
+            pool.length[(size_t) slot] = 1000;
+            pool.position[(size_t) slot] = 100;
+            pool.amplitude[(size_t) slot] = 0.5f;
+        }
+
+        // the loudest grain, nearly at the end of its window
+        int fading = pool.getActiveSlot (2);
+        pool.amplitude[(size_t) fading] = 1.0f;
+        pool.position[(size_t) fading] = 900;
+        CHECK (pool.spawn (grainPool::StealPolicy::quietest) == fading);
+    }
+}
@@ -0,0 +1,41 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <grainWindows.h>
+
+TEST_CASE ("grain windows", "[grains]")
+{
+    juce::SharedResourcePointer<grainWindows> windows;
+
+    SECTION ("every shape starts and ends silent and never exceeds unity")
+    {
+        for (int shapeIndex = 0; shapeIndex <= static_cast<int> (grainWindows::Shape::exponential); ++shapeIndex)
+        {
+            auto shape = static_cast<grainWindows::Shape> (shapeIndex);
+            CHECK (windows->getValue (shape, 0.0f, 0.5f) == Catch::Approx (0.0f).margin (1.0e-4));
+            CHECK (windows->getValue (shape, 1.0f, 0.5f) == Catch::Approx (0.0f).margin (1.0e-4));
+
+            for (float phase = 0.0f; phase <= 1.0f; phase += 0.01f)
+                CHECK (windows->getValue (shape, phase, 0.5f) <= 1.0f + 1.0e-6f);
+        }
+    }
+
+    SECTION ("tukey with full taper is hann, with a short taper it holds unity")
+    {
+        CHECK (windows->getValue (grainWindows::Shape::tukey, 0.3f, 1.0f)
+               == Catch::Approx (windows->getValue (grainWindows::Shape::hann, 0.3f, 0.0f)));
+        CHECK (windows->getValue (grainWindows::Shape::tukey, 0.3f, 0.2f) == Catch::Approx (1.0f));
+    }
+
+    SECTION ("instances share one set of tables")
+    {
+        juce::SharedResourcePointer<grainWindows> other;
+        CHECK (&*other == &*windows);
+    }
+
+    SECTION ("fillEnvelope matches single lookups")
+    {
+        float envelope[64];
+        windows->fillEnvelope (envelope, 64, 0.25f, 1.0f / 256.0f, grainWindows::Shape::gaussian, 0.5f);
+        CHECK (envelope[10] == Catch::Approx (windows->getValue (grainWindows::Shape::gaussian, 0.25f + 10.0f / 256.0f, 0.5f)));
+    }
+}
@@ -0,0 +1,129 @@
+#include "helpers/test_helpers.h"
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <grainWorkerPool.h>
+#include <thread>
+
+static void countJob (void* context, int jobIndex)
+{
+    static_cast<std::atomic<int>*> (context)[jobIndex].fetch_add (1);
+}
+
+TEST_CASE ("grain worker pool runs every job exactly once", "[grains][threads]")
+{
+    grainWorkerPool pool;
+    pool.start (GENERATE (0, 1, 3));
+
+    std::atomic<int> counts[8] {};
+    for (int run = 0; run < 1000; ++run)
+        pool.run (countJob, counts, 8, 1.0);
+
+    for (auto& count : counts)
+        CHECK (count.load() == 1000);
+}
+
+// a worker's job hangs until it's let go, like a worker the os has preempted. the
+// calling thread's jobs hold on until the worker has picked one up (for a second at most)
+struct stuckJobs
+{
+    std::thread::id caller { std::this_thread::get_id() };
+    std::atomic<bool> release { false };
+    std::atomic<int> stuck { -1 };
+};
+
+static void stuckJob (void* context, int jobIndex)
+{
+    auto& jobs = *static_cast<stuckJobs*> (context);
+    if (std::this_thread::get_id() == jobs.caller)
+    {
+        auto giveUp = juce::Time::getHighResolutionTicks() + juce::Time::getHighResolutionTicksPerSecond();
+        while (jobs.stuck < 0 && juce::Time::getHighResolutionTicks() < giveUp)
+            std::this_thread::yield();
+        return;
+    }
+
+    jobs.stuck = jobIndex;
+    while (!jobs.release)
+        std::this_thread::yield();
+}
+
+TEST_CASE ("grain worker pool gives up on a late worker at the deadline", "[grains][threads]")
+{
+    grainWorkerPool pool;
+    pool.start (1);
+    CHECK (pool.isStarted());
+
+    stuckJobs jobs;
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    CHECK_FALSE (pool.run (stuckJob, &jobs, 8, 0.05));
+    auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+    // back at the deadline, with every job but the stuck one done
+    CHECK (seconds < 0.5);
+    REQUIRE (jobs.stuck >= 0);
+    CHECK (pool.getFinishedJobs() == (0xffu & ~(1u << jobs.stuck)));
+    CHECK (pool.isBusy());
+
+    // finishing late marks nothing in the run that gave up on it
+    jobs.release = true;
+    while (pool.isBusy())
+        std::this_thread::yield();
+    CHECK (pool.getFinishedJobs() == (0xffu & ~(1u << jobs.stuck)));
+}
+
+// a dense cloud of long grains at 96k, so every block carries plenty over and the workers are woken
+static juce::AudioBuffer<float> renderCloud (bool parallel)
+{
+    PluginProcessor plugin;
+    setParameter (plugin, "granularMode", 1.0f);
+    setParameter (plugin, "grainDensity", 500.0f);
+    setParameter (plugin, "grainSize", 500.0f);
+    setParameter (plugin, "seed", 9.0f);
+    setParameter (plugin, "parallelGrains", parallel ? 1.0f : 0.0f);
+    // offline, so the cpu governor can't thin the cloud when the machine is busy
+    plugin.setNonRealtime (true);
+    plugin.setRateAndBufferSizeDetails (96000.0, 256);
+    plugin.prepareToPlay (96000.0, 256);
+
+    juce::AudioBuffer<float> output (2, 256 * 600);
+    juce::AudioBuffer<float> block (2, 256);
+    juce::MidiBuffer midi;
+    juce::Random input (3);
+
+    for (int start = 0; start < output.getNumSamples(); start += 256)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < 256; ++i)
+                block.setSample (ch, i, input.nextFloat() * 2.0f - 1.0f);
+
+        plugin.processBlock (block, midi);
+
+        for (int ch = 0; ch < 2; ++ch)
+            output.copyFrom (ch, start, block, ch, 0, 256);
+    }
+
+    return output;
+}
+
+TEST_CASE ("parallel grain rendering", "[grains][threads]")
+{
+    auto serial = renderCloud (false);
+    auto parallel = renderCloud (true);
+    auto again = renderCloud (true);
+
+    float maxDifference = 0.0f;
+    bool repeatable = true;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int i = 0; i < serial.getNumSamples(); ++i)
+        {
+            maxDifference = juce::jmax (maxDifference, std::abs (serial.getSample (ch, i) - parallel.getSample (ch, i)));
+            repeatable = repeatable && parallel.getSample (ch, i) == again.getSample (ch, i);
+        }
+    }
+
+    // partial sums round differently from one long sum, nothing more
+    CHECK (maxDifference < 1.0e-5f);
+    CHECK (repeatable);
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+#include <historyStore.h>
+
+TEST_CASE ("history store", "[delay][grains]")
+{
+    constexpr int blockSize = 500;
+    delayLine line;
+    line.prepare (1, 10000, blockSize);
+    historyStore store;
+    store.prepare (1, 100000, line.getCapacity());
+
+    // sample n of a tone whose level steps down by 20 dB every four chunks
+    auto getSample = [] (int n) {
+        auto level = std::pow (0.1f, static_cast<float> (n / (4 * historyStore::chunkSize)));
+        return level * std::sin (0.01f * static_cast<float> (n));
+    };
+
+    auto writeBlocks = [&] (int numSamples, bool silent) {
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            for (int i = 0; i < blockSize; ++i)
+                line.write (0, i, silent ? 0.0f : getSample (start + i));
+            store.append (line, blockSize);
+            line.advance (blockSize);
+        }
+    };
+
+    SECTION ("capacity is a power of two above the delay line's, positions stay in lockstep")
+    {
+        CHECK (store.isEnabled());
+        CHECK (juce::isPowerOfTwo (store.getCapacity()));
+        CHECK (store.getCapacity() > line.getCapacity());
+
+        writeBlocks (30 * blockSize, false);
+        CHECK ((store.getWritePosition() & line.getMask()) == line.getWritePosition());
+    }
+
+    SECTION ("decoded audio is within the 16 bit step of each chunk's peak")
+    {
+        const int numSamples = 16 * historyStore::chunkSize;
+        writeBlocks (numSamples, false);
+
+        std::vector<float> decoded (static_cast<size_t> (historyStore::chunkSize));
+        for (int chunk = 0; chunk < 12; ++chunk)
+        {
+            int start = chunk * historyStore::chunkSize;
+            store.readSpan (0, start, historyStore::chunkSize, decoded.data());
+
+            float peak = 0.0f;
+            float maxError = 0.0f;
+            for (int i = 0; i < historyStore::chunkSize; ++i)
+            {
+                peak = juce::jmax (peak, std::abs (getSample (start + i)));
+                maxError = juce::jmax (maxError, std::abs (decoded[static_cast<size_t> (i)] - getSample (start + i)));
+            }
+
+            // about -90 dB relative to the chunk, however quiet the chunk is
+            CHECK (maxError <= peak / 32768.0f);
+        }
+    }
+
+    SECTION ("reads across chunk boundaries and silent chunks")
+    {
+        writeBlocks (4 * historyStore::chunkSize, true);
+
+        std::vector<float> decoded (100, 1.0f);
+        store.readSpan (0, historyStore::chunkSize - 50, 100, decoded.data());
+        for (auto sample : decoded)
+            CHECK (sample == 0.0f);
+    }
+
+    SECTION ("reset forgets everything")
+    {
+        writeBlocks (8 * historyStore::chunkSize, false);
+        store.reset();
+        line.reset();
+        CHECK (store.getWritePosition() == 0);
+
+        std::vector<float> decoded (static_cast<size_t> (historyStore::chunkSize), 1.0f);
+        store.readSpan (0, 0, historyStore::chunkSize, decoded.data());
+        for (auto sample : decoded)
+            CHECK (sample == 0.0f);
+    }
+
+    SECTION ("no history asked for means no store")
+    {
+        historyStore disabled;
+        disabled.prepare (1, 0, line.getCapacity());
+        CHECK_FALSE (disabled.isEnabled());
+        CHECK (disabled.getCapacity() == 0);
+    }
+}
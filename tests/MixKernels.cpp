@@ -0,0 +1,139 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <mixKernels.h>
+#include <vector>
+
+// runs the same run through the generic kernel and the one picked for its shape,
+// returns the largest difference in output, written signal and meters
+template <typename SampleType, typename WetType>
+static double compareWithGeneric (float gainBegin, float gainEnd, float wetDry, float feedback, int numChannels, bool hasLoop)
+{
+    constexpr int numSamples = 67;
+    constexpr int offset = 5;
+    juce::Random random (3);
+    auto fill = [&random] (auto& buffer) {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+    };
+
+    juce::AudioBuffer<WetType> wet (numChannels, numSamples);
+    juce::AudioBuffer<SampleType> loop (numChannels, numSamples);
+    juce::AudioBuffer<SampleType> dry (numChannels, numSamples + offset);
+    fill (wet);
+    fill (loop);
+    fill (dry);
+
+    auto render = [&] (const mixKernels::shape& blockShape, juce::AudioBuffer<SampleType>& output, juce::AudioBuffer<SampleType>& written) {
+        output.makeCopyOf (dry);
+        written.setSize (numChannels, numSamples);
+        written.clear();
+        mixRun<SampleType, WetType> run { output.getArrayOfWritePointers(), offset, wet.getArrayOfReadPointers(),
+            loop.getArrayOfReadPointers(), written.getArrayOfWritePointers(), numChannels, numSamples,
+            gainBegin, (gainEnd - gainBegin) / 512.0f, 100, wetDry, feedback };
+        mixKernels::getKernel<SampleType, WetType> (blockShape) (run);
+        return std::make_pair (run.wetPeak, run.wetSquares);
+    };
+
+    juce::AudioBuffer<SampleType> expected, expectedWritten, actual, actualWritten;
+    auto expectedMeter = render (mixKernels::shape::generic (hasLoop), expected, expectedWritten);
+    // fully dry, the wet signal is never worked out and isn't metered
+    if (wetDry == 0.0f)
+        expectedMeter = {};
+    auto actualMeter = render (mixKernels::shape::of (gainBegin, gainEnd, wetDry, feedback, numChannels, hasLoop), actual, actualWritten);
+
+    double maxDifference = std::abs (static_cast<double> (expectedMeter.first - actualMeter.first))
+                           + std::abs (static_cast<double> (expectedMeter.second - actualMeter.second)) / (numSamples * numChannels);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int i = 0; i < numSamples + offset; ++i)
+            maxDifference = juce::jmax (maxDifference, std::abs (static_cast<double> (expected.getSample (ch, i) - actual.getSample (ch, i))));
+        for (int i = 0; i < numSamples; ++i)
+            maxDifference = juce::jmax (maxDifference, std::abs (static_cast<double> (expectedWritten.getSample (ch, i) - actualWritten.getSample (ch, i))));
+    }
+    return maxDifference;
+}
+
+TEST_CASE ("mix kernels match the generic one", "[mix]")
+{
+    const float gainEnd = GENERATE (1.0f, 0.25f);
+    const float wetDry = GENERATE (0.0f, 0.3f, 1.0f);
+    const float feedback = GENERATE (0.0f, 0.7f);
+    const int numChannels = GENERATE (1, 2, 3);
+    const bool hasLoop = GENERATE (false, true);
+
+    // the special cases leave out multiplications by 0 and 1, fast math may contract
+    // what's left differently, so within a few ulps
+    auto floatDifference = compareWithGeneric<float, float> (1.0f, gainEnd, wetDry, feedback, numChannels, hasLoop);
+    auto doubleDifference = compareWithGeneric<double, double> (1.0f, gainEnd, wetDry, feedback, numChannels, hasLoop);
+    auto mixedDifference = compareWithGeneric<double, float> (1.0f, gainEnd, wetDry, feedback, numChannels, hasLoop);
+    CHECK (floatDifference < 1.0e-6);
+    CHECK (doubleDifference < 1.0e-12);
+    CHECK (mixedDifference < 1.0e-12);
+}
+
+TEST_CASE ("mix kernel shapes", "[mix]")
+{
+    using namespace mixKernels;
+
+    auto blockShape = shape::of (0.5f, 0.5f, 1.0f, 0.0f, 2);
+    CHECK_FALSE (blockShape.rampedGain);
+    CHECK (blockShape.mix == Mix::wet);
+    CHECK (blockShape.loop == Loop::dry);
+    CHECK (blockShape.numChannels == 2);
+
+    blockShape = shape::of (0.5f, 1.0f, 0.2f, 0.4f, 6, false);
+    CHECK (blockShape.rampedGain);
+    CHECK (blockShape.mix == Mix::blend);
+    CHECK (blockShape.loop == Loop::none);
+    CHECK (blockShape.numChannels == 0);
+}
+
+TEST_CASE ("the smoothed mix kernel reads wetDry and feedback per sample", "[mix]")
+{
+    constexpr int numChannels = 2;
+    constexpr int numSamples = 48;
+    const bool hasLoop = GENERATE (false, true);
+
+    juce::Random random (5);
+    juce::AudioBuffer<float> wet (numChannels, numSamples), loop (numChannels, numSamples), dry (numChannels, numSamples);
+    for (auto* buffer : { &wet, &loop, &dry })
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                buffer->setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+    // the ramps start at the block's first sample, the run starts later in it
+    constexpr int rampPosition = 16;
+    std::vector<float> wetDryRamp (numSamples + rampPosition), feedbackRamp (numSamples + rampPosition);
+    for (size_t i = 0; i < wetDryRamp.size(); ++i)
+    {
+        wetDryRamp[i] = static_cast<float> (i) / static_cast<float> (wetDryRamp.size());
+        feedbackRamp[i] = 0.9f - 0.5f * wetDryRamp[i];
+    }
+
+    juce::AudioBuffer<float> output, written (numChannels, numSamples);
+    output.makeCopyOf (dry);
+    written.clear();
+    mixRun<float, float> run { output.getArrayOfWritePointers(), 0, wet.getArrayOfReadPointers(),
+        loop.getArrayOfReadPointers(), written.getArrayOfWritePointers(), numChannels, numSamples,
+        0.5f, 0.001f, rampPosition, 0.0f, 0.0f, wetDryRamp.data(), feedbackRamp.data() };
+    mixKernels::getKernel<float, float> (mixKernels::shape::smoothedRamps (hasLoop)) (run);
+
+    float maxError = 0.0f;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto position = static_cast<size_t> (rampPosition + i);
+            float gain = 0.5f + 0.001f * static_cast<float> (position);
+            float wetDry = wetDryRamp[position];
+            float expected = dry.getSample (ch, i) * (1.0f - wetDry) + wet.getSample (ch, i) * gain * wetDry;
+            maxError = juce::jmax (maxError, std::abs (output.getSample (ch, i) - expected));
+
+            float expectedWritten = hasLoop ? dry.getSample (ch, i) + loop.getSample (ch, i) * gain * feedbackRamp[position] : 0.0f;
+            maxError = juce::jmax (maxError, std::abs (written.getSample (ch, i) - expectedWritten));
+        }
+    }
+    CHECK (maxError < 1.0e-6f);
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <multiTapDelay.h>
+
+TEST_CASE ("tap patterns", "[multitap]")
+{
+    multiTapDelay taps;
+    taps.prepare (48000.0, 2, 256, 0.25);
+
+    const auto pattern = GENERATE (multiTapDelay::Pattern::even, multiTapDelay::Pattern::goldenRatio,
+        multiTapDelay::Pattern::dotted, multiTapDelay::Pattern::random);
+    const int numTaps = GENERATE (1, 4, 16);
+    taps.setPattern (pattern, numTaps, 42);
+
+    REQUIRE (taps.getNumTaps() == numTaps);
+
+    float power = 0.0f;
+    for (int k = 0; k < numTaps; ++k)
+    {
+        const auto& tap = taps.getTap (k);
+        CHECK (tap.time > 0.0f);
+        CHECK (tap.time <= 1.0f);
+        CHECK (tap.pan >= -1.0f);
+        CHECK (tap.pan <= 1.0f);
+        if (k > 0)
+            CHECK (tap.time > taps.getTap (k - 1).time);
+        power += tap.gain * tap.gain;
+    }
+
+    // the last tap lands on the delay size, and together they are no louder than one tap
+    CHECK (taps.getTap (numTaps - 1).time == 1.0f);
+    CHECK (power <= 1.0f + 1.0e-5f);
+}
+
+TEST_CASE ("taps read the shared delay line", "[multitap]")
+{
+    constexpr int blockSize = 256;
+    constexpr float delaySize = 2000.0f;
+
+    delayLine line;
+    line.prepare (2, 4096, blockSize);
+
+    multiTapDelay taps;
+    taps.prepare (48000.0, 2, blockSize, 0.25);
+    taps.setNumTaps (3);
+    taps.setTap (0, { 0.25f, 1.0f, -1.0f, 0.0f });
+    taps.setTap (1, { 0.5f, 0.5f, 0.0f, 0.0f });
+    taps.setTap (2, { 1.0f, 0.25f, 1.0f, 0.0f });
+    taps.reset();
+
+    // one impulse on both channels, then the taps rendered block by block
+    std::vector<float> delays (blockSize, delaySize);
+    juce::AudioBuffer<float> output (2, 2560);
+    output.clear();
+    juce::AudioBuffer<float> wet (2, blockSize);
+
+    for (int start = 0; start < output.getNumSamples(); start += blockSize)
+    {
+        wet.clear();
+        taps.process (line, 0, delays.data(), blockSize, delayLine::Interpolation::linear, wet.getArrayOfWritePointers(), 2);
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            output.copyFrom (ch, start, wet, ch, 0, blockSize);
+            for (int i = 0; i < blockSize; ++i)
+                line.write (ch, i, start + i == 0 ? 1.0f : 0.0f);
+        }
+        line.advance (blockSize);
+    }
+
+    // hard left, centre and hard right
+    CHECK (output.getSample (0, 500) == 1.0f);
+    CHECK (output.getSample (1, 500) == 0.0f);
+    CHECK (output.getSample (0, 1000) == 0.5f);
+    CHECK (output.getSample (1, 1000) == 0.5f);
+    CHECK (output.getSample (0, 2000) == 0.0f);
+    CHECK (output.getSample (1, 2000) == 0.25f);
+
+    // and nothing anywhere else
+    float total = 0.0f;
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < output.getNumSamples(); ++i)
+            total += std::abs (output.getSample (ch, i));
+    CHECK (total == 2.25f);
+}
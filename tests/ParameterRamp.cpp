@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <parameterRamp.h>
+#include <vector>
+
+TEST_CASE ("parameter ramp", "[ramp]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr double rampSeconds = 0.01;
+
+    parameterRamp ramp;
+    ramp.reset (sampleRate, rampSeconds);
+    ramp.setCurrentAndTargetValue (0.2f);
+
+    SECTION ("follows juce's linear smoother and lands on the target")
+    {
+        juce::SmoothedValue<float> reference (0.2f);
+        reference.reset (sampleRate, rampSeconds);
+        reference.setTargetValue (0.9f);
+        ramp.setTargetValue (0.9f);
+        CHECK (ramp.isSmoothing());
+
+        // juce adds the step up sample by sample, the ramp multiplies it out, so within rounding
+        std::vector<float> values (1000);
+        ramp.fill (values.data(), 1000);
+        float maxError = 0.0f;
+        for (float value : values)
+            maxError = juce::jmax (maxError, std::abs (value - reference.getNextValue()));
+        CHECK (maxError < 1.0e-5f);
+
+        CHECK (values[479] == 0.9f);
+        CHECK (values.back() == 0.9f);
+        CHECK_FALSE (ramp.isSmoothing());
+    }
+
+    SECTION ("the same values however the blocks are split")
+    {
+        ramp.setTargetValue (-0.5f);
+        std::vector<float> whole (700);
+        ramp.fill (whole.data(), 700);
+
+        parameterRamp split;
+        split.reset (sampleRate, rampSeconds);
+        split.setCurrentAndTargetValue (0.2f);
+        split.setTargetValue (-0.5f);
+
+        const int blockSize = GENERATE (1, 7, 64, 333);
+        std::vector<float> pieces (700);
+        for (int start = 0; start < 700; start += blockSize)
+            split.fill (pieces.data() + start, juce::jmin (blockSize, 700 - start));
+        CHECK (pieces == whole);
+    }
+
+    SECTION ("skipping moves on like filling")
+    {
+        ramp.setTargetValue (1.0f);
+        parameterRamp filled = ramp;
+        std::vector<float> values (100);
+        filled.fill (values.data(), 100);
+
+        CHECK (ramp.skip (100) == values.back());
+        CHECK (ramp.getCurrentValue() == filled.getCurrentValue());
+        CHECK (ramp.skip (1000) == 1.0f);
+    }
+
+    SECTION ("a new target ramps on from where the last ramp had got to")
+    {
+        ramp.setTargetValue (1.0f);
+        auto halfway = ramp.skip (240);
+        ramp.setTargetValue (0.0f);
+        CHECK (ramp.getCurrentValue() == halfway);
+
+        float values[2];
+        ramp.fill (values, 2);
+        CHECK (values[0] < halfway);
+        CHECK (values[1] < values[0]);
+    }
+
+    SECTION ("settled, a block is the value")
+    {
+        float values[16];
+        ramp.fill (values, 16);
+        for (float value : values)
+            CHECK (value == 0.2f);
+        CHECK_FALSE (ramp.isSmoothing());
+    }
+}
@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+#include <parameterSnapshot.h>
+
+TEST_CASE ("parameter snapshot", "[parameters]")
+{
+    std::atomic<float> feedback { 0.5f }, wetDry { 0.3f }, seed { 1.0f };
+    parameterSnapshot parameters;
+    parameters.bind (0, &feedback);
+    parameters.bind (1, &wetDry);
+    parameters.bind (5, &seed);
+
+    // the first block passes everything on
+    parameters.capture();
+    CHECK (parameters.changed (0, 1, 5));
+    CHECK (parameters.changed (0));
+    CHECK (parameters.changed (5));
+    CHECK (parameters.get (1) == 0.3f);
+
+    SECTION ("nothing moved, nothing changed")
+    {
+        parameters.capture();
+        CHECK_FALSE (parameters.anyChanged());
+        CHECK_FALSE (parameters.changed (0, 1, 5));
+        CHECK (parameters.get (0) == 0.5f);
+    }
+
+    SECTION ("only what moved")
+    {
+        wetDry = 0.8f;
+        parameters.capture();
+        CHECK (parameters.changed (1));
+        CHECK (parameters.changed (0, 1));
+        CHECK_FALSE (parameters.changed (0));
+        CHECK_FALSE (parameters.changed (0, 5));
+        CHECK (parameters.get (1) == 0.8f);
+
+        // the value is held until the next capture
+        wetDry = 0.1f;
+        CHECK (parameters.get (1) == 0.8f);
+    }
+
+    SECTION ("invalidated, everything again")
+    {
+        parameters.invalidate();
+        parameters.capture();
+        CHECK (parameters.changed (0));
+        CHECK (parameters.changed (1));
+        CHECK (parameters.changed (5));
+
+        parameters.capture();
+        CHECK_FALSE (parameters.anyChanged());
+    }
+}
@@ -1,5 +1,6 @@
 #include "helpers/test_helpers.h"
 #include <PluginProcessor.h>
+#include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 
@@ -19,6 +20,23 @@ TEST_CASE ("Plugin instance", "[instance]")
     }
 }
 
+TEST_CASE ("tail length is right before the first block", "[instance]")
+{
+    PluginProcessor plugin;
+    setParameter (plugin, "feedback", 0.0f);
+    auto echoesOnly = plugin.getTailLengthSeconds();
+
+    // the reverb's decay comes on top as soon as it's mixed in, nothing has been processed yet
+    setParameter (plugin, "reverbMix", 0.5f);
+    setParameter (plugin, "reverbDecay", 6.0f);
+    CHECK (plugin.getTailLengthSeconds() == Catch::Approx (echoesOnly + 6.0).margin (0.01));
+
+    // and a frozen spectrum never stops. not std::isinf, release builds use fast math
+    setParameter (plugin, "spectralMode", 1.0f);
+    setParameter (plugin, "spectralFreeze", 1.0f);
+    CHECK (plugin.getTailLengthSeconds() > 1.0e9);
+}
+
 
 #ifdef PAMPLEJUCE_IPP
     #include <ipp.h>
@@ -0,0 +1,163 @@
+#include "helpers/realtime_guard.h"
+#include "helpers/test_helpers.h"
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+
+template <typename SampleType>
+static void fillWithNoise (juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+{
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        auto* data = buffer.getWritePointer (ch);
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            data[i] = static_cast<SampleType> (random.nextFloat() * 2.0f - 1.0f);
+    }
+}
+
+// runs blocks through processBlock with the allocator/lock hooks armed,
+// parameter changes happen between blocks the way a host would make them
+template <typename SampleType = float>
+static realtime_guard::Counts runBlocks (PluginProcessor& plugin, int blockSize, int numBlocks, bool automate)
+{
+    juce::AudioBuffer<SampleType> buffer (2, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random (1234);
+    realtime_guard::Counts counts;
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        fillWithNoise (buffer, random);
+
+        if (automate)
+        {
+            setParameter (plugin, "delaySize", 0.01f + random.nextFloat() * 2.0f);
+            setParameter (plugin, "feedback", random.nextFloat());
+            setParameter (plugin, "grainDensity", 1.0f + random.nextFloat() * 49.0f);
+            setParameter (plugin, "grainSize", 10.0f + random.nextFloat() * 490.0f);
+        }
+
+        realtime_guard::ScopedRealtimeSection section (counts);
+        plugin.processBlock (buffer, midi);
+    }
+
+    return counts;
+}
+
+TEST_CASE ("processBlock is realtime safe", "[realtime]")
+{
+    if (!realtime_guard::isEnabled())
+        SKIP ("built without ECHOES_REALTIME_CHECKS");
+
+    PluginProcessor plugin;
+    const int blockSize = GENERATE (16, 64, 512);
+    plugin.setRateAndBufferSizeDetails (48000.0, blockSize);
+    plugin.prepareToPlay (48000.0, blockSize);
+
+    SECTION ("standard delay")
+    {
+        setParameter (plugin, "granularMode", 0.0f);
+        auto counts = runBlocks (plugin, blockSize, 200, false);
+        CHECK (counts.allocations == 0);
+        CHECK (counts.deallocations == 0);
+        CHECK (counts.locks == 0);
+    }
+
+    SECTION ("granular delay")
+    {
+        setParameter (plugin, "granularMode", 1.0f);
+        setParameter (plugin, "grainDensity", 50.0f);
+        auto counts = runBlocks (plugin, blockSize, 200, false);
+        CHECK (counts.allocations == 0);
+        CHECK (counts.deallocations == 0);
+        CHECK (counts.locks == 0);
+    }
+
+    SECTION ("granular delay on worker threads")
+    {
+        // the workers start in prepareToPlay, and a dense cloud of long grains wakes them
+        setParameter (plugin, "granularMode", 1.0f);
+        setParameter (plugin, "grainDensity", grainProcessor::maxGrainDensityHz);
+        setParameter (plugin, "grainSize", grainProcessor::maxGrainSizeMs);
+        setParameter (plugin, "parallelGrains", 1.0f);
+        plugin.prepareToPlay (48000.0, blockSize);
+        CHECK (plugin.getNumGrainWorkers() == juce::jlimit (0, grainProcessor::maxGrainWorkers, juce::SystemStats::getNumCpus() - 1));
+
+        // a second, long enough for the cloud to fill up
+        auto counts = runBlocks (plugin, blockSize, 48000 / blockSize, false);
+        CHECK (counts.isClean());
+    }
+
+    SECTION ("automated parameters in both modes")
+    {
+        setParameter (plugin, "granularMode", 0.0f);
+        auto standardCounts = runBlocks (plugin, blockSize, 100, true);
+        setParameter (plugin, "granularMode", 1.0f);
+        auto granularCounts = runBlocks (plugin, blockSize, 100, true);
+        CHECK (standardCounts.isClean());
+        CHECK (granularCounts.isClean());
+    }
+
+    SECTION ("shaped feedback at every quality")
+    {
+        setParameter (plugin, "granularMode", 0.0f);
+        setParameter (plugin, "feedbackDrive", 0.8f);
+        setParameter (plugin, "feedbackHighCut", 3000.0f);
+        for (int quality = 0; quality < 3; ++quality)
+        {
+            setParameter (plugin, "quality", static_cast<float> (quality));
+            auto counts = runBlocks (plugin, blockSize, 25, true);
+            CHECK (counts.isClean());
+        }
+    }
+
+    SECTION ("multi-tap pattern changes")
+    {
+        setParameter (plugin, "granularMode", 0.0f);
+        setParameter (plugin, "multiTap", 1.0f);
+        for (int pattern = 0; pattern < 4; ++pattern)
+        {
+            setParameter (plugin, "tapPattern", static_cast<float> (pattern));
+            setParameter (plugin, "tapCount", static_cast<float> (16 - 4 * pattern));
+            auto counts = runBlocks (plugin, blockSize, 25, true);
+            CHECK (counts.isClean());
+        }
+    }
+
+    SECTION ("spectral mode, frozen and smeared")
+    {
+        setParameter (plugin, "spectralMode", 1.0f);
+        setParameter (plugin, "spectralSmear", 0.5f);
+        auto counts = runBlocks (plugin, blockSize, 25, true);
+        setParameter (plugin, "spectralFreeze", 1.0f);
+        auto frozenCounts = runBlocks (plugin, blockSize, 25, true);
+        CHECK (counts.isClean());
+        CHECK (frozenCounts.isClean());
+    }
+
+    SECTION ("double precision in every mode")
+    {
+        plugin.releaseResources();
+        plugin.setProcessingPrecision (juce::AudioProcessor::doublePrecision);
+        plugin.prepareToPlay (48000.0, blockSize);
+        setParameter (plugin, "feedbackDrive", 0.5f);
+        setParameter (plugin, "reverbMix", 0.3f);
+
+        auto standardCounts = runBlocks<double> (plugin, blockSize, 25, true);
+        setParameter (plugin, "multiTap", 1.0f);
+        auto multiTapCounts = runBlocks<double> (plugin, blockSize, 25, true);
+        setParameter (plugin, "granularMode", 1.0f);
+        auto granularCounts = runBlocks<double> (plugin, blockSize, 25, true);
+        setParameter (plugin, "spectralMode", 1.0f);
+        auto spectralCounts = runBlocks<double> (plugin, blockSize, 25, true);
+        CHECK (standardCounts.isClean());
+        CHECK (multiTapCounts.isClean());
+        CHECK (granularCounts.isClean());
+        CHECK (spectralCounts.isClean());
+    }
+
+    SECTION ("host block bigger than announced")
+    {
+        auto counts = runBlocks (plugin, blockSize * 3 + 7, 20, false);
+        CHECK (counts.isClean());
+    }
+}
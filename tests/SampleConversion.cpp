@@ -0,0 +1,55 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sampleConversion.h>
+
+TEST_CASE ("block conversions match the single sample ones", "[delay][simd]")
+{
+    // odd length for the scalar tails, values across the whole range the delay line sees,
+    // including half denormals, and past both formats' limits
+    std::vector<float> source;
+    juce::Random random (11);
+    for (int i = 0; i < 1001; ++i)
+    {
+        auto magnitude = std::pow (2.0f, random.nextFloat() * 40.0f - 30.0f);
+        source.push_back (random.nextBool() ? magnitude : -magnitude);
+    }
+    source.insert (source.end(), { 0.0f, -0.0f, 1.0f, -1.0f, 8.0f, -8.0f, 100.0f, 70000.0f, 3.0e-8f });
+
+    auto numSamples = static_cast<int> (source.size());
+
+    SECTION ("int16")
+    {
+        std::vector<int16_t> packed (source.size());
+        std::vector<float> decoded (source.size());
+        sampleConversion::toInt16 (source.data(), packed.data(), numSamples);
+        sampleConversion::fromInt16 (packed.data(), decoded.data(), numSamples);
+
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            CHECK (packed[i] == sampleConversion::toInt16 (source[i]));
+            CHECK (decoded[i] == sampleConversion::fromInt16 (packed[i]));
+        }
+
+        // anything past full scale clips rather than wrapping
+        CHECK (sampleConversion::toInt16 (100.0f) == 32767);
+        CHECK (sampleConversion::toInt16 (-100.0f) == -32767);
+    }
+
+    SECTION ("half")
+    {
+        std::vector<uint16_t> packed (source.size());
+        std::vector<float> decoded (source.size());
+        sampleConversion::toHalf (source.data(), packed.data(), numSamples);
+        sampleConversion::fromHalf (packed.data(), decoded.data(), numSamples);
+
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            CHECK (packed[i] == sampleConversion::toHalf (source[i]));
+            CHECK (decoded[i] == sampleConversion::fromHalf (packed[i]));
+        }
+
+        CHECK (sampleConversion::toHalf (1.0f) == 0x3c00);
+        CHECK (sampleConversion::toHalf (-2.0f) == 0xc000);
+        CHECK (sampleConversion::toHalf (70000.0f) == 0x7c00);
+        CHECK (sampleConversion::fromHalf (0x0001) == std::ldexp (1.0f, -24));
+    }
+}
@@ -0,0 +1,141 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <spectralProcessor.h>
+
+static constexpr double sampleRate = 48000.0;
+
+// runs the input through in blocks, returns the output
+static juce::AudioBuffer<float> render (spectralProcessor& spectral, const juce::AudioBuffer<float>& input, int blockSize,
+    float delaySeconds, float feedback, float wetDry)
+{
+    juce::AudioBuffer<float> output (input);
+    for (int start = 0; start < output.getNumSamples(); start += blockSize)
+    {
+        juce::AudioBuffer<float> block (output.getArrayOfWritePointers(), output.getNumChannels(), start,
+            juce::jmin (blockSize, output.getNumSamples() - start));
+        spectral.process (block, delaySeconds, feedback, wetDry);
+    }
+    return output;
+}
+
+static float getRms (const juce::AudioBuffer<float>& buffer, int start, int length)
+{
+    return buffer.getRMSLevel (0, start, length);
+}
+
+static juce::AudioBuffer<float> makeSine (int length, int burstLength, float frequency)
+{
+    juce::AudioBuffer<float> buffer (2, length);
+    buffer.clear();
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < burstLength; ++i)
+            buffer.setSample (ch, i, 0.5f * std::sin (juce::MathConstants<float>::twoPi * frequency * static_cast<float> (i / sampleRate)));
+    return buffer;
+}
+
+TEST_CASE ("spectral dry path", "[spectral]")
+{
+    spectralProcessor spectral;
+    spectral.prepare (sampleRate, 2, 512, 2.0f);
+
+    juce::AudioBuffer<float> input (2, 8192);
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < input.getNumSamples(); ++i)
+            input.setSample (ch, i, std::sin (0.01f * static_cast<float> (i * (ch + 1))));
+
+    // all dry, delayed by the latency so it lines up with the wet signal
+    auto output = render (spectral, input, 300, 0.5f, 0.0f, 0.0f);
+    constexpr int latency = spectralProcessor::getLatencySamples();
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int i = 0; i < latency; ++i)
+            REQUIRE (output.getSample (ch, i) == 0.0f);
+        for (int i = latency; i < input.getNumSamples(); ++i)
+            REQUIRE (output.getSample (ch, i) == input.getSample (ch, i - latency));
+    }
+}
+
+TEST_CASE ("spectral echoes", "[spectral]")
+{
+    spectralProcessor spectral;
+    spectral.prepare (sampleRate, 2, 512, 2.0f);
+
+    constexpr int latency = spectralProcessor::getLatencySamples();
+    constexpr int hop = spectralProcessor::hopSize;
+    constexpr int echoDelay = 48 * hop;
+    constexpr float delaySeconds = static_cast<float> (echoDelay / sampleRate);
+    constexpr int burst = 4800;
+
+    SECTION ("a burst comes back one delay size later, and once without feedback")
+    {
+        auto output = render (spectral, makeSine (96000, burst, 440.0f), 256, delaySeconds, 0.0f, 1.0f);
+
+        // the window smears the edges by up to a frame. only the magnitudes come back, the
+        // bins' phases run on freely and beat against each other, so the level isn't exact
+        constexpr int frame = spectralProcessor::frameSize;
+        auto echo = getRms (output, latency + echoDelay + frame, burst - frame);
+        CHECK (echo > 0.1f);
+        CHECK (echo < 0.5f);
+        CHECK (getRms (output, 0, latency + echoDelay - frame) < 1.0e-4f);
+        CHECK (getRms (output, latency + 2 * echoDelay - frame, burst + 2 * frame) < 1.0e-4f);
+    }
+
+    SECTION ("feedback brings it round again, a little quieter")
+    {
+        auto output = render (spectral, makeSine (96000, burst, 440.0f), 256, delaySeconds, 0.7f, 1.0f);
+        constexpr int frame = spectralProcessor::frameSize;
+        auto first = getRms (output, latency + echoDelay + frame, burst - frame);
+        auto second = getRms (output, latency + 2 * echoDelay + frame, burst - frame);
+        CHECK (second > 0.5f * first);
+        CHECK (second < 0.9f * first);
+    }
+
+    SECTION ("freeze holds the spectrum after the input stops")
+    {
+        spectral.setFreeze (false);
+        auto input = makeSine (48000, 48000, 440.0f);
+        render (spectral, input, 256, delaySeconds, 0.0f, 1.0f);
+
+        spectral.setFreeze (true);
+        input.clear();
+        auto output = render (spectral, input, 256, delaySeconds, 0.0f, 1.0f);
+        CHECK (spectral.isRinging());
+        CHECK (getRms (output, 24000, 24000) > 0.2f);
+
+        spectral.setFreeze (false);
+        output = render (spectral, input, 256, delaySeconds, 0.0f, 1.0f);
+        CHECK (getRms (output, 24000, 24000) < 1.0e-4f);
+        CHECK_FALSE (spectral.isRinging());
+    }
+
+    SECTION ("smear spreads a burst over the frames after it")
+    {
+        spectral.setSmear (0.9f);
+        spectral.reset();
+        auto output = render (spectral, makeSine (96000, burst, 440.0f), 256, delaySeconds, 0.0f, 1.0f);
+        constexpr int frame = spectralProcessor::frameSize;
+        CHECK (getRms (output, latency + echoDelay + burst + frame, 4 * hop) > 0.05f);
+    }
+}
+
+TEST_CASE ("spectral output doesn't depend on the block size", "[spectral]")
+{
+    const int blockSize = GENERATE (1, 37, 512, 1500);
+
+    auto input = makeSine (24000, 12000, 1000.0f);
+    spectralProcessor reference;
+    reference.prepare (sampleRate, 2, 2048, 1.0f);
+    reference.setSmear (0.5f);
+    reference.reset();
+    auto expected = render (reference, input, 64, 0.1f, 0.5f, 0.5f);
+
+    spectralProcessor spectral;
+    spectral.prepare (sampleRate, 2, 2048, 1.0f);
+    spectral.setSmear (0.5f);
+    spectral.reset();
+    auto output = render (spectral, input, blockSize, 0.1f, 0.5f, 0.5f);
+
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < input.getNumSamples(); ++i)
+            REQUIRE (output.getSample (ch, i) == expected.getSample (ch, i));
+}
@@ -0,0 +1,188 @@
+#include "realtime_guard.h"
+#include <cstdlib>
+#include <new>
+
+#if ECHOES_REALTIME_CHECKS
+    // glibc lets us wrap the allocator itself, which also catches juce::HeapBlock
+    // (AudioBuffer storage) since that goes straight to malloc
+    #if defined(__linux__) && defined(__GLIBC__)
+        #define ECHOES_HOOK_LIBC 1
+        #include <dlfcn.h>
+        #include <pthread.h>
+    #else
+        #define ECHOES_HOOK_LIBC 0
+    #endif
+#endif
+
+namespace realtime_guard
+{
+    // constant initialised, so it's safe to touch from inside the allocator
+    static thread_local Counts* current = nullptr;
+
+    [[maybe_unused]] static void noteAllocation()
+    {
+        if (current != nullptr)
+            ++current->allocations;
+    }
+
+    [[maybe_unused]] static void noteDeallocation (const void* ptr)
+    {
+        if (current != nullptr && ptr != nullptr)
+            ++current->deallocations;
+    }
+
+    [[maybe_unused]] static void noteLock()
+    {
+        if (current != nullptr)
+            ++current->locks;
+    }
+
+    bool isEnabled()
+    {
+#if ECHOES_REALTIME_CHECKS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool canDetectLocks()
+    {
+#if ECHOES_REALTIME_CHECKS && ECHOES_HOOK_LIBC
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    ScopedRealtimeSection::ScopedRealtimeSection (Counts& countsToFill)
+        : previous (current)
+    {
+        current = &countsToFill;
+    }
+
+    ScopedRealtimeSection::~ScopedRealtimeSection()
+    {
+        current = previous;
+    }
+}
+
+#if ECHOES_REALTIME_CHECKS && ECHOES_HOOK_LIBC
+
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size)
+    {
+        realtime_guard::noteAllocation();
+        return __libc_malloc (size);
+    }
+
+    void* calloc (size_t count, size_t size)
+    {
+        realtime_guard::noteAllocation();
+        return __libc_calloc (count, size);
+    }
+
+    void* realloc (void* ptr, size_t size)
+    {
+        realtime_guard::noteAllocation();
+        return __libc_realloc (ptr, size);
+    }
+
+    void free (void* ptr)
+    {
+        realtime_guard::noteDeallocation (ptr);
+        __libc_free (ptr);
+    }
+
+    // glibc's own locking (dlsym included) never goes through this symbol,
+    // so resolving the real one lazily can't recurse
+    int pthread_mutex_lock (pthread_mutex_t* mutex)
+    {
+        using LockFunction = int (*) (pthread_mutex_t*);
+        static const auto realLock = reinterpret_cast<LockFunction> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+
+        realtime_guard::noteLock();
+        return realLock (mutex);
+    }
+}
+
+#elif ECHOES_REALTIME_CHECKS
+
+// everywhere else we can only see what goes through operator new/delete
+static void* allocateOrNull (std::size_t size)
+{
+    realtime_guard::noteAllocation();
+    return std::malloc (size == 0 ? 1 : size);
+}
+
+static void* allocateAlignedOrNull (std::size_t size, std::align_val_t alignment)
+{
+    realtime_guard::noteAllocation();
+    size = size == 0 ? 1 : size;
+    #if defined(_MSC_VER)
+    return _aligned_malloc (size, static_cast<std::size_t> (alignment));
+    #else
+    void* ptr = nullptr;
+    return posix_memalign (&ptr, static_cast<std::size_t> (alignment), size) == 0 ? ptr : nullptr;
+    #endif
+}
+
+static void release (void* ptr) noexcept
+{
+    realtime_guard::noteDeallocation (ptr);
+    std::free (ptr);
+}
+
+static void releaseAligned (void* ptr) noexcept
+{
+    realtime_guard::noteDeallocation (ptr);
+    #if defined(_MSC_VER)
+    _aligned_free (ptr);
+    #else
+    std::free (ptr);
+    #endif
+}
+
+static void* allocate (std::size_t size)
+{
+    if (auto* ptr = allocateOrNull (size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+static void* allocateAligned (std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAlignedOrNull (size, alignment))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size) { return allocate (size); }
+void* operator new[] (std::size_t size) { return allocate (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept { return allocateOrNull (size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { return allocateOrNull (size); }
+void* operator new (std::size_t size, std::align_val_t alignment) { return allocateAligned (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment) { return allocateAligned (size, alignment); }
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAlignedOrNull (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAlignedOrNull (size, alignment); }
+
+void operator delete (void* ptr) noexcept { release (ptr); }
+void operator delete[] (void* ptr) noexcept { release (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept { release (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { release (ptr); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept { release (ptr); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept { release (ptr); }
+void operator delete (void* ptr, std::align_val_t) noexcept { releaseAligned (ptr); }
+void operator delete[] (void* ptr, std::align_val_t) noexcept { releaseAligned (ptr); }
+void operator delete (void* ptr, std::size_t, std::align_val_t) noexcept { releaseAligned (ptr); }
+void operator delete[] (void* ptr, std::size_t, std::align_val_t) noexcept { releaseAligned (ptr); }
+void operator delete (void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned (ptr); }
+void operator delete[] (void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned (ptr); }
+
+#endif
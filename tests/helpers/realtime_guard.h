@@ -0,0 +1,50 @@
+#pragma once
+
+/* Realtime safety checks for the audio thread.
+ *
+ * When the Tests target is built with ECHOES_REALTIME_CHECKS=1 (the default, see
+ * the ECHOES_REALTIME_CHECKS option in CMakeLists.txt), realtime_guard.cpp replaces
+ * the global operator new/delete and, on Linux, pthread_mutex_lock. While a
+ * ScopedRealtimeSection is alive on a thread, every allocation, free and lock on
+ * that thread is counted. Other threads are never affected.
+ *
+ * Example usage
+ *
+  realtime_guard::Counts counts;
+  {
+      realtime_guard::ScopedRealtimeSection section (counts);
+      plugin.processBlock (buffer, midi);
+  }
+  REQUIRE (counts.allocations == 0);
+
+ */
+namespace realtime_guard
+{
+    struct Counts
+    {
+        int allocations = 0;
+        int deallocations = 0;
+        int locks = 0;
+
+        [[nodiscard]] bool isClean() const { return allocations == 0 && deallocations == 0 && locks == 0; }
+    };
+
+    // true when the hooks are compiled in
+    bool isEnabled();
+
+    // true when pthread_mutex_lock is hooked as well (Linux only)
+    bool canDetectLocks();
+
+    class ScopedRealtimeSection
+    {
+    public:
+        explicit ScopedRealtimeSection (Counts& countsToFill);
+        ~ScopedRealtimeSection();
+
+        ScopedRealtimeSection (const ScopedRealtimeSection&) = delete;
+        ScopedRealtimeSection& operator= (const ScopedRealtimeSection&) = delete;
+
+    private:
+        Counts* previous;
+    };
+}
@@ -29,3 +29,10 @@
     plugin.editorBeingDeleted (editor);
     delete editor;
 }
+
+// sets a parameter in its real units, the way a host automation lane would
+[[maybe_unused]] static void setParameter (PluginProcessor& plugin, const juce::String& id, float value)
+{
+    auto* param = plugin.apvts.getParameter (id);
+    param->setValueNotifyingHost (param->convertTo0to1 (value));
+}